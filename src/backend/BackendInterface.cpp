@@ -20,6 +20,7 @@
 #include <ripple/protocol/Indexes.h>
 #include <ripple/protocol/STLedgerEntry.h>
 #include <backend/BackendInterface.h>
+#include <backend/DirectoryPrefetcher.h>
 #include <log/Logger.h>
 
 using namespace clio;
@@ -86,12 +87,25 @@ BackendInterface::fetchLedgerObject(
     if (obj)
     {
         gLog.trace() << "Cache hit - " << ripple::strHex(key);
+        if (auto* meter = ScopedReadMeter::find(yield))
+            ++meter->cacheHits;
         return *obj;
     }
     else
     {
         // gLog.trace() << "Cache miss - " << ripple::strHex(key);
-        auto dbObj = doFetchLedgerObject(key, sequence, yield);
+        auto dbObj = coalesceReads_
+            ? coalescer_.fetch(
+                  key,
+                  sequence,
+                  yield,
+                  [this](auto const& k, auto seq, auto& y) {
+                      return doFetchLedgerObject(k, seq, y);
+                  },
+                  [this](auto const& k, auto seq, auto& y) {
+                      return doFetchLedgerObjects(k, seq, y);
+                  })
+            : doFetchLedgerObject(key, sequence, yield);
         if (!dbObj)
             gLog.trace() << "Missed cache and missed in db";
         else
@@ -119,10 +133,20 @@ BackendInterface::fetchLedgerObjects(
     }
     // gLog.trace() << "Cache hits = " << keys.size() - misses.size()
     //              << " - cache misses = " << misses.size();
+    if (auto* meter = ScopedReadMeter::find(yield))
+        meter->cacheHits += keys.size() - misses.size();
 
     if (misses.size())
     {
-        auto objs = doFetchLedgerObjects(misses, sequence, yield);
+        auto objs = coalesceReads_
+            ? coalescer_.fetch(
+                  misses,
+                  sequence,
+                  yield,
+                  [this](auto const& k, auto seq, auto& y) {
+                      return doFetchLedgerObjects(k, seq, y);
+                  })
+            : doFetchLedgerObjects(misses, sequence, yield);
         for (size_t i = 0, j = 0; i < results.size(); ++i)
         {
             if (results[i].size() == 0)
@@ -144,7 +168,11 @@ BackendInterface::fetchSuccessorKey(
 {
     auto succ = cache_.getSuccessor(key, ledgerSequence);
     if (succ)
+    {
         gLog.trace() << "Cache hit - " << ripple::strHex(key);
+        if (auto* meter = ScopedReadMeter::find(yield))
+            ++meter->cacheHits;
+    }
     // else
     // gLog.trace() << "Cache miss - " << ripple::strHex(key);
     return succ ? succ->key : doFetchSuccessorKey(key, ledgerSequence, yield);
@@ -194,38 +222,39 @@ BackendInterface::fetchBookOffers(
     while (keys.size() < limit)
     {
         auto mid1 = std::chrono::system_clock::now();
-        auto offerDir = fetchSuccessorObject(uTipIndex, ledgerSequence, yield);
+        auto offerDir = fetchSuccessorKey(uTipIndex, ledgerSequence, yield);
         auto mid2 = std::chrono::system_clock::now();
         numSucc++;
         succMillis += getMillis(mid2 - mid1);
-        if (!offerDir || offerDir->key >= bookEnd)
+        if (!offerDir || *offerDir >= bookEnd)
         {
             gLog.trace() << "offerDir.has_value() " << offerDir.has_value()
                          << " breaking";
             break;
         }
-        uTipIndex = offerDir->key;
+        uTipIndex = *offerDir;
+        DirectoryPrefetcher pages{*this, uTipIndex, ledgerSequence};
+        std::uint64_t next = 0;
         while (keys.size() < limit)
         {
             ++numPages;
-            ripple::STLedgerEntry sle{
-                ripple::SerialIter{
-                    offerDir->blob.data(), offerDir->blob.size()},
-                offerDir->key};
-            auto indexes = sle.getFieldV256(ripple::sfIndexes);
+            auto sle = pages.fetchPage(next, limit - keys.size(), yield);
+            assert(sle);
+            if (!sle)
+            {
+                gLog.error() << "Missing directory page. root = "
+                             << ripple::strHex(uTipIndex) << " page = " << next
+                             << " ledgerSequence = " << ledgerSequence;
+                break;
+            }
+            auto indexes = sle->getFieldV256(ripple::sfIndexes);
             keys.insert(keys.end(), indexes.begin(), indexes.end());
-            auto next = sle.getFieldU64(ripple::sfIndexNext);
+            next = sle->getFieldU64(ripple::sfIndexNext);
             if (!next)
             {
                 gLog.trace() << "Next is empty. breaking";
                 break;
             }
-            auto nextKey = ripple::keylet::page(uTipIndex, next);
-            auto nextDir =
-                fetchLedgerObject(nextKey.key, ledgerSequence, yield);
-            assert(nextDir);
-            offerDir->blob = *nextDir;
-            offerDir->key = nextKey.key;
         }
         auto mid3 = std::chrono::system_clock::now();
         pageMillis += getMillis(mid3 - mid2);
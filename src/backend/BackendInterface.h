@@ -21,8 +21,12 @@
 
 #include <ripple/ledger/ReadView.h>
 #include <backend/DBHelpers.h>
+#include <backend/KeyIndex.h>
+#include <backend/ReadCoalescer.h>
+#include <backend/ReadMeter.h>
 #include <backend/SimpleCache.h>
 #include <backend/Types.h>
+#include <backend/WriteBatch.h>
 #include <config/Config.h>
 #include <log/Logger.h>
 
@@ -172,6 +176,14 @@ protected:
     mutable std::shared_mutex rngMtx_;
     std::optional<LedgerRange> range;
     SimpleCache cache_;
+    // keys of the most recent ledger, for successor maintenance by a writer
+    // without a cache
+    KeyIndex keyIndex_;
+    // merges concurrent reads of the same objects that miss the cache
+    mutable ReadCoalescer coalescer_;
+    bool coalesceReads_ = true;
+    // sizes of the batches transaction index rows are written in
+    WriteBatchStats writeBatches_;
 
     /**
      * @brief Public read methods
@@ -183,6 +195,7 @@ protected:
 
 public:
     BackendInterface(clio::Config const& config)
+        : coalesceReads_(config.valueOr<bool>("coalesce_reads", true))
     {
     }
     virtual ~BackendInterface()
@@ -211,6 +224,38 @@ public:
         return cache_;
     }
 
+    /**
+     * @brief Keys of the most recent ledger, without blobs
+     *
+     * Only loaded and maintained on a writer whose cache is disabled, so that
+     * it can compute successors without a cache. Disabled otherwise.
+     */
+    KeyIndex const&
+    keyIndex() const
+    {
+        return keyIndex_;
+    }
+
+    KeyIndex&
+    keyIndex()
+    {
+        return keyIndex_;
+    }
+
+    /*! @brief Stats of reads merged by the read coalescer. */
+    ReadCoalescer const&
+    coalescer() const
+    {
+        return coalescer_;
+    }
+
+    /*! @brief Distribution of the sizes of batched writes. */
+    WriteBatchStats const&
+    writeBatches() const
+    {
+        return writeBatches_;
+    }
+
     /*! @brief Fetches a specific ledger by sequence number. */
     virtual std::optional<ripple::LedgerInfo>
     fetchLedgerBySequence(
@@ -511,6 +556,29 @@ public:
     std::optional<LedgerRange>
     hardFetchLedgerRangeNoThrow(boost::asio::yield_context& yield) const;
 
+    /**
+     * @brief Fetches the first ledger whose transactions are served.
+     *
+     * Backfilled ledgers below the ledger range hold transactions but no
+     * ledger objects. They stay out of the ledger range, and account_tx and
+     * nft_history serve them down to this ledger instead.
+     *
+     * @return The first ledger, or nothing if no backfill reached the range.
+     */
+    virtual std::optional<std::uint32_t>
+    fetchTransactionHistoryStart(boost::asio::yield_context& yield) const = 0;
+
+    /**
+     * @brief Records the first ledger whose transactions are served.
+     *
+     * Only written once every ledger from sequence up to the ledger range
+     * holds its transactions.
+     *
+     * @param sequence The first ledger.
+     */
+    virtual void
+    writeTransactionHistoryStart(std::uint32_t const sequence) = 0;
+
     /**
      * @brief Writes to a specific ledger.
      *
@@ -570,6 +638,21 @@ public:
     virtual void
     writeAccountTransactions(std::vector<AccountTransactionsData>&& data) = 0;
 
+    /**
+     * @brief Whether account transactions are stored together with the
+     * transaction and metadata blobs.
+     *
+     * When true, writers should populate AccountTransactionsData::inlineTx so
+     * that fetchAccountTransactions can serve a page with a single read.
+     *
+     * @return true if the backend wants the blobs passed along
+     */
+    virtual bool
+    storesAccountTxInline() const
+    {
+        return false;
+    }
+
     /**
      * @brief Write a new transaction for a specific NFT.
      *
@@ -595,6 +678,17 @@ public:
     virtual void
     startWrites() const = 0;
 
+    /*! @brief Blocks until all writes issued so far have completed, without
+     * committing a ledger. */
+    virtual void
+    sync() const = 0;
+
+    /*! @brief Blocks until the writes issued by the calling thread have
+     * completed. Unlike sync(), does not wait for the writes of other
+     * threads. */
+    virtual void
+    syncThreadWrites() const = 0;
+
     /**
      * @brief Tells database we finished writing all data for a specific ledger.
      *
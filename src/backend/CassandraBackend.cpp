@@ -90,13 +90,17 @@ struct WriteCallbackData
     std::uint32_t currentRetries;
     std::atomic<int> refs = 1;
     std::string id;
+    std::shared_ptr<CassandraBackend::ThreadWrites> writes;
 
     WriteCallbackData(
         CassandraBackend const* b,
         T&& d,
         B bind,
         std::string const& identifier)
-        : backend(b), data(std::move(d)), id(identifier)
+        : backend(b)
+        , data(std::move(d))
+        , id(identifier)
+        , writes(CassandraBackend::threadWrites())
     {
         retry = [bind, this](auto& params, bool isRetry) {
             auto statement = bind(params);
@@ -111,6 +115,7 @@ struct WriteCallbackData
     virtual void
     start()
     {
+        ++writes->outstanding;
         retry(*this, false);
     }
 
@@ -118,6 +123,7 @@ struct WriteCallbackData
     finish()
     {
         backend->finishAsyncWrite();
+        writes->finish();
         int remaining = --refs;
         if (remaining == 0)
             delete this;
@@ -199,6 +205,47 @@ makeAndExecuteBulkAsyncWrite(
     return cb;
 }
 
+// Write rows as unlogged batches, each holding rows of a single partition.
+// bind returns the statement writing one row. A row that ends up alone in its
+// batch is written as a plain statement
+template <class Row, class Partition, class Size, class B>
+void
+makeAndExecuteBatchedAsyncWrites(
+    CassandraBackend const* b,
+    std::vector<Row>&& rows,
+    Partition const& partition,
+    Size const& size,
+    B bind,
+    BatchLimits const& limits,
+    WriteBatchStats& stats,
+    std::string const& id)
+{
+    for (auto& batch : makeBatches(std::move(rows), partition, size, limits))
+    {
+        stats.record(batch.size());
+        if (batch.size() == 1)
+        {
+            makeAndExecuteAsyncWrite(
+                b,
+                std::move(batch.front()),
+                [bind](auto& params) { return bind(params.data); },
+                id);
+            continue;
+        }
+
+        makeAndExecuteAsyncWrite(
+            b,
+            std::move(batch),
+            [bind](auto& params) {
+                CassandraBatch statements;
+                for (auto const& row : params.data)
+                    statements.add(bind(row));
+                return statements;
+            },
+            id + "_batch");
+    }
+}
+
 void
 CassandraBackend::doWriteLedgerObject(
     std::string&& key,
@@ -293,52 +340,111 @@ void
 CassandraBackend::writeAccountTransactions(
     std::vector<AccountTransactionsData>&& data)
 {
+    using Row = std::
+        tuple<ripple::AccountID, std::uint32_t, std::uint32_t, ripple::uint256>;
+    using InlineRow = std::tuple<
+        ripple::AccountID,
+        std::uint32_t,
+        std::uint32_t,
+        ripple::uint256,
+        std::shared_ptr<TransactionAndMetadata const>>;
+
+    std::vector<Row> rows;
+    std::vector<InlineRow> inlineRows;
     for (auto& record : data)
     {
         for (auto& account : record.accounts)
         {
-            makeAndExecuteAsyncWrite(
-                this,
-                std::make_tuple(
-                    std::move(account),
-                    record.ledgerSequence,
-                    record.transactionIndex,
-                    record.txHash),
-                [this](auto& params) {
-                    CassandraStatement statement(insertAccountTx_);
-                    auto& [account, lgrSeq, txnIdx, hash] = params.data;
-                    statement.bindNextBytes(account);
-                    statement.bindNextIntTuple(lgrSeq, txnIdx);
-                    statement.bindNextBytes(hash);
-                    return statement;
-                },
-                "account_tx");
+            rows.emplace_back(
+                account,
+                record.ledgerSequence,
+                record.transactionIndex,
+                record.txHash);
+
+            if (accountTxInline_ == AccountTxInline::none || !record.inlineTx)
+                continue;
+
+            inlineRows.emplace_back(
+                account,
+                record.ledgerSequence,
+                record.transactionIndex,
+                record.txHash,
+                record.inlineTx);
         }
     }
+
+    // Rows of a ledger arrive in a single call, so batches are flushed before
+    // returning and no row waits longer than the ledger it belongs to
+    auto const byAccount = [](auto const& row) -> ripple::AccountID const& {
+        return std::get<0>(row);
+    };
+    makeAndExecuteBatchedAsyncWrites(
+        this,
+        std::move(rows),
+        byAccount,
+        [](Row const&) {
+            return ripple::AccountID::bytes + 8 + ripple::uint256::bytes;
+        },
+        [this](Row const& row) {
+            CassandraStatement statement(insertAccountTx_);
+            auto const& [account, lgrSeq, txnIdx, hash] = row;
+            statement.bindNextBytes(account);
+            statement.bindNextIntTuple(lgrSeq, txnIdx);
+            statement.bindNextBytes(hash);
+            return statement;
+        },
+        writeBatchLimits_,
+        writeBatches_,
+        "account_tx");
+
+    makeAndExecuteBatchedAsyncWrites(
+        this,
+        std::move(inlineRows),
+        byAccount,
+        [](InlineRow const& row) {
+            auto const& txn = std::get<4>(row);
+            return ripple::AccountID::bytes + 8 + ripple::uint256::bytes +
+                txn->transaction.size() + txn->metadata.size() + 4;
+        },
+        [this](InlineRow const& row) {
+            CassandraStatement statement(insertAccountTxInline_);
+            auto const& [account, lgrSeq, txnIdx, hash, txn] = row;
+            statement.bindNextBytes(account);
+            statement.bindNextIntTuple(lgrSeq, txnIdx);
+            statement.bindNextBytes(hash);
+            statement.bindNextBytes(txn->transaction);
+            statement.bindNextBytes(txn->metadata);
+            statement.bindNextInt(txn->date);
+            return statement;
+        },
+        writeBatchLimits_,
+        writeBatches_,
+        "account_tx_inline");
 }
 
 void
 CassandraBackend::writeNFTTransactions(std::vector<NFTTransactionsData>&& data)
 {
-    for (NFTTransactionsData const& record : data)
-    {
-        makeAndExecuteAsyncWrite(
-            this,
-            std::make_tuple(
-                record.tokenID,
-                record.ledgerSequence,
-                record.transactionIndex,
-                record.txHash),
-            [this](auto const& params) {
-                CassandraStatement statement(insertNFTTx_);
-                auto const& [tokenID, lgrSeq, txnIdx, txHash] = params.data;
-                statement.bindNextBytes(tokenID);
-                statement.bindNextIntTuple(lgrSeq, txnIdx);
-                statement.bindNextBytes(txHash);
-                return statement;
-            },
-            "nf_token_transactions");
-    }
+    makeAndExecuteBatchedAsyncWrites(
+        this,
+        std::move(data),
+        [](NFTTransactionsData const& record) -> ripple::uint256 const& {
+            return record.tokenID;
+        },
+        [](NFTTransactionsData const&) {
+            return 2 * ripple::uint256::bytes + 8;
+        },
+        [this](NFTTransactionsData const& record) {
+            CassandraStatement statement(insertNFTTx_);
+            statement.bindNextBytes(record.tokenID);
+            statement.bindNextIntTuple(
+                record.ledgerSequence, record.transactionIndex);
+            statement.bindNextBytes(record.txHash);
+            return statement;
+        },
+        writeBatchLimits_,
+        writeBatches_,
+        "nf_token_transactions");
 }
 
 void
@@ -469,6 +575,41 @@ CassandraBackend::hardFetchLedgerRange(boost::asio::yield_context& yield) const
     return range;
 }
 
+std::optional<std::uint32_t>
+CassandraBackend::fetchTransactionHistoryStart(
+    boost::asio::yield_context& yield) const
+{
+    // Every account_tx and nft_history request asks, but a backfill moves
+    // the start rarely. Look it up at most once a second
+    using namespace std::chrono;
+    auto const now = steady_clock::now().time_since_epoch().count();
+    auto last = txHistoryChecked_.load();
+    if (now - last >= duration_cast<steady_clock::duration>(1s).count() &&
+        txHistoryChecked_.compare_exchange_strong(last, now))
+    {
+        CassandraStatement statement{selectTxHistoryStart_};
+        CassandraResult result = executeAsyncRead(statement, yield);
+        if (result.hasResult())
+            txHistoryStart_ = result.getUInt32();
+    }
+
+    if (auto const start = txHistoryStart_.load(); start != 0)
+        return start;
+    return {};
+}
+
+void
+CassandraBackend::writeTransactionHistoryStart(std::uint32_t const sequence)
+{
+    // Backfill processes sharing a database read the start before writing
+    // it, so two finishing at once can leave the higher of their starts.
+    // That only hides history until either is run again
+    CassandraStatement statement{insertTxHistoryStart_};
+    statement.bindNextInt(sequence);
+    executeSyncWrite(statement);
+    txHistoryStart_ = sequence;
+}
+
 std::vector<TransactionAndMetadata>
 CassandraBackend::fetchAllTransactionsInLedger(
     std::uint32_t const ledgerSequence,
@@ -478,59 +619,160 @@ CassandraBackend::fetchAllTransactionsInLedger(
     return fetchTransactions(hashes, yield);
 }
 
-template <class Result>
-struct ReadCallbackData
+// Reads one row per key of a batch. At most window statements are in flight
+// at once; each completion issues the next statement, so a large batch does
+// not flood the driver's per-host request queues ahead of other readers.
+// The per-key slots are allocated once per batch and carry no std::function,
+// so the only per-key allocations are the driver's own.
+template <class Bind, class Read>
+class BatchRead
 {
-    using handler_type = typename Result::completion_handler_type;
-
-    std::atomic_int& numOutstanding;
-    handler_type handler;
-    std::function<void(CassandraResult&)> onSuccess;
-
-    std::atomic_bool errored = false;
-    ReadCallbackData(
-        std::atomic_int& numOutstanding,
-        handler_type& handler,
-        std::function<void(CassandraResult&)> onSuccess)
-        : numOutstanding(numOutstanding), handler(handler), onSuccess(onSuccess)
+    struct Slot
     {
+        BatchRead* batch;
+        std::size_t index;
+    };
+
+    CassSession* session_;
+    std::size_t const size_;
+    Bind bind_;
+    Read read_;
+    handler_type handler_;
+    std::vector<Slot> slots_;
+    std::atomic_size_t next_;
+    std::atomic_size_t outstanding_;
+    std::atomic_bool errored_ = false;
+
+public:
+    BatchRead(
+        CassSession* session,
+        std::size_t size,
+        Bind bind,
+        Read read,
+        handler_type& handler)
+        : session_(session)
+        , size_(size)
+        , bind_(std::move(bind))
+        , read_(std::move(read))
+        , handler_(handler)
+        , next_(0)
+        , outstanding_(size)
+    {
+        slots_.reserve(size_);
+        for (std::size_t i = 0; i < size_; ++i)
+            slots_.push_back({this, i});
     }
 
+    BatchRead(BatchRead const&) = delete;
+    BatchRead&
+    operator=(BatchRead const&) = delete;
+
+    // Issue the first window of statements. The handler is called once every
+    // key has completed
     void
-    finish(CassFuture* fut)
+    start(std::size_t window)
     {
-        CassError rc = cass_future_error_code(fut);
-        if (rc != CASS_OK)
+        auto const first = std::min(std::max<std::size_t>(window, 1), size_);
+        next_ = first;
+        for (std::size_t i = 0; i < first; ++i)
+            issue(i);
+    }
+
+    bool
+    errored() const
+    {
+        return errored_;
+    }
+
+private:
+    void
+    issue(std::size_t i)
+    {
+        CassandraStatement statement = bind_(i);
+        CassFuture* fut = cass_session_execute(session_, statement.get());
+        cass_future_set_callback(fut, &BatchRead::onComplete, &slots_[i]);
+        cass_future_free(fut);
+    }
+
+    static void
+    onComplete(CassFuture* fut, void* data)
+    {
+        auto& slot = *static_cast<Slot*>(data);
+        slot.batch->finish(slot.index, fut);
+    }
+
+    void
+    finish(std::size_t i, CassFuture* fut)
+    {
+        if (cass_future_error_code(fut) != CASS_OK)
         {
-            errored = true;
+            errored_ = true;
         }
         else
         {
             CassandraResult result{cass_future_get_result(fut)};
-            onSuccess(result);
+            read_(i, result);
         }
 
-        if (--numOutstanding == 0)
-            resume();
+        // keep the window full. Once a read failed the batch is going to
+        // throw anyway, so the remaining keys are skipped
+        for (auto next = next_++; next < size_; next = next_++)
+        {
+            if (!errored_)
+            {
+                issue(next);
+                break;
+            }
+            release();
+        }
+        release();
     }
 
     void
-    resume()
+    release()
     {
-        boost::asio::post(
-            boost::asio::get_associated_executor(handler),
-            [handler = std::move(handler)]() mutable {
-                handler(boost::system::error_code{});
-            });
+        if (--outstanding_ == 0)
+            boost::asio::post(
+                boost::asio::get_associated_executor(handler_),
+                [handler = std::move(handler_)]() mutable {
+                    handler(boost::system::error_code{});
+                });
     }
 };
 
-void
-processAsyncRead(CassFuture* fut, void* cbData)
+template <class Bind, class Read>
+bool
+CassandraBackend::executeBatchRead(
+    std::size_t size,
+    Bind&& bind,
+    Read&& read,
+    boost::asio::yield_context& yield) const
 {
-    ReadCallbackData<result_type>& cb =
-        *static_cast<ReadCallbackData<result_type>*>(cbData);
-    cb.finish(fut);
+    numReadRequestsOutstanding_ += size;
+
+    handler_type handler(std::forward<decltype(yield)>(yield));
+    result_type result(handler);
+
+    BatchRead<std::decay_t<Bind>, std::decay_t<Read>> batch{
+        session_.get(),
+        size,
+        std::forward<Bind>(bind),
+        std::forward<Read>(read),
+        handler};
+    batch.start(batchReadWindow_);
+
+    // suspend the coroutine until completion handler is called.
+    result.get();
+    numReadRequestsOutstanding_ -= size;
+
+    // each statement of a batch reads at most one row
+    if (auto* meter = ScopedReadMeter::find(yield))
+    {
+        meter->reads += size;
+        meter->rows += size;
+    }
+
+    return !batch.errored();
 }
 
 std::vector<TransactionAndMetadata>
@@ -540,47 +782,31 @@ CassandraBackend::fetchTransactions(
 {
     if (hashes.size() == 0)
         return {};
-    numReadRequestsOutstanding_ += hashes.size();
 
-    handler_type handler(std::forward<decltype(yield)>(yield));
-    result_type result(handler);
-
-    std::size_t const numHashes = hashes.size();
-    std::atomic_int numOutstanding = numHashes;
-    std::vector<TransactionAndMetadata> results{numHashes};
-    std::vector<std::shared_ptr<ReadCallbackData<result_type>>> cbs;
-    cbs.reserve(numHashes);
+    std::vector<TransactionAndMetadata> results{hashes.size()};
+    bool success = false;
     [[maybe_unused]] auto timeDiff = util::timed([&]() {
-        for (std::size_t i = 0; i < hashes.size(); ++i)
-        {
-            CassandraStatement statement{selectTransaction_};
-            statement.bindNextBytes(hashes[i]);
-
-            cbs.push_back(std::make_shared<ReadCallbackData<result_type>>(
-                numOutstanding, handler, [i, &results](auto& result) {
-                    if (result.hasResult())
-                        results[i] = {
-                            result.getBytes(),
-                            result.getBytes(),
-                            result.getUInt32(),
-                            result.getUInt32()};
-                }));
-
-            executeAsyncRead(statement, processAsyncRead, *cbs[i]);
-        }
-        assert(results.size() == cbs.size());
-
-        // suspend the coroutine until completion handler is called.
-        result.get();
-        numReadRequestsOutstanding_ -= hashes.size();
+        success = executeBatchRead(
+            hashes.size(),
+            [this, &hashes](std::size_t i) {
+                CassandraStatement statement{selectTransaction_};
+                statement.bindNextBytes(hashes[i]);
+                return statement;
+            },
+            [&results](std::size_t i, CassandraResult& result) {
+                if (result.hasResult())
+                    results[i] = {
+                        result.getBytes(),
+                        result.getBytes(),
+                        result.getUInt32(),
+                        result.getUInt32()};
+            },
+            yield);
     });
-    for (auto const& cb : cbs)
-    {
-        if (cb->errored)
-            throw DatabaseTimeout();
-    }
+    if (!success)
+        throw DatabaseTimeout();
 
-    // log_.debug() << "Fetched " << numHashes
+    // log_.debug() << "Fetched " << hashes.size()
     //              << " transactions from Cassandra in " << timeDiff
     //              << " milliseconds";
     return results;
@@ -749,7 +975,64 @@ CassandraBackend::fetchAccountTransactions(
     if (!rng)
         return {{}, {}};
 
-    CassandraStatement statement = [this, forward]() {
+    // account_tx_inline only holds the ledgers written since it was enabled.
+    // Pages older than that, and the rest of a page that walks past them,
+    // are read from account_tx
+    std::uint32_t const inlineStart = accountTxInline_ == AccountTxInline::read
+        ? fetchAccountTxInlineStart(yield)
+        : 0;
+    auto const firstSeq = cursorIn ? cursorIn->ledgerSequence
+        : forward                  ? rng->minSequence
+                                   : rng->maxSequence;
+    bool const inlined = inlineStart != 0 && firstSeq >= inlineStart;
+
+    auto [txns, cursor] = readAccountTransactions(
+        account, limit, forward, cursorIn, inlined ? inlineStart : 0, *rng,
+        yield);
+
+    if (inlined && !forward && txns.size() < limit)
+    {
+        auto rest = readAccountTransactions(
+            account,
+            limit - txns.size(),
+            forward,
+            cursor ? cursor : cursorIn,
+            0,
+            *rng,
+            yield);
+        txns.insert(
+            txns.end(),
+            std::make_move_iterator(rest.txns.begin()),
+            std::make_move_iterator(rest.txns.end()));
+        cursor = rest.cursor;
+    }
+    log_.debug() << "Txns = " << txns.size();
+
+    if (txns.size() == limit)
+    {
+        log_.debug() << "Returning cursor";
+        return {txns, cursor};
+    }
+
+    return {txns, {}};
+}
+
+TransactionsAndCursor
+CassandraBackend::readAccountTransactions(
+    ripple::AccountID const& account,
+    std::uint32_t const limit,
+    bool const forward,
+    std::optional<TransactionsCursor> const& cursorIn,
+    std::uint32_t const inlineStart,
+    LedgerRange const& rng,
+    boost::asio::yield_context& yield) const
+{
+    bool const inlined = inlineStart != 0;
+    CassandraStatement statement = [this, forward, inlined]() {
+        if (inlined)
+            return CassandraStatement{
+                forward ? selectAccountTxInlineForward_
+                        : selectAccountTxInline_};
         if (forward)
             return CassandraStatement{selectAccountTxForward_};
         else
@@ -768,7 +1051,7 @@ CassandraBackend::fetchAccountTransactions(
     }
     else
     {
-        int const seq = forward ? rng->minSequence : rng->maxSequence;
+        int const seq = forward ? rng.minSequence : rng.maxSequence;
         int const placeHolder =
             forward ? 0 : std::numeric_limits<std::uint32_t>::max();
 
@@ -787,37 +1070,89 @@ CassandraBackend::fetchAccountTransactions(
     }
 
     std::vector<ripple::uint256> hashes = {};
+    std::vector<TransactionAndMetadata> txns = {};
     auto numRows = result.numRows();
     log_.info() << "num_rows = " << std::to_string(numRows);
     do
     {
-        hashes.push_back(result.getUInt256());
-        if (--numRows == 0)
+        if (!inlined)
+            hashes.push_back(result.getUInt256());
+        auto [lgrSeq, txnIdx] = result.getInt64Tuple();
+        if (inlined)
         {
-            log_.debug() << "Setting cursor";
-            auto [lgrSeq, txnIdx] = result.getInt64Tuple();
-            cursor = {
-                static_cast<std::uint32_t>(lgrSeq),
-                static_cast<std::uint32_t>(txnIdx)};
-
-            // Only modify if forward because forward query
-            // (selectAccountTxForward_) orders by ledger/tx sequence >= whereas
-            // reverse query (selectAccountTx_) orders by ledger/tx sequence <.
-            if (forward)
-                ++cursor->transactionIndex;
+            // older rows were backfilled, the table is not complete there
+            if (lgrSeq < inlineStart)
+                break;
+
+            auto transaction = result.getBytes();
+            auto metadata = result.getBytes();
+            txns.push_back(
+                {std::move(transaction),
+                 std::move(metadata),
+                 static_cast<std::uint32_t>(lgrSeq),
+                 result.getUInt32()});
         }
+
+        cursor = {
+            static_cast<std::uint32_t>(lgrSeq),
+            static_cast<std::uint32_t>(txnIdx)};
+
+        // Only modify if forward because forward query
+        // (selectAccountTxForward_) orders by ledger/tx sequence >= whereas
+        // reverse query (selectAccountTx_) orders by ledger/tx sequence <.
+        if (forward)
+            ++cursor->transactionIndex;
     } while (result.nextRow());
 
-    auto txns = fetchTransactions(hashes, yield);
-    log_.debug() << "Txns = " << txns.size();
+    if (!inlined)
+        txns = fetchTransactions(hashes, yield);
 
-    if (txns.size() == limit)
+    return {txns, cursor};
+}
+
+std::uint32_t
+CassandraBackend::fetchAccountTxInlineStart(
+    boost::asio::yield_context& yield) const
+{
+    if (auto const start = accountTxInlineStart_.load(); start != 0)
+        return start;
+
+    // Until a writer records the start, look it up at most once a second
+    // rather than on every request
+    using namespace std::chrono;
+    auto const now = steady_clock::now().time_since_epoch().count();
+    auto last = accountTxInlineChecked_.load();
+    if (now - last < duration_cast<steady_clock::duration>(1s).count() ||
+        !accountTxInlineChecked_.compare_exchange_strong(last, now))
+        return 0;
+
+    CassandraStatement statement{selectAccountTxInlineStart_};
+    CassandraResult result = executeAsyncRead(statement, yield);
+    if (!result.hasResult())
     {
-        log_.debug() << "Returning cursor";
-        return {txns, cursor};
+        log_.warn() << "account_tx_inline has not been written yet. Reading "
+                    << "account_tx instead";
+        return 0;
     }
 
-    return {txns, {}};
+    auto const start = result.getUInt32();
+    log_.info() << "account_tx_inline starts at ledger " << start;
+    accountTxInlineStart_ = start;
+    return start;
+}
+
+void
+CassandraBackend::writeAccountTxInlineStart()
+{
+    if (accountTxInline_ == AccountTxInline::none || wroteAccountTxInlineStart_)
+        return;
+
+    // The first ledger written with the table enabled. The condition keeps
+    // the start of any earlier writer
+    CassandraStatement statement{insertAccountTxInlineStart_};
+    statement.bindNextInt(ledgerSequence_);
+    executeSyncWrite(statement);
+    wroteAccountTxInlineStart_ = true;
 }
 
 std::optional<ripple::uint256>
@@ -877,42 +1212,25 @@ CassandraBackend::doFetchLedgerObjects(
     if (keys.size() == 0)
         return {};
 
-    numReadRequestsOutstanding_ += keys.size();
-
-    handler_type handler(std::forward<decltype(yield)>(yield));
-    result_type result(handler);
-
-    std::size_t const numKeys = keys.size();
-    // log_.trace() << "Fetching " << numKeys << " records from Cassandra";
-    std::atomic_int numOutstanding = numKeys;
-    std::vector<Blob> results{numKeys};
-    std::vector<std::shared_ptr<ReadCallbackData<result_type>>> cbs;
-    cbs.reserve(numKeys);
-    for (std::size_t i = 0; i < keys.size(); ++i)
-    {
-        cbs.push_back(std::make_shared<ReadCallbackData<result_type>>(
-            numOutstanding, handler, [i, &results](auto& result) {
-                if (result.hasResult())
-                    results[i] = result.getBytes();
-            }));
-        CassandraStatement statement{selectObject_};
-        statement.bindNextBytes(keys[i]);
-        statement.bindNextInt(sequence);
-        executeAsyncRead(statement, processAsyncRead, *cbs[i]);
-    }
-    assert(results.size() == cbs.size());
-
-    // suspend the coroutine until completion handler is called.
-    result.get();
-    numReadRequestsOutstanding_ -= keys.size();
-
-    for (auto const& cb : cbs)
-    {
-        if (cb->errored)
-            throw DatabaseTimeout();
-    }
+    // log_.trace() << "Fetching " << keys.size() << " records from Cassandra";
+    std::vector<Blob> results{keys.size()};
+    auto const success = executeBatchRead(
+        keys.size(),
+        [this, &keys, sequence](std::size_t i) {
+            CassandraStatement statement{selectObject_};
+            statement.bindNextBytes(keys[i]);
+            statement.bindNextInt(sequence);
+            return statement;
+        },
+        [&results](std::size_t i, CassandraResult& result) {
+            if (result.hasResult())
+                results[i] = result.getBytes();
+        },
+        yield);
+    if (!success)
+        throw DatabaseTimeout();
 
-    // log_.trace() << "Fetched " << numKeys << " records from Cassandra";
+    // log_.trace() << "Fetched " << keys.size() << " records from Cassandra";
     return results;
 }
 
@@ -1139,6 +1457,20 @@ CassandraBackend::open(bool readOnly)
     maxReadRequestsOutstanding = config_.valueOr<int>(
         "max_read_requests_outstanding", maxReadRequestsOutstanding);
     syncInterval_ = config_.valueOr<int>("sync_interval", syncInterval_);
+    batchReadWindow_ =
+        config_.valueOr<int>("batch_read_window", batchReadWindow_);
+    writeBatchLimits_.maxStatements = std::max(
+        1, config_.valueOr<int>(
+            "write_batch_size", writeBatchLimits_.maxStatements));
+    writeBatchLimits_.maxBytes =
+        config_.valueOr<int>("write_batch_bytes", writeBatchLimits_.maxBytes);
+    if (auto mode = config_.valueOr<std::string>("account_tx_inline", "none");
+        mode == "write")
+        accountTxInline_ = AccountTxInline::write;
+    else if (mode == "read")
+        accountTxInline_ = AccountTxInline::read;
+    else if (mode != "none")
+        throw std::runtime_error("Invalid account_tx_inline mode: " + mode);
 
     log_.info() << "Sync interval is " << syncInterval_
                 << ". max write requests outstanding is "
@@ -1370,6 +1702,43 @@ CassandraBackend::open(bool readOnly)
         if (!executeSimpleStatement(query.str()))
             continue;
 
+        if (accountTxInline_ != AccountTxInline::none)
+        {
+            query.str("");
+            query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
+                  << "account_tx_inline"
+                  << " ( account blob, seq_idx "
+                     "tuple<bigint, bigint>, "
+                     " hash blob, transaction blob, metadata blob, "
+                     " date bigint, "
+                     "PRIMARY KEY "
+                     "(account, seq_idx)) WITH "
+                     "CLUSTERING ORDER BY (seq_idx desc)"
+                  << " AND default_time_to_live = " << std::to_string(ttl);
+
+            if (!executeSimpleStatement(query.str()))
+                continue;
+
+            query.str("");
+            query << "SELECT * FROM " << tablePrefix << "account_tx_inline"
+                  << " LIMIT 1";
+            if (!executeSimpleStatement(query.str()))
+                continue;
+
+            query.str("");
+            query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
+                  << "account_tx_inline_start"
+                  << " ( id int PRIMARY KEY, sequence bigint )";
+            if (!executeSimpleStatement(query.str()))
+                continue;
+
+            query.str("");
+            query << "SELECT * FROM " << tablePrefix
+                  << "account_tx_inline_start LIMIT 1";
+            if (!executeSimpleStatement(query.str()))
+                continue;
+        }
+
         query.str("");
         query << "CREATE TABLE IF NOT EXISTS " << tablePrefix << "ledgers"
               << " ( sequence bigint PRIMARY KEY, header blob )"
@@ -1408,6 +1777,19 @@ CassandraBackend::open(bool readOnly)
         if (!executeSimpleStatement(query.str()))
             continue;
 
+        query.str("");
+        query << "CREATE TABLE IF NOT EXISTS " << tablePrefix
+              << "tx_history_start"
+              << " (id int PRIMARY KEY, sequence bigint)";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
+        query.str("");
+        query << "SELECT * FROM " << tablePrefix << "tx_history_start"
+              << " LIMIT 1";
+        if (!executeSimpleStatement(query.str()))
+            continue;
+
         query.str("");
         query << "CREATE TABLE IF NOT EXISTS " << tablePrefix << "nf_tokens"
               << "  ("
@@ -1602,6 +1984,49 @@ CassandraBackend::open(bool readOnly)
         if (!selectAccountTxForward_.prepareStatement(query, session_.get()))
             continue;
 
+        if (accountTxInline_ != AccountTxInline::none)
+        {
+            query.str("");
+            query << " INSERT INTO " << tablePrefix << "account_tx_inline"
+                  << " (account, seq_idx, hash, transaction, metadata, date) "
+                  << " VALUES (?,?,?,?,?,?)";
+            if (!insertAccountTxInline_.prepareStatement(
+                    query, session_.get()))
+                continue;
+
+            query.str("");
+            query << " SELECT seq_idx,transaction,metadata,date FROM "
+                  << tablePrefix << "account_tx_inline"
+                  << " WHERE account = ? "
+                  << " AND seq_idx < ? LIMIT ?";
+            if (!selectAccountTxInline_.prepareStatement(
+                    query, session_.get()))
+                continue;
+
+            query.str("");
+            query << " SELECT seq_idx,transaction,metadata,date FROM "
+                  << tablePrefix << "account_tx_inline"
+                  << " WHERE account = ? "
+                  << " AND seq_idx >= ? ORDER BY seq_idx ASC LIMIT ?";
+            if (!selectAccountTxInlineForward_.prepareStatement(
+                    query, session_.get()))
+                continue;
+
+            query.str("");
+            query << " INSERT INTO " << tablePrefix << "account_tx_inline_start"
+                  << " (id, sequence) VALUES (0, ?) IF NOT EXISTS";
+            if (!insertAccountTxInlineStart_.prepareStatement(
+                    query, session_.get()))
+                continue;
+
+            query.str("");
+            query << " SELECT sequence FROM " << tablePrefix
+                  << "account_tx_inline_start WHERE id = 0";
+            if (!selectAccountTxInlineStart_.prepareStatement(
+                    query, session_.get()))
+                continue;
+        }
+
         query.str("");
         query << "INSERT INTO " << tablePrefix << "nf_tokens"
               << " (token_id,sequence,owner,is_burned)"
@@ -1716,6 +2141,18 @@ CassandraBackend::open(bool readOnly)
         query << " SELECT sequence FROM " << tablePrefix << "ledger_range";
         if (!selectLedgerRange_.prepareStatement(query, session_.get()))
             continue;
+
+        query.str("");
+        query << " INSERT INTO " << tablePrefix << "tx_history_start"
+              << " (id, sequence) VALUES (0, ?)";
+        if (!insertTxHistoryStart_.prepareStatement(query, session_.get()))
+            continue;
+
+        query.str("");
+        query << " SELECT sequence FROM " << tablePrefix
+              << "tx_history_start WHERE id = 0";
+        if (!selectTxHistoryStart_.prepareStatement(query, session_.get()))
+            continue;
         setupPreparedStatements = true;
     }
 
@@ -22,6 +22,8 @@
 #include <ripple/basics/base_uint.h>
 #include <backend/BackendInterface.h>
 #include <backend/DBHelpers.h>
+#include <backend/ReadMeter.h>
+#include <backend/WriteBatch.h>
 #include <log/Logger.h>
 
 #include <cassandra.h>
@@ -33,6 +35,7 @@
 #include <boost/json.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <iostream>
 #include <memory>
@@ -152,6 +155,40 @@ public:
         curBindingIndex_++;
     }
 
+    void
+    bindNextString(std::string const& value)
+    {
+        if (!statement_)
+            throw std::runtime_error(
+                "CassandraStatement::bindNextString - statement_ is null");
+        CassError rc = cass_statement_bind_string_n(
+            statement_, curBindingIndex_, value.data(), value.size());
+        if (rc != CASS_OK)
+        {
+            std::stringstream ss;
+            ss << "Error binding string to statement: " << rc << ", "
+               << cass_error_desc(rc);
+            log_.error() << ss.str();
+            throw std::runtime_error(ss.str());
+        }
+        curBindingIndex_++;
+    }
+
+    // Fetch the results of this statement in pages of pageSize rows, starting
+    // after the page whose paging state is given. See
+    // CassandraResult::pagingState
+    void
+    setPaging(std::uint32_t pageSize, std::string const& pagingState = {})
+    {
+        if (!statement_)
+            throw std::runtime_error(
+                "CassandraStatement::setPaging - statement_ is null");
+        cass_statement_set_paging_size(statement_, pageSize);
+        if (pagingState.size())
+            cass_statement_set_paging_state_token(
+                statement_, pagingState.data(), pagingState.size());
+    }
+
     void
     bindNextBytes(const char* data, std::uint32_t const size)
     {
@@ -296,6 +333,69 @@ public:
     }
 };
 
+// Unlogged batch of statements, written as a single request. Only used for
+// statements of the same partition, for which the server applies the whole
+// batch as one mutation
+class CassandraBatch
+{
+    CassBatch* batch_ = nullptr;
+    std::size_t size_ = 0;
+    clio::Logger log_{"Backend"};
+
+public:
+    CassandraBatch()
+    {
+        batch_ = cass_batch_new(CASS_BATCH_TYPE_UNLOGGED);
+        cass_batch_set_consistency(batch_, CASS_CONSISTENCY_QUORUM);
+    }
+
+    CassandraBatch(CassandraBatch&& other)
+    {
+        batch_ = other.batch_;
+        other.batch_ = nullptr;
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+
+    CassandraBatch(CassandraBatch const& other) = delete;
+
+    CassBatch*
+    get() const
+    {
+        return batch_;
+    }
+
+    std::size_t
+    size() const
+    {
+        return size_;
+    }
+
+    // The batch keeps its own reference to the statement
+    void
+    add(CassandraStatement const& statement)
+    {
+        if (!batch_)
+            throw std::runtime_error("CassandraBatch::add - batch_ is null");
+        CassError rc = cass_batch_add_statement(batch_, statement.get());
+        if (rc != CASS_OK)
+        {
+            std::stringstream ss;
+            ss << "Error adding statement to batch: " << rc << ", "
+               << cass_error_desc(rc);
+            log_.error() << ss.str();
+            throw std::runtime_error(ss.str());
+        }
+        ++size_;
+    }
+
+    ~CassandraBatch()
+    {
+        if (batch_)
+            cass_batch_free(batch_);
+    }
+};
+
 class CassandraResult
 {
     clio::Logger log_{"Backend"};
@@ -362,6 +462,27 @@ public:
         return cass_result_row_count(result_);
     }
 
+    bool
+    hasMorePages()
+    {
+        return result_ && cass_result_has_more_pages(result_) == cass_true;
+    }
+
+    // Opaque state to resume paging after this page. Empty if this is the
+    // last page
+    std::string
+    pagingState()
+    {
+        if (!hasMorePages())
+            return {};
+        char const* token = nullptr;
+        std::size_t size = 0;
+        if (cass_result_paging_state_token(result_, &token, &size) != CASS_OK)
+            throw std::runtime_error(
+                "CassandraResult::pagingState - no paging state");
+        return {token, size};
+    }
+
     bool
     nextRow()
     {
@@ -652,6 +773,11 @@ private:
     CassandraPreparedStatement insertAccountTx_;
     CassandraPreparedStatement selectAccountTx_;
     CassandraPreparedStatement selectAccountTxForward_;
+    CassandraPreparedStatement insertAccountTxInline_;
+    CassandraPreparedStatement selectAccountTxInline_;
+    CassandraPreparedStatement selectAccountTxInlineForward_;
+    CassandraPreparedStatement insertAccountTxInlineStart_;
+    CassandraPreparedStatement selectAccountTxInlineStart_;
     CassandraPreparedStatement insertNFT_;
     CassandraPreparedStatement selectNFT_;
     CassandraPreparedStatement insertIssuerNFT_;
@@ -669,10 +795,36 @@ private:
     CassandraPreparedStatement selectLedgerByHash_;
     CassandraPreparedStatement selectLatestLedger_;
     CassandraPreparedStatement selectLedgerRange_;
+    CassandraPreparedStatement insertTxHistoryStart_;
+    CassandraPreparedStatement selectTxHistoryStart_;
 
     uint32_t syncInterval_ = 1;
     uint32_t lastSync_ = 0;
 
+    // Denormalized account_tx_inline table, holding the transaction and
+    // metadata next to each account_tx row so that a page of account
+    // transactions is served by a single partition read. Configured by
+    // "account_tx_inline": "none" (default), "write" to populate the table
+    // while still serving reads from account_tx, or "read" to also serve
+    // reads from it for the ledgers it covers
+    enum class AccountTxInline { none, write, read };
+    AccountTxInline accountTxInline_ = AccountTxInline::none;
+    // First ledger written to account_tx_inline, recorded in
+    // account_tx_inline_start by the first writer. 0 while unknown. Turning
+    // the table off and on again leaves a gap this does not know about, so
+    // truncate account_tx_inline_start along with account_tx_inline then
+    mutable std::atomic_uint32_t accountTxInlineStart_ = 0;
+    // steady clock time of the last lookup of the start while unknown
+    mutable std::atomic<std::chrono::steady_clock::rep>
+        accountTxInlineChecked_ = 0;
+    bool wroteAccountTxInlineStart_ = false;
+
+    // First backfilled ledger of tx_history_start, 0 while unknown. It only
+    // moves down, so a cached value stays correct until the next lookup
+    mutable std::atomic_uint32_t txHistoryStart_ = 0;
+    // steady clock time of the last lookup of tx_history_start
+    mutable std::atomic<std::chrono::steady_clock::rep> txHistoryChecked_ = 0;
+
     // maximum number of concurrent in flight write requests. New requests will
     // wait for earlier requests to finish if this limit is exceeded
     std::uint32_t maxWriteRequestsOutstanding = 10000;
@@ -683,6 +835,16 @@ private:
     std::uint32_t maxReadRequestsOutstanding = 100000;
     mutable std::atomic_uint32_t numReadRequestsOutstanding_ = 0;
 
+    // caps on the unlogged batches account_tx, account_tx_inline and
+    // nf_token_transactions rows are written in. Configured by
+    // "write_batch_size" (statements) and "write_batch_bytes"
+    BatchLimits writeBatchLimits_;
+
+    // maximum number of statements a single batch read (fetchTransactions,
+    // doFetchLedgerObjects) keeps in flight. Larger batches are streamed
+    // through this window
+    std::uint32_t batchReadWindow_ = 256;
+
     // mutex and condition_variable to limit the number of concurrent in flight
     // write requests
     mutable std::mutex throttleMutex_;
@@ -701,7 +863,27 @@ private:
     clio::Config config_;
     uint32_t ttl_ = 0;
 
-    mutable std::uint32_t ledgerSequence_ = 0;
+    // atomic since backfill writes ledgers from several threads
+    mutable std::atomic_uint32_t ledgerSequence_ = 0;
+
+    // One page of account_tx, or of account_tx_inline down to inlineStart
+    // when that is set. The cursor is the one of the last row read
+    TransactionsAndCursor
+    readAccountTransactions(
+        ripple::AccountID const& account,
+        std::uint32_t const limit,
+        bool const forward,
+        std::optional<TransactionsCursor> const& cursor,
+        std::uint32_t const inlineStart,
+        LedgerRange const& rng,
+        boost::asio::yield_context& yield) const;
+
+    // 0 if no ledger has been written to account_tx_inline yet
+    std::uint32_t
+    fetchAccountTxInlineStart(boost::asio::yield_context& yield) const;
+
+    void
+    writeAccountTxInlineStart();
 
 public:
     CassandraBackend(
@@ -836,10 +1018,11 @@ public:
     bool
     doFinishWrites() override
     {
-        if (syncInterval_ == 1)
-            return doFinishWritesSync();
-        else
-            return doFinishWritesAsync();
+        bool const committed = syncInterval_ == 1 ? doFinishWritesSync()
+                                                  : doFinishWritesAsync();
+        if (committed)
+            writeAccountTxInlineStart();
+        return committed;
     }
     void
     writeLedger(ripple::LedgerInfo const& ledgerInfo, std::string&& header)
@@ -903,6 +1086,13 @@ public:
     std::optional<LedgerRange>
     hardFetchLedgerRange(boost::asio::yield_context& yield) const override;
 
+    std::optional<std::uint32_t>
+    fetchTransactionHistoryStart(
+        boost::asio::yield_context& yield) const override;
+
+    void
+    writeTransactionHistoryStart(std::uint32_t const sequence) override;
+
     std::vector<TransactionAndMetadata>
     fetchAllTransactionsInLedger(
         std::uint32_t const ledgerSequence,
@@ -1036,13 +1226,50 @@ public:
     }
 
     void
-    sync() const
+    sync() const override
     {
         std::unique_lock<std::mutex> lck(syncMutex_);
 
         syncCv_.wait(lck, [this]() { return finishedAllRequests(); });
     }
 
+    void
+    syncThreadWrites() const override
+    {
+        auto const& writes = threadWrites();
+        std::unique_lock lck(writes->mtx);
+        writes->cv.wait(lck, [&writes]() { return writes->outstanding == 0; });
+    }
+
+    // Writes issued by one thread that have not completed yet
+    struct ThreadWrites
+    {
+        std::atomic_uint32_t outstanding = 0;
+        std::mutex mtx;
+        std::condition_variable cv;
+
+        void
+        finish()
+        {
+            if (--outstanding == 0)
+            {
+                // mutex lock required to prevent race condition around
+                // spurious wakeup
+                std::lock_guard lck(mtx);
+                cv.notify_all();
+            }
+        }
+    };
+
+    // The writes of the calling thread. Shared with the callbacks of those
+    // writes, which may complete after the thread is gone
+    static std::shared_ptr<ThreadWrites> const&
+    threadWrites()
+    {
+        thread_local auto const writes = std::make_shared<ThreadWrites>();
+        return writes;
+    }
+
     bool
     doOnlineDelete(
         std::uint32_t const numLedgersToKeep,
@@ -1051,6 +1278,12 @@ public:
     bool
     isTooBusy() const override;
 
+    bool
+    storesAccountTxInline() const override
+    {
+        return accountTxInline_ != AccountTxInline::none;
+    }
+
     inline void
     incrementOutstandingRequestCount() const
     {
@@ -1109,14 +1342,26 @@ public:
         decrementOutstandingRequestCount();
     }
 
-    template <class T, class S>
+    CassFuture*
+    execute(CassandraStatement const& statement) const
+    {
+        return cass_session_execute(session_.get(), statement.get());
+    }
+
+    CassFuture*
+    execute(CassandraBatch const& batch) const
+    {
+        return cass_session_execute_batch(session_.get(), batch.get());
+    }
+
+    template <class Statement, class T, class S>
     void
     executeAsyncHelper(
-        CassandraStatement const& statement,
+        Statement const& statement,
         T callback,
         S& callbackData) const
     {
-        CassFuture* fut = cass_session_execute(session_.get(), statement.get());
+        CassFuture* fut = execute(statement);
 
         cass_future_set_callback(
             fut, callback, static_cast<void*>(&callbackData));
@@ -1124,10 +1369,10 @@ public:
         cass_future_free(fut);
     }
 
-    template <class T, class S>
+    template <class Statement, class T, class S>
     void
     executeAsyncWrite(
-        CassandraStatement const& statement,
+        Statement const& statement,
         T callback,
         S& callbackData,
         bool isRetry) const
@@ -1226,6 +1471,17 @@ public:
         return success == cass_true;
     }
 
+    // Read one row per index in [0, size). bind(i) returns the statement for
+    // index i and read(i, result) consumes its result. Returns false if any of
+    // the reads failed
+    template <class Bind, class Read>
+    bool
+    executeBatchRead(
+        std::size_t size,
+        Bind&& bind,
+        Read&& read,
+        boost::asio::yield_context& yield) const;
+
     CassandraResult
     executeAsyncRead(
         CassandraStatement const& statement,
@@ -1273,6 +1529,11 @@ public:
         // so we can use the sync version of this function.
         CassResult const* res = cass_future_get_result(fut);
         cass_future_free(fut);
+        if (auto* meter = ScopedReadMeter::find(yield))
+        {
+            ++meter->reads;
+            meter->rows += cass_result_row_count(res);
+        }
         return {res};
     }
 
@@ -28,6 +28,8 @@
 
 #include <boost/container/flat_set.hpp>
 
+#include <memory>
+
 #include <backend/Types.h>
 
 /// Struct used to keep track of what to write to
@@ -38,6 +40,10 @@ struct AccountTransactionsData
     std::uint32_t ledgerSequence;
     std::uint32_t transactionIndex;
     ripple::uint256 txHash;
+    // the transaction itself, shared by the rows of all affected accounts.
+    // Only set when the backend stores account_tx denormalized. See
+    // BackendInterface::storesAccountTxInline
+    std::shared_ptr<Backend::TransactionAndMetadata const> inlineTx;
 
     AccountTransactionsData(
         ripple::TxMeta& meta,
@@ -181,6 +187,19 @@ isDirNode(T const& object)
     return spaceKey == 0x0064;
 }
 
+/// Whether a serialized ledger object is an NFTokenPage. Looks at the ledger
+/// entry type, which is always the first field, without deserializing
+template <class T>
+inline bool
+isNFTokenPage(T const& object)
+{
+    if (object.size() < 3)
+        return false;
+    auto const* data = reinterpret_cast<unsigned char const*>(object.data());
+    std::uint16_t const type = (data[1] << 8) | data[2];
+    return type == ripple::ltNFTOKEN_PAGE;
+}
+
 template <class T, class R>
 inline bool
 isBookDir(T const& key, R const& object)
@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/protocol/Indexes.h>
+#include <ripple/protocol/Protocol.h>
+#include <backend/BackendInterface.h>
+#include <backend/DirectoryPrefetcher.h>
+
+#include <algorithm>
+
+namespace Backend {
+
+DirectoryPrefetcher::DirectoryPrefetcher(
+    BackendInterface const& backend,
+    ripple::uint256 const& root,
+    std::uint32_t sequence)
+    : backend_(backend), root_(root), sequence_(sequence)
+{
+}
+
+std::optional<ripple::SLE>
+DirectoryPrefetcher::fetchPage(
+    std::uint64_t page,
+    std::size_t entriesWanted,
+    boost::asio::yield_context& yield)
+{
+    auto const key = ripple::keylet::page(root_, page).key;
+
+    if (!buffer_.contains(page))
+    {
+        // Only read ahead once we know the directory has more than one page,
+        // most directories don't
+        std::uint64_t window = 1;
+        if (page != 0)
+        {
+            auto const pagesWanted =
+                (entriesWanted + ripple::dirNodeMaxEntries - 1) /
+                ripple::dirNodeMaxEntries;
+            window = std::clamp<std::uint64_t>(pagesWanted, 1, maxWindow);
+            if (lastPage_ && *lastPage_ >= page)
+                window = std::min(window, *lastPage_ - page + 1);
+        }
+
+        // pages behind the walk won't be needed again
+        buffer_.erase(buffer_.begin(), buffer_.lower_bound(page));
+
+        if (window == 1)
+        {
+            if (auto blob = backend_.fetchLedgerObject(key, sequence_, yield))
+                buffer_[page] = std::move(*blob);
+        }
+        else
+        {
+            std::vector<ripple::uint256> keys;
+            keys.reserve(window);
+            keys.push_back(key);
+            for (std::uint64_t i = 1; i < window; ++i)
+                keys.push_back(ripple::keylet::page(root_, page + i).key);
+
+            auto blobs = backend_.fetchLedgerObjects(keys, sequence_, yield);
+            for (std::uint64_t i = 0; i < blobs.size(); ++i)
+            {
+                if (blobs[i].size())
+                    buffer_[page + i] = std::move(blobs[i]);
+            }
+        }
+
+        if (!buffer_.contains(page))
+            return {};
+    }
+
+    auto const& blob = buffer_.at(page);
+    ripple::SLE sle{ripple::SerialIter{blob.data(), blob.size()}, key};
+    if (page == 0)
+        lastPage_ = sle.getFieldU64(ripple::sfIndexPrevious);
+    return sle;
+}
+
+}  // namespace Backend
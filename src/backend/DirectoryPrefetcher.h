@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <ripple/basics/base_uint.h>
+#include <ripple/protocol/STLedgerEntry.h>
+#include <backend/Types.h>
+
+#include <boost/asio/spawn.hpp>
+
+#include <map>
+#include <optional>
+
+class BackendInterface;
+
+namespace Backend {
+
+/**
+ * @brief Reads the pages of a single directory for one walk, fetching the
+ * upcoming pages ahead of time.
+ *
+ * Walking a directory is a chain of dependent reads: the next page number is
+ * only known once the current page is parsed. Pages are numbered and almost
+ * always contiguous though, and the root page records the number of the last
+ * page in sfIndexPrevious. So on a miss the requested page is read together
+ * with the pages likely to follow it, in one batch, and kept in a small
+ * buffer until the walk gets there.
+ */
+class DirectoryPrefetcher
+{
+    BackendInterface const& backend_;
+    ripple::uint256 const root_;
+    std::uint32_t const sequence_;
+    // last page of the directory, known once the root page has been read
+    std::optional<std::uint64_t> lastPage_;
+    // page number -> blob, for pages read ahead of the walk
+    std::map<std::uint64_t, Blob> buffer_;
+
+public:
+    // maximum number of pages read in a single batch
+    static constexpr std::uint64_t maxWindow = 8;
+
+    DirectoryPrefetcher(
+        BackendInterface const& backend,
+        ripple::uint256 const& root,
+        std::uint32_t sequence);
+
+    /**
+     * @brief Fetch and parse a page of the directory.
+     *
+     * @param page Page number, 0 being the root page
+     * @param entriesWanted How many more entries the walk needs. Used to
+     * bound how far ahead pages are read
+     * @param yield Currently executing coroutine
+     * @return The page or nullopt if it does not exist
+     */
+    std::optional<ripple::SLE>
+    fetchPage(
+        std::uint64_t page,
+        std::size_t entriesWanted,
+        boost::asio::yield_context& yield);
+};
+
+}  // namespace Backend
@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <backend/DBHelpers.h>
+#include <backend/KeyIndex.h>
+
+namespace Backend {
+
+void
+KeyIndex::update(
+    std::vector<LedgerObject> const& objs,
+    uint32_t seq,
+    bool isBackground)
+{
+    if (disabled_)
+        return;
+
+    std::scoped_lock lck{mtx_};
+    if (seq > latestSeq_)
+    {
+        assert(seq == latestSeq_ + 1 || latestSeq_ == 0);
+        latestSeq_ = seq;
+    }
+    for (auto const& obj : objs)
+    {
+        if (obj.blob.size())
+        {
+            if (isBackground && deletes_.count(obj.key))
+                continue;
+
+            keys_.insert_or_assign(obj.key, ::isBookDir(obj.key, obj.blob));
+        }
+        else
+        {
+            keys_.erase(obj.key);
+            if (!full_ && !isBackground)
+                deletes_.insert(obj.key);
+        }
+    }
+}
+
+std::optional<ripple::uint256>
+KeyIndex::successor(ripple::uint256 const& key, uint32_t seq) const
+{
+    if (!full_)
+        return {};
+    std::shared_lock lck{mtx_};
+    if (seq != latestSeq_)
+        return {};
+    auto e = keys_.upper_bound(key);
+    if (e == keys_.end())
+        return {};
+    return e->first;
+}
+
+std::optional<ripple::uint256>
+KeyIndex::predecessor(ripple::uint256 const& key, uint32_t seq) const
+{
+    if (!full_)
+        return {};
+    std::shared_lock lck{mtx_};
+    if (seq != latestSeq_)
+        return {};
+    auto e = keys_.lower_bound(key);
+    if (e == keys_.begin())
+        return {};
+    --e;
+    return e->first;
+}
+
+std::optional<bool>
+KeyIndex::isBookDir(ripple::uint256 const& key) const
+{
+    std::shared_lock lck{mtx_};
+    auto e = keys_.find(key);
+    if (e == keys_.end())
+        return {};
+    return e->second;
+}
+
+void
+KeyIndex::setDisabled()
+{
+    disabled_ = true;
+}
+
+void
+KeyIndex::setFull()
+{
+    if (disabled_)
+        return;
+
+    full_ = true;
+    std::scoped_lock lck{mtx_};
+    deletes_.clear();
+}
+
+bool
+KeyIndex::isFull() const
+{
+    return full_;
+}
+
+uint32_t
+KeyIndex::latestLedgerSequence() const
+{
+    std::shared_lock lck{mtx_};
+    return latestSeq_;
+}
+
+size_t
+KeyIndex::size() const
+{
+    std::shared_lock lck{mtx_};
+    return keys_.size();
+}
+
+}  // namespace Backend
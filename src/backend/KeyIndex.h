@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <ripple/basics/base_uint.h>
+#include <ripple/basics/hardened_hash.h>
+#include <backend/Types.h>
+
+#include <atomic>
+#include <map>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace Backend {
+
+/**
+ * @brief Ordered set of the keys of the most recent ledger, without blobs.
+ *
+ * Used by an ETL writer whose cache is disabled to compute successors when
+ * rippled does not send object neighbors. Besides the key, the index only
+ * records whether the object is a book directory, which is what successor
+ * maintenance needs to know about deleted objects. Loaded and updated with
+ * the same semantics as the cache. Disabled on nodes with a cache, which
+ * compute successors from the cache instead, and on read only nodes.
+ */
+class KeyIndex
+{
+    // key -> whether the object is a book directory
+    std::map<ripple::uint256, bool> keys_;
+    mutable std::shared_mutex mtx_;
+    uint32_t latestSeq_ = 0;
+    std::atomic_bool full_ = false;
+    std::atomic_bool disabled_ = false;
+    // prevents a background load from adding keys deleted in a more recent
+    // ledger. not used once the index is full
+    std::unordered_set<ripple::uint256, ripple::hardened_hash<>> deletes_;
+
+public:
+    // Update the index with the objects of a ledger. Objects with an empty
+    // blob are deleted. Set isBackground to true when loading old data from
+    // a background thread
+    void
+    update(
+        std::vector<LedgerObject> const& objs,
+        uint32_t seq,
+        bool isBackground = false);
+
+    // always returns empty optional if isFull() is false or seq is not the
+    // latest sequence
+    std::optional<ripple::uint256>
+    successor(ripple::uint256 const& key, uint32_t seq) const;
+
+    // always returns empty optional if isFull() is false or seq is not the
+    // latest sequence
+    std::optional<ripple::uint256>
+    predecessor(ripple::uint256 const& key, uint32_t seq) const;
+
+    // whether key is a book directory. Empty optional if key is not indexed
+    std::optional<bool>
+    isBookDir(ripple::uint256 const& key) const;
+
+    // updates are ignored from then on. For nodes that never need the index
+    void
+    setDisabled();
+
+    void
+    setFull();
+
+    // whether the index has every key of the most recent ledger
+    bool
+    isFull() const;
+
+    uint32_t
+    latestLedgerSequence() const;
+
+    size_t
+    size() const;
+};
+
+}  // namespace Backend
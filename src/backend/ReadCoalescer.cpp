@@ -0,0 +1,230 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <backend/ReadCoalescer.h>
+
+#include <boost/asio/post.hpp>
+
+namespace Backend {
+
+std::optional<Blob>
+ReadCoalescer::fetch(
+    ripple::uint256 const& key,
+    std::uint32_t sequence,
+    boost::asio::yield_context& yield,
+    SingleFetcher const& single,
+    BulkFetcher const& bulk)
+{
+    std::shared_ptr<Read> read;
+    bool leader = false;
+    {
+        std::scoped_lock lck{mtx_};
+        if (auto it = inFlight_.find({key, sequence}); it != inFlight_.end())
+        {
+            read = it->second;
+            ++numCoalesced_;
+        }
+        else
+        {
+            read = std::make_shared<Read>();
+            inFlight_[{key, sequence}] = read;
+
+            auto [batch, inserted] = openBatches_.try_emplace(sequence);
+            batch->second.keys.push_back(key);
+            batch->second.reads.push_back(read);
+            leader = inserted;
+        }
+    }
+
+    if (leader)
+    {
+        // let reads issued concurrently by other requests join the batch
+        boost::asio::post(yield);
+
+        Batch batch;
+        {
+            std::scoped_lock lck{mtx_};
+            batch = std::move(openBatches_[sequence]);
+            openBatches_.erase(sequence);
+        }
+
+        try
+        {
+            std::vector<Blob> blobs;
+            if (batch.keys.size() == 1)
+            {
+                auto blob = single(key, sequence, yield);
+                blobs.push_back(blob ? std::move(*blob) : Blob{});
+            }
+            else
+            {
+                numBatched_ += batch.keys.size();
+                blobs = bulk(batch.keys, sequence, yield);
+            }
+            complete(sequence, batch, &blobs, nullptr);
+        }
+        catch (...)
+        {
+            complete(sequence, batch, nullptr, std::current_exception());
+            throw;
+        }
+    }
+    else
+    {
+        wait(read, yield);
+    }
+
+    if (!read->blob.size())
+        return {};
+    return read->blob;
+}
+
+std::vector<Blob>
+ReadCoalescer::fetch(
+    std::vector<ripple::uint256> const& keys,
+    std::uint32_t sequence,
+    boost::asio::yield_context& yield,
+    BulkFetcher const& bulk)
+{
+    std::vector<std::shared_ptr<Read>> reads;
+    reads.reserve(keys.size());
+    Batch owned;
+    {
+        std::scoped_lock lck{mtx_};
+        for (auto const& key : keys)
+        {
+            if (auto it = inFlight_.find({key, sequence});
+                it != inFlight_.end())
+            {
+                reads.push_back(it->second);
+                ++numCoalesced_;
+            }
+            else
+            {
+                auto read = std::make_shared<Read>();
+                inFlight_[{key, sequence}] = read;
+                reads.push_back(read);
+                owned.keys.push_back(key);
+                owned.reads.push_back(std::move(read));
+            }
+        }
+    }
+
+    if (owned.keys.size())
+    {
+        try
+        {
+            auto blobs = bulk(owned.keys, sequence, yield);
+            complete(sequence, owned, &blobs, nullptr);
+        }
+        catch (...)
+        {
+            complete(sequence, owned, nullptr, std::current_exception());
+            throw;
+        }
+    }
+
+    std::vector<Blob> results;
+    results.reserve(keys.size());
+    for (auto const& read : reads)
+    {
+        wait(read, yield);
+        results.push_back(read->blob);
+    }
+    return results;
+}
+
+void
+ReadCoalescer::complete(
+    std::uint32_t sequence,
+    Batch& batch,
+    std::vector<Blob>* blobs,
+    std::exception_ptr error)
+{
+    std::vector<std::function<void()>> waiters;
+    {
+        std::scoped_lock lck{mtx_};
+        for (size_t i = 0; i < batch.reads.size(); ++i)
+        {
+            auto& read = *batch.reads[i];
+            if (blobs)
+                read.blob = std::move((*blobs)[i]);
+            read.error = error;
+            read.done = true;
+            std::move(
+                read.waiters.begin(),
+                read.waiters.end(),
+                std::back_inserter(waiters));
+            read.waiters.clear();
+            inFlight_.erase({batch.keys[i], sequence});
+        }
+    }
+
+    for (auto const& resume : waiters)
+        resume();
+}
+
+void
+ReadCoalescer::wait(
+    std::shared_ptr<Read> const& read,
+    boost::asio::yield_context& yield)
+{
+    using function_type = void(boost::system::error_code);
+    using result_type =
+        boost::asio::async_result<boost::asio::yield_context, function_type>;
+    using handler_type = typename result_type::completion_handler_type;
+
+    {
+        std::scoped_lock lck{mtx_};
+        if (read->done)
+        {
+            if (read->error)
+                std::rethrow_exception(read->error);
+            return;
+        }
+    }
+
+    handler_type handler(yield);
+    result_type result(handler);
+
+    // std::function needs a copyable callable
+    auto shared = std::make_shared<handler_type>(std::move(handler));
+    auto resume = [shared]() {
+        boost::asio::post(
+            boost::asio::get_associated_executor(*shared),
+            [shared]() { (*shared)(boost::system::error_code{}); });
+    };
+
+    bool done = false;
+    {
+        std::scoped_lock lck{mtx_};
+        done = read->done;
+        if (!done)
+            read->waiters.push_back(std::move(resume));
+    }
+    if (done)
+        resume();
+
+    result.get();
+
+    if (read->error)
+        std::rethrow_exception(read->error);
+}
+
+}  // namespace Backend
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <ripple/basics/base_uint.h>
+#include <backend/Types.h>
+
+#include <boost/asio/spawn.hpp>
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Backend {
+
+/**
+ * @brief Merges concurrent reads of the same ledger objects.
+ *
+ * Right after a ledger closes, many requests read the same few objects (fee
+ * settings, popular books and accounts) at the same sequence within
+ * milliseconds of each other. Reads of a (key, sequence) pair that is already
+ * being read wait for that read instead of going to the database. Single
+ * object reads that arrive together are batched into one bulk read.
+ */
+class ReadCoalescer
+{
+public:
+    using SingleFetcher = std::function<std::optional<Blob>(
+        ripple::uint256 const&,
+        std::uint32_t,
+        boost::asio::yield_context&)>;
+    using BulkFetcher = std::function<std::vector<Blob>(
+        std::vector<ripple::uint256> const&,
+        std::uint32_t,
+        boost::asio::yield_context&)>;
+
+    /**
+     * @brief Read a single object.
+     *
+     * The first reader of a sequence yields once, so that reads issued
+     * meanwhile by other coroutines join its batch. A batch of one is read
+     * with single, anything bigger with bulk.
+     */
+    std::optional<Blob>
+    fetch(
+        ripple::uint256 const& key,
+        std::uint32_t sequence,
+        boost::asio::yield_context& yield,
+        SingleFetcher const& single,
+        BulkFetcher const& bulk);
+
+    /**
+     * @brief Read several objects. Keys already in flight are waited on, the
+     * rest are read right away with a single call to bulk.
+     */
+    std::vector<Blob>
+    fetch(
+        std::vector<ripple::uint256> const& keys,
+        std::uint32_t sequence,
+        boost::asio::yield_context& yield,
+        BulkFetcher const& bulk);
+
+    /// Number of reads served by a read issued on behalf of another request
+    std::uint64_t
+    numCoalesced() const
+    {
+        return numCoalesced_;
+    }
+
+    /// Number of single object reads merged into a bulk read
+    std::uint64_t
+    numBatched() const
+    {
+        return numBatched_;
+    }
+
+private:
+    struct Read
+    {
+        Blob blob;
+        std::exception_ptr error;
+        bool done = false;
+        std::vector<std::function<void()>> waiters;
+    };
+
+    struct Batch
+    {
+        std::vector<ripple::uint256> keys;
+        std::vector<std::shared_ptr<Read>> reads;
+    };
+
+    std::mutex mtx_;
+    std::map<std::pair<ripple::uint256, std::uint32_t>, std::shared_ptr<Read>>
+        inFlight_;
+    // single object reads waiting for their batch to be issued, by sequence
+    std::map<std::uint32_t, Batch> openBatches_;
+
+    std::atomic_uint64_t numCoalesced_ = 0;
+    std::atomic_uint64_t numBatched_ = 0;
+
+    void
+    complete(
+        std::uint32_t sequence,
+        Batch& batch,
+        std::vector<Blob>* blobs,
+        std::exception_ptr error);
+
+    // suspends the coroutine until read is done. Rethrows the error of the
+    // read, if any
+    void
+    wait(std::shared_ptr<Read> const& read, boost::asio::yield_context& yield);
+};
+
+}  // namespace Backend
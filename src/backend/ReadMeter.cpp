@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <backend/ReadMeter.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace Backend {
+
+namespace {
+
+// Meters by the address of the yield_context they are registered with. A
+// request passes the same yield_context down to every backend call. The meters
+// are spread over shards, so that coroutines reading at the same time rarely
+// share a lock
+struct alignas(64) Shard
+{
+    std::mutex mtx;
+    std::unordered_map<void const*, ReadMeter*> meters;
+};
+
+constexpr std::size_t numShards = 64;
+
+std::array<Shard, numShards> gShards;
+// lets reads outside of any request, such as the ones of ETL, skip the lock
+std::atomic_size_t gNumMeters = 0;
+
+Shard&
+shardFor(void const* key)
+{
+    // the lowest bits of an aligned address carry no information
+    auto const bits = reinterpret_cast<std::uintptr_t>(key);
+    return gShards[((bits >> 4) ^ (bits >> 12)) % numShards];
+}
+
+}  // namespace
+
+ScopedReadMeter::ScopedReadMeter(
+    boost::asio::yield_context const& yield,
+    ReadMeter& meter)
+    : yield_(yield)
+{
+    auto& shard = shardFor(&yield_);
+    std::scoped_lock lck(shard.mtx);
+    if (shard.meters.emplace(&yield_, &meter).second)
+        ++gNumMeters;
+}
+
+ScopedReadMeter::~ScopedReadMeter()
+{
+    auto& shard = shardFor(&yield_);
+    std::scoped_lock lck(shard.mtx);
+    if (shard.meters.erase(&yield_))
+        --gNumMeters;
+}
+
+ReadMeter*
+ScopedReadMeter::find(boost::asio::yield_context const& yield)
+{
+    if (gNumMeters == 0)
+        return nullptr;
+
+    auto& shard = shardFor(&yield);
+    std::scoped_lock lck(shard.mtx);
+    auto const it = shard.meters.find(&yield);
+    return it == shard.meters.end() ? nullptr : it->second;
+}
+
+}  // namespace Backend
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <boost/asio/spawn.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Backend {
+
+/// Database work done on behalf of one request
+struct ReadMeter
+{
+    // a cache hit is charged as this fraction of a row read from the database
+    static constexpr std::uint64_t cacheHitsPerRow = 16;
+
+    // statements read from the database
+    std::uint64_t reads = 0;
+    // rows returned by those statements
+    std::uint64_t rows = 0;
+    // ledger objects and successors found in the cache
+    std::uint64_t cacheHits = 0;
+
+    /// Cost of the work, in rows read from the database. Every read also
+    /// costs a row for its round trip
+    std::uint64_t
+    cost() const
+    {
+        return std::max<std::uint64_t>(
+            1, reads + rows + cacheHits / cacheHitsPerRow);
+    }
+};
+
+/// Attributes the reads made with a coroutine's yield_context to a meter for
+/// as long as it lives. Reads made through another yield_context, such as the
+/// ones of coroutines spawned by this one, are not metered
+class ScopedReadMeter
+{
+    boost::asio::yield_context const& yield_;
+
+public:
+    ScopedReadMeter(boost::asio::yield_context const& yield, ReadMeter& meter);
+
+    ~ScopedReadMeter();
+
+    ScopedReadMeter(ScopedReadMeter const&) = delete;
+    ScopedReadMeter&
+    operator=(ScopedReadMeter const&) = delete;
+
+    /// The meter the reads made with yield are attributed to, if any
+    static ReadMeter*
+    find(boost::asio::yield_context const& yield);
+};
+
+}  // namespace Backend
@@ -27,11 +27,9 @@ SimpleCache::latestLedgerSequence() const
     return latestSeq_;
 }
 
+template <class Objects>
 void
-SimpleCache::update(
-    std::vector<LedgerObject> const& objs,
-    uint32_t seq,
-    bool isBackground)
+SimpleCache::doUpdate(Objects&& objs, uint32_t seq, bool isBackground)
 {
     if (disabled_)
         return;
@@ -43,7 +41,7 @@ SimpleCache::update(
             assert(seq == latestSeq_ + 1 || latestSeq_ == 0);
             latestSeq_ = seq;
         }
-        for (auto const& obj : objs)
+        for (auto& obj : objs)
         {
             if (obj.blob.size())
             {
@@ -53,7 +51,10 @@ SimpleCache::update(
                 auto& e = map_[obj.key];
                 if (seq > e.seq)
                 {
-                    e = {seq, obj.blob};
+                    if constexpr (std::is_rvalue_reference_v<Objects&&>)
+                        e = {seq, std::move(obj.blob)};
+                    else
+                        e = {seq, obj.blob};
                 }
             }
             else
@@ -66,6 +67,24 @@ SimpleCache::update(
     }
 }
 
+void
+SimpleCache::update(
+    std::vector<LedgerObject> const& objs,
+    uint32_t seq,
+    bool isBackground)
+{
+    doUpdate(objs, seq, isBackground);
+}
+
+void
+SimpleCache::update(
+    std::vector<LedgerObject>&& objs,
+    uint32_t seq,
+    bool isBackground)
+{
+    doUpdate(std::move(objs), seq, isBackground);
+}
+
 std::optional<LedgerObject>
 SimpleCache::getSuccessor(ripple::uint256 const& key, uint32_t seq) const
 {
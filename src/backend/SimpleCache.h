@@ -52,6 +52,10 @@ class SimpleCache
     // data. not used when cache is full
     std::unordered_set<ripple::uint256, ripple::hardened_hash<>> deletes_;
 
+    template <class Objects>
+    void
+    doUpdate(Objects&& objs, uint32_t seq, bool isBackground);
+
 public:
     // Update the cache with new ledger objects
     // set isBackground to true when writing old data from a background thread
@@ -61,6 +65,13 @@ public:
         uint32_t seq,
         bool isBackground = false);
 
+    // Same as above, but moves the blobs into the cache instead of copying
+    void
+    update(
+        std::vector<LedgerObject>&& blobs,
+        uint32_t seq,
+        bool isBackground = false);
+
     std::optional<Blob>
     get(ripple::uint256 const& key, uint32_t seq) const;
 
@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <backend/WriteBatch.h>
+
+#include <bit>
+#include <string>
+
+namespace Backend {
+
+void
+WriteBatchStats::record(std::size_t rows)
+{
+    if (rows == 0)
+        return;
+
+    auto const bucket =
+        std::min<std::size_t>(std::bit_width(rows) - 1, numBuckets - 1);
+    ++buckets_[bucket];
+    ++numBatches_;
+    numRows_ += rows;
+}
+
+boost::json::object
+WriteBatchStats::toJson() const
+{
+    boost::json::object distribution;
+    for (std::size_t i = 0; i < numBuckets; ++i)
+    {
+        std::size_t const low = std::size_t{1} << i;
+        auto label = std::to_string(low);
+        if (i == numBuckets - 1)
+            label += "+";
+        else if (low > 1)
+            label += "-" + std::to_string(2 * low - 1);
+        distribution[label] = buckets_[i].load();
+    }
+
+    auto const batches = numBatches();
+    boost::json::object stats;
+    stats["batches"] = batches;
+    stats["rows"] = numRows();
+    stats["mean_rows"] =
+        batches ? static_cast<double>(numRows()) / batches : 0.0;
+    stats["distribution"] = std::move(distribution);
+    return stats;
+}
+
+}  // namespace Backend
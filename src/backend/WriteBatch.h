@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Backend {
+
+/**
+ * @brief Caps on the rows written as a single unlogged batch.
+ *
+ * Rows are only ever batched with rows of the same partition, so a batch goes
+ * to a single replica set. The byte cap keeps batches below the server's
+ * batch size warning threshold.
+ */
+struct BatchLimits
+{
+    std::uint32_t maxStatements = 64;
+    std::uint32_t maxBytes = 5120;
+};
+
+/**
+ * @brief Groups rows by partition and splits each group into batches.
+ *
+ * Rows of the same partition keep their relative order. A row larger than
+ * the byte cap is written on its own.
+ *
+ * @param rows the rows to write
+ * @param partition returns the partition key of a row
+ * @param size returns the approximate serialized size of a row
+ * @param limits caps on the statements and bytes of a batch
+ * @return the batches to write, each holding rows of a single partition
+ */
+template <class Row, class Partition, class Size>
+std::vector<std::vector<Row>>
+makeBatches(
+    std::vector<Row>&& rows,
+    Partition const& partition,
+    Size const& size,
+    BatchLimits const& limits)
+{
+    std::stable_sort(
+        rows.begin(), rows.end(), [&](Row const& lhs, Row const& rhs) {
+            return partition(lhs) < partition(rhs);
+        });
+
+    std::vector<std::vector<Row>> batches;
+    std::size_t bytes = 0;
+    for (auto& row : rows)
+    {
+        auto const rowBytes = size(row);
+        if (batches.empty() ||
+            partition(batches.back().front()) != partition(row) ||
+            batches.back().size() >= limits.maxStatements ||
+            bytes + rowBytes > limits.maxBytes)
+        {
+            batches.emplace_back();
+            bytes = 0;
+        }
+        batches.back().push_back(std::move(row));
+        bytes += rowBytes;
+    }
+    return batches;
+}
+
+/**
+ * @brief Distribution of the number of rows per batch written.
+ *
+ * Batch sizes are counted in power of two buckets: 1, 2-3, 4-7 and so on up
+ * to 128 and more.
+ */
+class WriteBatchStats
+{
+    static constexpr std::size_t numBuckets = 8;
+
+    std::array<std::atomic_uint64_t, numBuckets> buckets_ = {};
+    std::atomic_uint64_t numBatches_ = 0;
+    std::atomic_uint64_t numRows_ = 0;
+
+public:
+    void
+    record(std::size_t rows);
+
+    /// Number of writes issued, single rows included
+    std::uint64_t
+    numBatches() const
+    {
+        return numBatches_;
+    }
+
+    /// Number of rows written
+    std::uint64_t
+    numRows() const
+    {
+        return numRows_;
+    }
+
+    boost::json::object
+    toJson() const;
+};
+
+}  // namespace Backend
@@ -0,0 +1,513 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/StringUtilities.h>
+#include <etl/CacheTransfer.h>
+#include <log/Logger.h>
+#include <main/Build.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/beast/zlib.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+
+using namespace clio;
+
+// local to compilation unit loggers
+namespace {
+clio::Logger gLog{"ETL"};
+
+constexpr std::size_t keySize = ripple::uint256::bytes;
+constexpr std::size_t sizeFieldSize = 4;
+// favour speed over ratio, the transfer is meant to run at line rate
+constexpr int compressionLevel = 1;
+constexpr int windowBits = 15;
+constexpr int memLevel = 8;
+
+template <class T>
+std::optional<T>
+parseNumber(std::string_view str)
+{
+    T value;
+    auto const [ptr, ec] =
+        std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc{} || ptr != str.data() + str.size())
+        return {};
+    return value;
+}
+
+std::optional<ripple::uint256>
+parseKey(std::string_view str)
+{
+    ripple::uint256 key;
+    if (!key.parseHex(str))
+        return {};
+    return key;
+}
+
+std::string_view
+toStringView(boost::beast::string_view str)
+{
+    return {str.data(), str.size()};
+}
+
+}  // namespace
+
+namespace CacheTransfer {
+
+namespace http = boost::beast::http;
+
+std::string
+makeTarget(Request const& request)
+{
+    std::string res = target;
+    res += "?ledger_index=" + std::to_string(request.ledgerIndex);
+    res += "&limit=" + std::to_string(request.limit);
+    if (request.marker)
+        res += "&marker=" + ripple::strHex(*request.marker);
+    if (request.end)
+        res += "&end=" + ripple::strHex(*request.end);
+    if (request.diff)
+        res += "&diff=" + std::to_string(*request.diff);
+    if (request.compress)
+        res += "&compress=true";
+    return res;
+}
+
+std::optional<Request>
+parseTarget(std::string_view target)
+{
+    std::string_view const path{CacheTransfer::target};
+    if (target.substr(0, path.size()) != path)
+        return {};
+
+    auto query = target.substr(path.size());
+    if (query.empty() || query.front() != '?')
+        return {};
+    query.remove_prefix(1);
+
+    Request request;
+    bool hasLedgerIndex = false;
+    std::vector<std::string> params;
+    boost::split(params, query, boost::is_any_of("&"));
+    for (auto const& param : params)
+    {
+        auto const pos = param.find('=');
+        if (pos == std::string::npos)
+            return {};
+
+        std::string_view const name{param.data(), pos};
+        std::string_view const value{
+            param.data() + pos + 1, param.size() - pos - 1};
+
+        if (name == "ledger_index")
+        {
+            auto seq = parseNumber<std::uint32_t>(value);
+            if (!seq)
+                return {};
+            request.ledgerIndex = *seq;
+            hasLedgerIndex = true;
+        }
+        else if (name == "limit")
+        {
+            auto limit = parseNumber<std::uint32_t>(value);
+            if (!limit)
+                return {};
+            request.limit = std::clamp(*limit, {1}, maxLimit);
+        }
+        else if (name == "marker")
+        {
+            if (!(request.marker = parseKey(value)))
+                return {};
+        }
+        else if (name == "end")
+        {
+            if (!(request.end = parseKey(value)))
+                return {};
+        }
+        else if (name == "diff")
+        {
+            if (!(request.diff = parseNumber<std::uint32_t>(value)))
+                return {};
+        }
+        else if (name == "compress")
+        {
+            request.compress = value == "true";
+        }
+    }
+
+    if (!hasLedgerIndex)
+        return {};
+
+    return request;
+}
+
+std::string
+encodeFrames(std::vector<Backend::LedgerObject> const& objects)
+{
+    std::size_t size = 0;
+    for (auto const& obj : objects)
+        size += keySize + sizeFieldSize + obj.blob.size();
+
+    std::string res;
+    res.reserve(size);
+    for (auto const& obj : objects)
+    {
+        res.append(reinterpret_cast<char const*>(obj.key.data()), keySize);
+
+        std::uint32_t const blobSize = obj.blob.size();
+        res.push_back(static_cast<char>((blobSize >> 24) & 0xff));
+        res.push_back(static_cast<char>((blobSize >> 16) & 0xff));
+        res.push_back(static_cast<char>((blobSize >> 8) & 0xff));
+        res.push_back(static_cast<char>(blobSize & 0xff));
+
+        res.append(
+            reinterpret_cast<char const*>(obj.blob.data()), obj.blob.size());
+    }
+    return res;
+}
+
+std::optional<std::vector<Backend::LedgerObject>>
+decodeFrames(std::string_view data)
+{
+    std::vector<Backend::LedgerObject> objects;
+    auto const* ptr = reinterpret_cast<unsigned char const*>(data.data());
+    auto const* const end = ptr + data.size();
+    while (ptr != end)
+    {
+        if (end - ptr < static_cast<std::ptrdiff_t>(keySize + sizeFieldSize))
+            return {};
+
+        Backend::LedgerObject obj;
+        std::memcpy(obj.key.data(), ptr, keySize);
+        ptr += keySize;
+
+        std::uint32_t const blobSize = (std::uint32_t{ptr[0]} << 24) |
+            (std::uint32_t{ptr[1]} << 16) | (std::uint32_t{ptr[2]} << 8) |
+            std::uint32_t{ptr[3]};
+        ptr += sizeFieldSize;
+
+        if (static_cast<std::size_t>(end - ptr) < blobSize)
+            return {};
+
+        obj.blob.assign(ptr, ptr + blobSize);
+        ptr += blobSize;
+        objects.push_back(std::move(obj));
+    }
+    return objects;
+}
+
+std::string
+compress(std::string const& data)
+{
+    namespace zlib = boost::beast::zlib;
+
+    zlib::deflate_stream ds;
+    ds.reset(compressionLevel, windowBits, memLevel, zlib::Strategy::normal);
+
+    std::string res;
+    res.resize(ds.upper_bound(data.size()));
+
+    zlib::z_params zs;
+    zs.next_in = data.data();
+    zs.avail_in = data.size();
+    zs.next_out = res.data();
+    zs.avail_out = res.size();
+
+    boost::beast::error_code ec;
+    ds.write(zs, zlib::Flush::finish, ec);
+    // upper_bound guarantees the output fits, so everything is consumed
+    assert(!ec || ec == zlib::error::end_of_stream);
+    res.resize(zs.total_out);
+    return res;
+}
+
+std::optional<std::string>
+decompress(std::string const& data, std::size_t maxSize)
+{
+    namespace zlib = boost::beast::zlib;
+
+    zlib::inflate_stream is;
+    is.reset(windowBits);
+
+    zlib::z_params zs;
+    zs.next_in = data.data();
+    zs.avail_in = data.size();
+
+    std::string res;
+    std::size_t const chunkSize = std::max<std::size_t>(data.size() * 4, 4096);
+    while (true)
+    {
+        // one byte past maxSize tells a body that is too large from one that
+        // is exactly maxSize
+        auto const offset = res.size();
+        auto const size = std::min(chunkSize, maxSize + 1 - offset);
+        res.resize(offset + size);
+        zs.next_out = res.data() + offset;
+        zs.avail_out = size;
+
+        boost::beast::error_code ec;
+        is.write(zs, zlib::Flush::sync, ec);
+        res.resize(offset + size - zs.avail_out);
+
+        if (res.size() > maxSize)
+            return {};
+        if (ec == zlib::error::end_of_stream)
+            return res;
+        if (ec && ec != zlib::error::need_buffers)
+            return {};
+        // output space left over means the input ran out before the end of
+        // the stream
+        if (zs.avail_out != 0)
+            return {};
+    }
+}
+
+std::size_t
+maxPageSize(std::uint32_t limit)
+{
+    return std::size_t{limit} * (keySize + sizeFieldSize + maxObjectSize);
+}
+
+Page
+fetchPage(
+    BackendInterface const& backend,
+    Request const& request,
+    boost::asio::yield_context& yield)
+{
+    Page page;
+
+    auto const range = backend.fetchLedgerRange();
+    if (!range || request.ledgerIndex < range->minSequence ||
+        request.ledgerIndex > range->maxSequence)
+    {
+        page.status = http::status::not_found;
+        page.error = "lgrNotFound";
+        return page;
+    }
+    page.maxSequence = range->maxSequence;
+
+    if (!backend.cache().isFull())
+    {
+        page.status = http::status::service_unavailable;
+        page.error = "cacheNotFull";
+        return page;
+    }
+
+    // The state map is walked in the cache at the most recent sequence. A
+    // cache that lags the range falls back to the successor table, which
+    // does not hold the synthetic markers peers split the state map on, and
+    // such a page would look like the end of the range
+    auto const cacheIsCurrent = [&] {
+        return backend.cache().latestLedgerSequence() == range->maxSequence;
+    };
+    auto const notCurrent = [&page] {
+        page.status = http::status::service_unavailable;
+        page.error = "cacheNotCurrent";
+        page.objects.clear();
+        page.marker = {};
+        return page;
+    };
+    if (!cacheIsCurrent())
+        return notCurrent();
+
+    if (request.diff)
+    {
+        // same as the out of order diff marker in doLedgerData: anything
+        // deleted after ledgerIndex was skipped when walking the state map
+        auto diff = backend.fetchLedgerDiff(*request.diff, yield);
+        std::vector<ripple::uint256> keys;
+        for (auto&& [key, object] : diff)
+        {
+            if (!object.size())
+                keys.push_back(std::move(key));
+        }
+        auto objs =
+            backend.fetchLedgerObjects(keys, request.ledgerIndex, yield);
+        for (size_t i = 0; i < objs.size(); ++i)
+        {
+            if (objs[i].size())
+                page.objects.push_back(
+                    {std::move(keys[i]), std::move(objs[i])});
+        }
+        return page;
+    }
+
+    auto res = backend.fetchLedgerPage(
+        request.marker, request.ledgerIndex, request.limit, true, yield);
+
+    if (request.end)
+    {
+        auto const pastEnd = std::find_if(
+            res.objects.begin(), res.objects.end(), [&](auto const& obj) {
+                return obj.key >= *request.end;
+            });
+        if (pastEnd != res.objects.end())
+        {
+            res.objects.erase(pastEnd, res.objects.end());
+            res.cursor = {};
+        }
+        else if (res.cursor && *res.cursor >= *request.end)
+        {
+            res.cursor = {};
+        }
+    }
+
+    // the cache may have moved on while the page was read
+    if (!cacheIsCurrent() ||
+        backend.fetchLedgerRange()->maxSequence != range->maxSequence)
+        return notCurrent();
+
+    page.objects = std::move(res.objects);
+    page.marker = res.cursor;
+    return page;
+}
+
+http::response<http::string_body>
+makeResponse(Page const& page, bool compress, unsigned version)
+{
+    http::response<http::string_body> res{page.status, version};
+    res.set(
+        http::field::server, "clio-server-" + Build::getClioVersionString());
+    res.set(maxSequenceHeader, std::to_string(page.maxSequence));
+
+    if (page.status != http::status::ok)
+    {
+        res.set(http::field::content_type, "text/plain");
+        res.body() = page.error;
+    }
+    else
+    {
+        res.set(http::field::content_type, "application/octet-stream");
+        if (page.marker)
+            res.set(markerHeader, ripple::strHex(*page.marker));
+
+        if (compress)
+        {
+            res.set(encodingHeader, "deflate");
+            res.body() = CacheTransfer::compress(encodeFrames(page.objects));
+        }
+        else
+        {
+            res.body() = encodeFrames(page.objects);
+        }
+    }
+
+    res.prepare_payload();
+    return res;
+}
+
+std::optional<Page>
+requestPage(
+    boost::beast::tcp_stream& stream,
+    std::string const& host,
+    Request const& request,
+    boost::asio::yield_context& yield)
+{
+    boost::beast::error_code ec;
+
+    http::request<http::empty_body> req{
+        http::verb::get, makeTarget(request), 11};
+    req.set(http::field::host, host);
+    req.keep_alive(true);
+
+    http::async_write(stream, req, yield[ec]);
+    if (ec)
+    {
+        gLog.error() << "Error writing cache transfer request = "
+                     << ec.message();
+        return {};
+    }
+
+    // pages are bounded by the number of objects requested, not by beast's
+    // default 8MB. A peer sending more than that is not trusted further
+    auto const maxSize = maxPageSize(request.limit);
+    boost::beast::flat_buffer buffer;
+    http::response_parser<http::string_body> parser;
+    parser.body_limit(maxSize);
+    http::async_read(stream, buffer, parser, yield[ec]);
+    if (ec)
+    {
+        gLog.error() << "Error reading cache transfer response = "
+                     << ec.message();
+        return {};
+    }
+
+    auto& res = parser.get();
+
+    Page page;
+    page.status = res.result();
+    if (auto const it = res.find(maxSequenceHeader); it != res.end())
+    {
+        page.maxSequence = parseNumber<std::uint32_t>(toStringView(it->value()))
+                               .value_or(0);
+    }
+
+    if (page.status != http::status::ok)
+    {
+        page.error = res.body();
+        return page;
+    }
+
+    // older clio nodes answer any GET request with a static html page
+    if (res[http::field::content_type] != "application/octet-stream")
+    {
+        gLog.warn() << "Peer does not support binary cache transfer";
+        return {};
+    }
+
+    if (auto const it = res.find(markerHeader); it != res.end())
+    {
+        if (!(page.marker = parseKey(toStringView(it->value()))))
+        {
+            gLog.error() << "Failed to parse cache transfer marker";
+            return {};
+        }
+    }
+
+    std::optional<std::vector<Backend::LedgerObject>> objects;
+    if (res[encodingHeader] == "deflate")
+    {
+        auto const body = decompress(res.body(), maxSize);
+        if (!body)
+        {
+            gLog.error() << "Failed to decompress cache transfer page";
+            return {};
+        }
+        objects = decodeFrames(*body);
+    }
+    else
+    {
+        objects = decodeFrames(res.body());
+    }
+
+    if (!objects)
+    {
+        gLog.error() << "Malformed cache transfer page";
+        return {};
+    }
+
+    page.objects = std::move(*objects);
+    return page;
+}
+
+}  // namespace CacheTransfer
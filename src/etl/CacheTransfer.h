@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <ripple/basics/base_uint.h>
+#include <backend/BackendInterface.h>
+
+#include <boost/asio/spawn.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Binary cache transfer between clio nodes.
+///
+/// A clio node with a full cache serves pages of ledger state over plain HTTP
+/// at CacheTransfer::target. Each response body is a sequence of frames, one
+/// per ledger object:
+///
+///     | key (32 bytes) | blob size (4 bytes, big endian) | blob |
+///
+/// optionally deflated as a whole. A peer downloading the cache requests
+/// several disjoint key ranges at once, each over its own connection, so the
+/// transfer is bound by the network rather than by JSON serialization.
+namespace CacheTransfer {
+
+static constexpr char const* target = "/cache_transfer";
+
+/// Response header holding the cursor of the next page within the range.
+/// Absent when the range has been fully transferred.
+static constexpr char const* markerHeader = "X-Clio-Marker";
+/// Response header holding the most recent sequence of the serving node.
+static constexpr char const* maxSequenceHeader = "X-Clio-Max-Sequence";
+/// Response header set to "deflate" when the body is compressed
+static constexpr char const* encodingHeader = "X-Clio-Encoding";
+
+static constexpr std::uint32_t defaultLimit = 16384;
+static constexpr std::uint32_t maxLimit = 65536;
+
+/// Largest ledger object a page is expected to hold. The largest objects of
+/// the XRP ledger, full NFT pages, are around 10KB
+static constexpr std::size_t maxObjectSize = 16384;
+
+struct Request
+{
+    std::uint32_t ledgerIndex = 0;
+    // walk the state map from (marker, end). Unset means the first/last key
+    std::optional<ripple::uint256> marker;
+    std::optional<ripple::uint256> end;
+    std::uint32_t limit = defaultLimit;
+    // when set, return the objects at ledgerIndex that were deleted in the
+    // given ledger instead of walking the state map. See doLedgerData
+    std::optional<std::uint32_t> diff;
+    bool compress = false;
+};
+
+struct Page
+{
+    boost::beast::http::status status = boost::beast::http::status::ok;
+    // error token when status is not ok
+    std::string error;
+    std::vector<Backend::LedgerObject> objects;
+    std::optional<ripple::uint256> marker;
+    std::uint32_t maxSequence = 0;
+};
+
+/// Build the request target (path and query string) for the given request
+std::string
+makeTarget(Request const& request);
+
+/// Parse a request target. Returns nullopt if the target is not a cache
+/// transfer request or the query string is malformed
+std::optional<Request>
+parseTarget(std::string_view target);
+
+std::string
+encodeFrames(std::vector<Backend::LedgerObject> const& objects);
+
+std::optional<std::vector<Backend::LedgerObject>>
+decodeFrames(std::string_view data);
+
+std::string
+compress(std::string const& data);
+
+/// Inflate a page body. Returns nullopt if the data is malformed or inflates
+/// to more than maxSize bytes
+std::optional<std::string>
+decompress(std::string const& data, std::size_t maxSize);
+
+/// Largest body of a page of at most limit objects, compressed or not
+std::size_t
+maxPageSize(std::uint32_t limit);
+
+/// Serve one page of the cache transfer. Only a node with a full cache serves
+/// state, since the state map is walked using the cache.
+Page
+fetchPage(
+    BackendInterface const& backend,
+    Request const& request,
+    boost::asio::yield_context& yield);
+
+/// Serialize a served page into an HTTP response
+boost::beast::http::response<boost::beast::http::string_body>
+makeResponse(Page const& page, bool compress, unsigned version);
+
+/// Request one page from a peer over an already connected stream
+std::optional<Page>
+requestPage(
+    boost::beast::tcp_stream& stream,
+    std::string const& host,
+    Request const& request,
+    boost::asio::yield_context& yield);
+
+}  // namespace CacheTransfer
@@ -20,11 +20,15 @@
 #pragma once
 
 #include <ripple/basics/base_uint.h>
+#include <cassert>
 #include <condition_variable>
+#include <cstdint>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <sstream>
+#include <vector>
 
 /// This datastructure is used to keep track of the sequence of the most recent
 /// ledger validated by the network. There are two methods that will wait until
@@ -169,24 +173,40 @@ public:
             cv_.notify_all();
         return ret;
     }
+
+    /// @return number of elements in the queue
+    std::size_t
+    size() const
+    {
+        std::scoped_lock lck(m_);
+        return queue_.size();
+    }
 };
 
+/// Upper bound on the number of markers passed to getMarkers()
+static constexpr size_t maxMarkers = 4096;
+
 /// Parititions the uint256 keyspace into numMarkers partitions, each of equal
-/// size.
+/// size. The partitions are split on the leading 8 bytes of the key, so any
+/// number of markers up to maxMarkers yields balanced ranges
 inline std::vector<ripple::uint256>
 getMarkers(size_t numMarkers)
 {
-    assert(numMarkers <= 256);
+    assert(numMarkers > 0 && numMarkers <= maxMarkers);
 
-    unsigned char incr = 256 / numMarkers;
+    std::uint64_t const incr =
+        std::numeric_limits<std::uint64_t>::max() / numMarkers;
 
     std::vector<ripple::uint256> markers;
     markers.reserve(numMarkers);
-    ripple::uint256 base{0};
     for (size_t i = 0; i < numMarkers; ++i)
     {
-        markers.push_back(base);
-        base.data()[0] += incr;
+        ripple::uint256 marker{0};
+        std::uint64_t prefix = incr * i;
+        // keys compare as big endian byte strings
+        for (int j = 7; j >= 0; --j, prefix >>= 8)
+            marker.data()[j] = static_cast<unsigned char>(prefix & 0xff);
+        markers.push_back(marker);
     }
     return markers;
 }
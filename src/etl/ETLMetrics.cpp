@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <etl/ETLMetrics.h>
+
+#include <algorithm>
+
+namespace {
+
+constexpr std::array<char const*, ETLMetrics::numStages> stageNames = {
+    "extract",
+    "decode",
+    "write",
+    "finish_writes",
+    "cache_update",
+    "publish",
+};
+
+// nearest rank percentile of sorted samples
+ETLMetrics::Duration
+percentile(std::vector<ETLMetrics::Duration> const& sorted, double p)
+{
+    if (sorted.empty())
+        return ETLMetrics::Duration{0};
+    auto rank = static_cast<std::size_t>(p * sorted.size());
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+}  // namespace
+
+ETLMetrics::LedgerTiming&
+ETLMetrics::timing(std::uint32_t sequence)
+{
+    if (!inFlight_.count(sequence) && inFlight_.size() >= maxInFlight)
+        inFlight_.erase(inFlight_.begin());
+    auto& timing = inFlight_[sequence];
+    timing.sequence = sequence;
+    return timing;
+}
+
+void
+ETLMetrics::record(Stage stage, std::uint32_t sequence, Duration duration)
+{
+    auto const index = static_cast<std::size_t>(stage);
+
+    std::scoped_lock lck(mtx_);
+    auto& histogram = histograms_[index];
+    histogram.recent.push_back(duration);
+    if (histogram.recent.size() > window_)
+        histogram.recent.pop_front();
+    ++histogram.count;
+    histogram.max = std::max(histogram.max, duration);
+
+    timing(sequence).stages[index] += duration;
+}
+
+void
+ETLMetrics::recordSize(
+    std::uint32_t sequence,
+    std::size_t numTransactions,
+    std::size_t numObjects)
+{
+    std::scoped_lock lck(mtx_);
+    auto& t = timing(sequence);
+    t.numTransactions = numTransactions;
+    t.numObjects = numObjects;
+}
+
+void
+ETLMetrics::finishLedger(std::uint32_t sequence)
+{
+    std::scoped_lock lck(mtx_);
+    auto node = inFlight_.extract(sequence);
+    if (node.empty())
+        return;
+
+    auto& t = node.mapped();
+    for (auto const& d : t.stages)
+        t.total += d;
+
+    auto it = std::find_if(
+        slowest_.begin(), slowest_.end(), [&](LedgerTiming const& other) {
+            return other.total < t.total;
+        });
+    if (static_cast<std::size_t>(it - slowest_.begin()) >= numSlowest_)
+        return;
+    slowest_.insert(it, std::move(t));
+    if (slowest_.size() > numSlowest_)
+        slowest_.pop_back();
+}
+
+void
+ETLMetrics::setQueueDepth(std::string const& queue, std::size_t depth)
+{
+    std::scoped_lock lck(mtx_);
+    queueDepths_[queue] = depth;
+}
+
+boost::json::object
+ETLMetrics::report() const
+{
+    std::scoped_lock lck(mtx_);
+    boost::json::object result;
+
+    // durations are reported in microseconds
+    boost::json::object stages;
+    for (std::size_t i = 0; i < numStages; ++i)
+    {
+        auto const& histogram = histograms_[i];
+        std::vector<Duration> sorted{
+            histogram.recent.begin(), histogram.recent.end()};
+        std::sort(sorted.begin(), sorted.end());
+
+        boost::json::object stage;
+        stage["count"] = histogram.count;
+        stage["p50_us"] = percentile(sorted, 0.5).count();
+        stage["p99_us"] = percentile(sorted, 0.99).count();
+        stage["max_us"] = histogram.max.count();
+        stage["window"] = sorted.size();
+        stages[stageNames[i]] = std::move(stage);
+    }
+    result["stages"] = std::move(stages);
+
+    boost::json::object queues;
+    for (auto const& [queue, depth] : queueDepths_)
+        queues[queue] = depth;
+    result["queue_depths"] = std::move(queues);
+
+    boost::json::array slowest;
+    for (auto const& t : slowest_)
+    {
+        boost::json::object ledger;
+        ledger["ledger_index"] = t.sequence;
+        ledger["total_us"] = t.total.count();
+        ledger["transactions"] = t.numTransactions;
+        ledger["objects"] = t.numObjects;
+        for (std::size_t i = 0; i < numStages; ++i)
+            ledger[std::string{stageNames[i]} + "_us"] =
+                t.stages[i].count();
+        slowest.push_back(std::move(ledger));
+    }
+    result["slowest_ledgers"] = std::move(slowest);
+
+    return result;
+}
@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <boost/json.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Timing of the stages of the ETL pipeline, per ledger.
+ *
+ * Keeps a window of the most recent samples of each stage, from which
+ * percentiles are computed on report, the depths of the pipeline queues as
+ * last observed, and the slowest ledgers seen with their per stage
+ * breakdown. Reported under "etl_metrics" in ReportingETL::getInfo.
+ *
+ * Stages of a ledger are recorded from different threads, so every method
+ * is thread safe.
+ */
+class ETLMetrics
+{
+public:
+    enum class Stage : std::size_t {
+        extract,       // fetching the ledger from rippled
+        decode,        // deserializing transactions and metadata
+        write,         // issuing the writes of the ledger
+        finishWrites,  // waiting for the writes and committing the range
+        cacheUpdate,   // applying the ledger diff to the cache
+        publish,       // publishing to subscribers
+    };
+    static constexpr std::size_t numStages = 6;
+
+    using Duration = std::chrono::microseconds;
+
+    /// @param window number of recent samples kept per stage
+    /// @param numSlowest number of slowest ledgers kept
+    explicit ETLMetrics(std::size_t window = 1024, std::size_t numSlowest = 10)
+        : window_(window), numSlowest_(numSlowest)
+    {
+    }
+
+    /// Record the time a stage took for the given ledger
+    void
+    record(Stage stage, std::uint32_t sequence, Duration duration);
+
+    /// Record the size of the ledger, for the slow ledger breakdown
+    void
+    recordSize(
+        std::uint32_t sequence,
+        std::size_t numTransactions,
+        std::size_t numObjects);
+
+    /// The ledger went through every stage. Its total time is compared to
+    /// the slowest ledgers so far
+    void
+    finishLedger(std::uint32_t sequence);
+
+    /// Set the last observed depth of a pipeline queue
+    void
+    setQueueDepth(std::string const& queue, std::size_t depth);
+
+    boost::json::object
+    report() const;
+
+private:
+    struct Histogram
+    {
+        std::deque<Duration> recent;
+        std::uint64_t count = 0;
+        Duration max{0};
+    };
+
+    struct LedgerTiming
+    {
+        std::uint32_t sequence = 0;
+        std::array<Duration, numStages> stages{};
+        Duration total{0};
+        std::size_t numTransactions = 0;
+        std::size_t numObjects = 0;
+    };
+
+    // ledgers that have not finished every stage yet are dropped, oldest
+    // first, past this many. Happens when the pipeline is stopped
+    static constexpr std::size_t maxInFlight = 256;
+
+    std::size_t const window_;
+    std::size_t const numSlowest_;
+
+    mutable std::mutex mtx_;
+    std::array<Histogram, numStages> histograms_;
+    std::map<std::uint32_t, LedgerTiming> inFlight_;
+    // sorted by decreasing total
+    std::vector<LedgerTiming> slowest_;
+    std::map<std::string, std::size_t> queueDepths_;
+
+    LedgerTiming&
+    timing(std::uint32_t sequence);
+};
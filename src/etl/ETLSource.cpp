@@ -562,18 +562,30 @@ ETLSourceImpl<Derived>::handleMessage()
     }
 }
 
+/// A page of ledger objects downloaded by an AsyncCallData, waiting to be
+/// written by one of the writers of loadInitialLedger
+struct LedgerDataPage
+{
+    std::uint32_t sequence;
+    std::unique_ptr<org::xrpl::rpc::v1::GetLedgerDataResponse> data;
+    // number of leading objects of data that fall within the marker's range
+    int numObjects;
+    // key of the object preceding the first one of the page within the same
+    // marker. Empty for the first page of a marker
+    std::string predecessor;
+};
+
 class AsyncCallData
 {
     clio::Logger log_{"ETL"};
 
-    std::unique_ptr<org::xrpl::rpc::v1::GetLedgerDataResponse> cur_;
     std::unique_ptr<org::xrpl::rpc::v1::GetLedgerDataResponse> next_;
 
     org::xrpl::rpc::v1::GetLedgerDataRequest request_;
     std::unique_ptr<grpc::ClientContext> context_;
 
     grpc::Status status_;
-    unsigned char nextPrefix_;
+    std::optional<ripple::uint256> nextMarker_;
 
     std::string lastKey_;
 
@@ -582,6 +594,7 @@ public:
         uint32_t seq,
         ripple::uint256 const& marker,
         std::optional<ripple::uint256> const& nextMarker)
+        : nextMarker_(nextMarker)
     {
         request_.mutable_ledger()->set_sequence(seq);
         if (marker.isNonZero())
@@ -589,21 +602,12 @@ public:
             request_.set_marker(marker.data(), marker.size());
         }
         request_.set_user("ETL");
-        nextPrefix_ = 0x00;
-        if (nextMarker)
-            nextPrefix_ = nextMarker->data()[0];
-
-        unsigned char prefix = marker.data()[0];
 
         log_.debug() << "Setting up AsyncCallData. marker = "
-                     << ripple::strHex(marker)
-                     << " . prefix = " << ripple::strHex(std::string(1, prefix))
-                     << " . nextPrefix_ = "
-                     << ripple::strHex(std::string(1, nextPrefix_));
-
-        assert(nextPrefix_ > prefix || nextPrefix_ == 0x00);
+                     << ripple::strHex(marker) << " . nextMarker_ = "
+                     << (nextMarker_ ? ripple::strHex(*nextMarker_) : "none");
 
-        cur_ = std::make_unique<org::xrpl::rpc::v1::GetLedgerDataResponse>();
+        assert(!nextMarker_ || *nextMarker_ > marker);
 
         next_ = std::make_unique<org::xrpl::rpc::v1::GetLedgerDataResponse>();
 
@@ -611,13 +615,15 @@ public:
     }
 
     enum class CallStatus { MORE, DONE, ERRORED };
+    /// Handle a completed request. The next request of the marker, if any, is
+    /// issued right away; the downloaded objects are handed out as a page, to
+    /// be written by the caller
     CallStatus
     process(
-        std::unique_ptr<org::xrpl::rpc::v1::XRPLedgerAPIService::Stub>& stub,
+        org::xrpl::rpc::v1::XRPLedgerAPIService::Stub& stub,
         grpc::CompletionQueue& cq,
-        BackendInterface& backend,
         bool abort,
-        bool cacheOnly = false)
+        std::optional<LedgerDataPage>& page)
     {
         log_.trace() << "Processing response. "
                      << "Marker prefix = " << getMarkerPrefix();
@@ -639,73 +645,56 @@ public:
                            "secure_gateway is set correctly at the ETL source";
         }
 
-        std::swap(cur_, next_);
-
-        bool more = true;
-
-        // if no marker returned, we are done
-        if (cur_->marker().size() == 0)
-            more = false;
+        auto data = std::move(next_);
+        next_ = std::make_unique<org::xrpl::rpc::v1::GetLedgerDataResponse>();
 
-        // if returned marker is greater than our end, we are done
-        unsigned char prefix = cur_->marker()[0];
-        if (nextPrefix_ != 0x00 && prefix >= nextPrefix_)
-            more = false;
+        // if no marker returned, we are done. if returned marker is past our
+        // end, we are done
+        bool const more =
+            data->marker().size() != 0 && inRange(data->marker());
 
         // if we are not done, make the next async call
         if (more)
         {
-            request_.set_marker(std::move(cur_->marker()));
+            request_.set_marker(data->marker());
             call(stub, cq);
         }
 
-        log_.trace() << "Writing objects";
-        std::vector<Backend::LedgerObject> cacheUpdates;
-        cacheUpdates.reserve(cur_->ledger_objects().objects_size());
-        for (int i = 0; i < cur_->ledger_objects().objects_size(); ++i)
+        // objects come sorted by key, so only a tail of the last page can be
+        // past our end
+        auto const& objects = data->ledger_objects().objects();
+        int numObjects = objects.size();
+        if (!more)
         {
-            auto& obj = *(cur_->mutable_ledger_objects()->mutable_objects(i));
-            if (!more && nextPrefix_ != 0x00)
-            {
-                if (((unsigned char)obj.key()[0]) >= nextPrefix_)
-                    continue;
-            }
-            cacheUpdates.push_back(
-                {*ripple::uint256::fromVoidChecked(obj.key()),
-                 {obj.mutable_data()->begin(), obj.mutable_data()->end()}});
-            if (!cacheOnly)
-            {
-                if (lastKey_.size())
-                    backend.writeSuccessor(
-                        std::move(lastKey_),
-                        request_.ledger().sequence(),
-                        std::string{obj.key()});
-                lastKey_ = obj.key();
-                backend.writeNFTs(getNFTDataFromObj(
-                    request_.ledger().sequence(), obj.key(), obj.data()));
-                backend.writeLedgerObject(
-                    std::move(*obj.mutable_key()),
-                    request_.ledger().sequence(),
-                    std::move(*obj.mutable_data()));
-            }
+            while (numObjects > 0 && !inRange(objects[numObjects - 1].key()))
+                --numObjects;
         }
-        backend.cache().update(
-            cacheUpdates, request_.ledger().sequence(), cacheOnly);
-        log_.trace() << "Wrote objects";
+
+        std::string predecessor = lastKey_;
+        if (numObjects > 0)
+            lastKey_ = objects[numObjects - 1].key();
+
+        page = LedgerDataPage{
+            request_.ledger().sequence(),
+            std::move(data),
+            numObjects,
+            std::move(predecessor)};
 
         return more ? CallStatus::MORE : CallStatus::DONE;
     }
 
+    /// Request the page at the current marker. After an error, calling this
+    /// again retries the failed page, possibly from another source
     void
     call(
-        std::unique_ptr<org::xrpl::rpc::v1::XRPLedgerAPIService::Stub>& stub,
+        org::xrpl::rpc::v1::XRPLedgerAPIService::Stub& stub,
         grpc::CompletionQueue& cq)
     {
         context_ = std::make_unique<grpc::ClientContext>();
 
         std::unique_ptr<grpc::ClientAsyncResponseReader<
             org::xrpl::rpc::v1::GetLedgerDataResponse>>
-            rpc(stub->PrepareAsyncGetLedgerData(context_.get(), request_, &cq));
+            rpc(stub.PrepareAsyncGetLedgerData(context_.get(), request_, &cq));
 
         rpc->StartCall();
 
@@ -726,18 +715,99 @@ public:
     {
         return lastKey_;
     }
+
+private:
+    bool
+    inRange(std::string const& key) const
+    {
+        if (!nextMarker_)
+            return true;
+        auto const k = ripple::uint256::fromVoidChecked(key);
+        return k && *k < *nextMarker_;
+    }
 };
 
+/// Write a downloaded page to the cache and, unless cacheOnly, to the
+/// database together with the successor of each object
+static void
+writeLedgerDataPage(
+    BackendInterface& backend,
+    LedgerDataPage& page,
+    bool cacheOnly)
+{
+    auto& objects = *page.data->mutable_ledger_objects()->mutable_objects();
+    std::string lastKey = std::move(page.predecessor);
+
+    std::vector<Backend::LedgerObject> cacheUpdates;
+    cacheUpdates.reserve(page.numObjects);
+    // NFTs pre-dating the initial ledger are only ever seen here, so they
+    // are extracted from the NFTokenPages of the page and written at once
+    std::vector<NFTsData> nfts;
+    for (int i = 0; i < page.numObjects; ++i)
+    {
+        auto& obj = objects[i];
+        cacheUpdates.push_back(
+            {*ripple::uint256::fromVoidChecked(obj.key()),
+             {obj.mutable_data()->begin(), obj.mutable_data()->end()}});
+        if (!cacheOnly)
+        {
+            if (lastKey.size())
+                backend.writeSuccessor(
+                    std::move(lastKey), page.sequence, std::string{obj.key()});
+            lastKey = obj.key();
+            if (isNFTokenPage(obj.data()))
+            {
+                auto pageNFTs =
+                    getNFTDataFromObj(page.sequence, obj.key(), obj.data());
+                nfts.insert(
+                    nfts.end(),
+                    std::make_move_iterator(pageNFTs.begin()),
+                    std::make_move_iterator(pageNFTs.end()));
+            }
+            backend.writeLedgerObject(
+                std::move(*obj.mutable_key()),
+                page.sequence,
+                std::move(*obj.mutable_data()));
+        }
+    }
+    if (!nfts.empty())
+        backend.writeNFTs(std::move(nfts));
+    backend.keyIndex().update(cacheUpdates, page.sequence, cacheOnly);
+    backend.cache().update(std::move(cacheUpdates), page.sequence, cacheOnly);
+}
+
 template <class Derived>
 bool
 ETLSourceImpl<Derived>::loadInitialLedger(
     uint32_t sequence,
     uint32_t numMarkers,
-    bool cacheOnly)
+    bool cacheOnly,
+    std::vector<ETLSource*> const& helpers)
 {
     if (!stub_)
         return false;
 
+    // markers are striped over this source and the helpers. A marker whose
+    // source fails is moved to the next source that has not failed
+    std::vector<org::xrpl::rpc::v1::XRPLedgerAPIService::Stub*> stubs{
+        stub_.get()};
+    for (auto* helper : helpers)
+    {
+        auto* stub = helper ? helper->grpcStub() : nullptr;
+        if (stub && std::find(stubs.begin(), stubs.end(), stub) == stubs.end())
+            stubs.push_back(stub);
+    }
+    std::vector<bool> failed(stubs.size(), false);
+    auto const nextHealthy = [&](size_t from) -> std::optional<size_t> {
+        for (size_t i = 1; i <= stubs.size(); ++i)
+        {
+            auto const idx = (from + i) % stubs.size();
+            if (!failed[idx])
+                return idx;
+        }
+        return {};
+    };
+
     grpc::CompletionQueue cq;
 
     void* tag;
@@ -755,11 +825,39 @@ ETLSourceImpl<Derived>::loadInitialLedger(
         calls.emplace_back(sequence, markers[i], nextMarker);
     }
 
+    // Downloaded pages are written by a pool of writers, so that this thread
+    // only issues requests and every marker always has one in flight. The
+    // queue is bounded: if the database falls behind, this thread blocks and
+    // the download slows down instead of piling up pages in memory
+    auto const numWriters = std::clamp<size_t>(
+        std::thread::hardware_concurrency(), 1, calls.size());
+    ThreadSafeQueue<std::optional<LedgerDataPage>> pages(numWriters * 4);
+    std::vector<std::thread> writers;
+    for (size_t i = 0; i < numWriters; ++i)
+    {
+        writers.emplace_back([this, &pages, cacheOnly]() {
+            while (auto page = pages.pop())
+                writeLedgerDataPage(*backend_, *page, cacheOnly);
+        });
+    }
+    auto const stopWriters = [&]() {
+        for (size_t i = 0; i < numWriters; ++i)
+            pages.push({});
+        for (auto& t : writers)
+            t.join();
+    };
+
     log_.debug() << "Starting data download for ledger " << sequence
-                 << ". Using source = " << toString();
+                 << ". Using source = " << toString() << ". sources = "
+                 << stubs.size() << ". markers = " << calls.size()
+                 << ". writers = " << numWriters;
 
-    for (auto& c : calls)
-        c.call(stub_, cq);
+    std::vector<size_t> assigned(calls.size());
+    for (size_t i = 0; i < calls.size(); ++i)
+    {
+        assigned[i] = i % stubs.size();
+        calls[i].call(*stubs[assigned[i]], cq);
+    }
 
     size_t numFinished = 0;
     bool abort = false;
@@ -775,13 +873,32 @@ ETLSourceImpl<Derived>::loadInitialLedger(
         if (!ok)
         {
             log_.error() << "loadInitialLedger - ok is false";
+            stopWriters();
             return false;
             // handle cancelled
         }
         else
         {
             log_.trace() << "Marker prefix = " << ptr->getMarkerPrefix();
-            auto result = ptr->process(stub_, cq, *backend_, abort, cacheOnly);
+            auto const index = static_cast<size_t>(ptr - calls.data());
+            std::optional<LedgerDataPage> page;
+            auto result =
+                ptr->process(*stubs[assigned[index]], cq, abort, page);
+            if (page)
+                pages.push(std::move(page));
+            if (result == AsyncCallData::CallStatus::ERRORED && !abort)
+            {
+                failed[assigned[index]] = true;
+                if (auto next = nextHealthy(assigned[index]); next)
+                {
+                    log_.warn() << "Moving marker to source " << *next
+                                << " after an error. sources = "
+                                << stubs.size();
+                    assigned[index] = *next;
+                    ptr->call(*stubs[*next], cq);
+                    continue;
+                }
+            }
             if (result != AsyncCallData::CallStatus::MORE)
             {
                 numFinished++;
@@ -803,11 +920,14 @@ ETLSourceImpl<Derived>::loadInitialLedger(
             }
         }
     }
+    // every page must be in the cache before it is marked full
+    stopWriters();
     log_.info() << "Finished loadInitialLedger. cache size = "
                 << backend_->cache().size();
     size_t numWrites = 0;
     if (!abort)
     {
+        backend_->keyIndex().setFull();
         backend_->cache().setFull();
         if (!cacheOnly)
         {
@@ -943,7 +1063,7 @@ ETLLoadBalancer::ETLLoadBalancer(
     std::shared_ptr<NetworkValidatedLedgers> nwvl)
 {
     if (auto value = config.maybeValue<uint32_t>("num_markers"); value)
-        downloadRanges_ = std::clamp(*value, 1u, 256u);
+        downloadRanges_ = std::clamp<uint32_t>(*value, 1, maxMarkers);
     else if (backend->fetchLedgerRange())
         downloadRanges_ = 4;
 
@@ -955,6 +1075,7 @@ ETLLoadBalancer::ETLLoadBalancer(
         sources_.push_back(std::move(source));
         log_.info() << "Added etl source - " << sources_.back()->toString();
     }
+    stats_.resize(sources_.size());
 }
 
 void
@@ -962,8 +1083,15 @@ ETLLoadBalancer::loadInitialLedger(uint32_t sequence, bool cacheOnly)
 {
     execute(
         [this, &sequence, cacheOnly](auto& source) {
-            bool res =
-                source->loadInitialLedger(sequence, downloadRanges_, cacheOnly);
+            // spread the download over every other source that has the ledger
+            std::vector<ETLSource*> helpers;
+            for (auto& other : sources_)
+            {
+                if (other != source && other->hasLedger(sequence))
+                    helpers.push_back(other.get());
+            }
+            bool res = source->loadInitialLedger(
+                sequence, downloadRanges_, cacheOnly, helpers);
             if (!res)
             {
                 log_.error() << "Failed to download initial ledger."
@@ -1148,56 +1276,95 @@ ETLSourceImpl<Derived>::requestFromRippled(
     }
 }
 
+std::optional<size_t>
+ETLLoadBalancer::pickSource(
+    uint32_t ledgerSequence,
+    std::vector<bool> const& skip) const
+{
+    std::optional<size_t> best;
+    double bestWait = 0;
+
+    std::scoped_lock lck(statsMtx_);
+    for (size_t i = 0; i < sources_.size(); ++i)
+    {
+        // Originally, it was (source->hasLedger(ledgerSequence) || true)
+        /* Sometimes rippled has ledger but doesn't actually know. However,
+        but this does NOT happen in the normal case and is safe to remove
+        This || true is only needed when loading full history standalone */
+        if (skip[i] || !sources_[i]->hasLedger(ledgerSequence))
+            continue;
+
+        auto const wait = stats_[i].latencyMs * (stats_[i].inFlight + 1);
+        if (!best || wait < bestWait)
+        {
+            best = i;
+            bestWait = wait;
+        }
+    }
+    return best;
+}
+
 template <class Func>
 bool
 ETLLoadBalancer::execute(Func f, uint32_t ledgerSequence)
 {
-    srand((unsigned)time(0));
-    auto sourceIdx = rand() % sources_.size();
-    auto numAttempts = 0;
+    // weight of a new latency sample in the moving average
+    static constexpr double alpha = 0.2;
+
+    std::vector<bool> tried(sources_.size(), false);
 
     while (true)
     {
-        auto& source = sources_[sourceIdx];
+        auto sourceIdx = pickSource(ledgerSequence, tried);
+        if (!sourceIdx)
+        {
+            log_.info() << "Ledger sequence " << ledgerSequence
+                        << " is not yet available from any configured sources. "
+                        << "Sleeping and trying again";
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            tried.assign(sources_.size(), false);
+            continue;
+        }
+        tried[*sourceIdx] = true;
+        auto& source = sources_[*sourceIdx];
 
         log_.debug() << "Attempting to execute func. ledger sequence = "
                      << ledgerSequence << " - source = " << source->toString();
-        // Originally, it was (source->hasLedger(ledgerSequence) || true)
-        /* Sometimes rippled has ledger but doesn't actually know. However,
-        but this does NOT happen in the normal case and is safe to remove
-        This || true is only needed when loading full history standalone */
-        if (source->hasLedger(ledgerSequence))
+
         {
-            bool res = f(source);
-            if (res)
-            {
-                log_.debug() << "Successfully executed func at source = "
-                             << source->toString()
-                             << " - ledger sequence = " << ledgerSequence;
-                break;
-            }
-            else
-            {
-                log_.warn() << "Failed to execute func at source = "
-                            << source->toString()
-                            << " - ledger sequence = " << ledgerSequence;
-            }
+            std::scoped_lock lck(statsMtx_);
+            ++stats_[*sourceIdx].inFlight;
+        }
+        auto const start = std::chrono::steady_clock::now();
+        bool res = f(source);
+        std::chrono::duration<double, std::milli> const elapsed =
+            std::chrono::steady_clock::now() - start;
+        {
+            std::scoped_lock lck(statsMtx_);
+            auto& stats = stats_[*sourceIdx];
+            --stats.inFlight;
+            // a failure counts as a slow request, so that a failing source is
+            // picked less often until it recovers
+            auto const sample = res ? elapsed.count()
+                                    : std::max(elapsed.count(), 1000.0) * 2;
+            stats.latencyMs = stats.latencyMs == 0
+                ? sample
+                : (1 - alpha) * stats.latencyMs + alpha * sample;
+        }
+
+        if (res)
+        {
+            log_.debug() << "Successfully executed func at source = "
+                         << source->toString()
+                         << " - ledger sequence = " << ledgerSequence;
+            break;
         }
         else
         {
-            log_.warn() << "Ledger not present at source = "
+            log_.warn() << "Failed to execute func at source = "
                         << source->toString()
                         << " - ledger sequence = " << ledgerSequence;
         }
-        sourceIdx = (sourceIdx + 1) % sources_.size();
-        numAttempts++;
-        if (numAttempts % sources_.size() == 0)
-        {
-            log_.info() << "Ledger sequence " << ledgerSequence
-                        << " is not yet available from any configured sources. "
-                        << "Sleeping and trying again";
-            std::this_thread::sleep_for(std::chrono::seconds(2));
-        }
     }
     return true;
 }
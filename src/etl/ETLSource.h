@@ -131,11 +131,19 @@ public:
         bool getObjects = true,
         bool getObjectNeighbors = false) = 0;
 
+    /// Download a ledger in full. The markers are spread over this source
+    /// and the helpers, and the markers of a helper that fails are moved to
+    /// the other sources
     virtual bool
     loadInitialLedger(
         uint32_t sequence,
         std::uint32_t numMarkers,
-        bool cacheOnly = false) = 0;
+        bool cacheOnly = false,
+        std::vector<ETLSource*> const& helpers = {}) = 0;
+
+    /// @return the gRPC stub of this source, or nullptr if there is none
+    virtual org::xrpl::rpc::v1::XRPLedgerAPIService::Stub*
+    grpcStub() = 0;
 
     virtual std::optional<boost::json::object>
     forwardToRippled(
@@ -433,13 +441,21 @@ public:
 
     /// Download a ledger in full
     /// @param ledgerSequence sequence of the ledger to download
-    /// @param writeQueue queue to push downloaded ledger objects
+    /// @param numMarkers number of key ranges downloaded in parallel
+    /// @param helpers other sources to spread the ranges over
     /// @return true if the download was successful
     bool
     loadInitialLedger(
         std::uint32_t ledgerSequence,
         std::uint32_t numMarkers,
-        bool cacheOnly = false) override;
+        bool cacheOnly = false,
+        std::vector<ETLSource*> const& helpers = {}) override;
+
+    org::xrpl::rpc::v1::XRPLedgerAPIService::Stub*
+    grpcStub() override
+    {
+        return stub_.get();
+    }
 
     /// Attempt to reconnect to the ETL source
     void
@@ -615,6 +631,17 @@ private:
     std::vector<std::unique_ptr<ETLSource>> sources_;
     std::uint32_t downloadRanges_ = 16;
 
+    // what execute() has observed of each source, by index in sources_
+    struct SourceStats
+    {
+        // moving average of the time f took, in milliseconds. 0 until the
+        // first sample, so every source is tried early on
+        double latencyMs = 0;
+        std::uint32_t inFlight = 0;
+    };
+    mutable std::mutex statsMtx_;
+    std::vector<SourceStats> stats_;
+
 public:
     ETLLoadBalancer(
         clio::Config const& config,
@@ -708,10 +735,20 @@ public:
         boost::asio::yield_context& yield) const;
 
 private:
+    /// Pick the source to run the next request for the given ledger on:
+    /// among the sources that have the ledger and are not in skip, the one
+    /// with the lowest expected wait, which is its average latency times its
+    /// number of requests in flight plus one. Concurrent requests, such as
+    /// the fetches of several extractor threads, are thereby spread over
+    /// every healthy source in proportion to its speed
+    std::optional<size_t>
+    pickSource(uint32_t ledgerSequence, std::vector<bool> const& skip) const;
+
     /// f is a function that takes an ETLSource as an argument and returns a
-    /// bool. Attempt to execute f for one randomly chosen ETLSource that has
-    /// the specified ledger. If f returns false, another randomly chosen
-    /// ETLSource is used. The process repeats until f returns true.
+    /// bool. Attempt to execute f for one ETLSource that has the specified
+    /// ledger, picked by pickSource(). If f returns false, the next source is
+    /// picked among those not tried yet. The process repeats until f returns
+    /// true.
     /// @param f function to execute. This function takes the ETL source as an
     /// argument, and returns a bool.
     /// @param ledgerSequence f is executed for each ETLSource that has this
@@ -397,6 +397,9 @@ getNFTDataFromObj(
     std::string const& blob)
 {
     std::vector<NFTsData> nfts;
+    if (!isNFTokenPage(blob))
+        return nfts;
+
     ripple::STLedgerEntry const sle = ripple::STLedgerEntry(
         ripple::SerialIter{blob.data(), blob.size()},
         ripple::uint256::fromVoid(key.data()));
@@ -116,12 +116,21 @@ bool
 ProbingETLSource::loadInitialLedger(
     std::uint32_t ledgerSequence,
     std::uint32_t numMarkers,
-    bool cacheOnly)
+    bool cacheOnly,
+    std::vector<ETLSource*> const& helpers)
 {
     if (!currentSrc_)
         return false;
     return currentSrc_->loadInitialLedger(
-        ledgerSequence, numMarkers, cacheOnly);
+        ledgerSequence, numMarkers, cacheOnly, helpers);
+}
+
+org::xrpl::rpc::v1::XRPLedgerAPIService::Stub*
+ProbingETLSource::grpcStub()
+{
+    if (!currentSrc_)
+        return nullptr;
+    return currentSrc_->grpcStub();
 }
 
 std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
@@ -83,7 +83,11 @@ public:
     loadInitialLedger(
         std::uint32_t ledgerSequence,
         std::uint32_t numMarkers,
-        bool cacheOnly = false) override;
+        bool cacheOnly = false,
+        std::vector<ETLSource*> const& helpers = {}) override;
+
+    org::xrpl::rpc::v1::XRPLedgerAPIService::Stub*
+    grpcStub() override;
 
     std::pair<grpc::Status, org::xrpl::rpc::v1::GetLedgerResponse>
     fetchLedger(
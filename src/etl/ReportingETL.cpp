@@ -30,11 +30,14 @@
 
 #include <boost/asio/connect.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 
 #include <cstdlib>
 #include <iostream>
+#include <map>
 #include <string>
 #include <thread>
 #include <variant>
@@ -56,21 +59,20 @@ toString(ripple::LedgerInfo const& info)
 }  // namespace clio::detail
 
 FormattedTransactionsData
-ReportingETL::insertTransactions(
+ReportingETL::formatTransactions(
     ripple::LedgerInfo const& ledger,
-    org::xrpl::rpc::v1::GetLedgerResponse& data)
+    org::xrpl::rpc::v1::GetLedgerResponse const& data) const
 {
     FormattedTransactionsData result;
 
-    for (auto& txn :
-         *(data.mutable_transactions_list()->mutable_transactions()))
+    for (auto const& txn : data.transactions_list().transactions())
     {
-        std::string* raw = txn.mutable_transaction_blob();
+        auto const& raw = txn.transaction_blob();
 
-        ripple::SerialIter it{raw->data(), raw->size()};
+        ripple::SerialIter it{raw.data(), raw.size()};
         ripple::STTx sttx{it};
 
-        log_.trace() << "Inserting transaction = " << sttx.getTransactionID();
+        log_.trace() << "Formatting transaction = " << sttx.getTransactionID();
 
         ripple::TxMeta txMeta{
             sttx.getTransactionID(), ledger.seq, txn.metadata_blob()};
@@ -82,15 +84,20 @@ ReportingETL::insertTransactions(
             result.nfTokensData.push_back(*maybeNFT);
 
         auto journal = ripple::debugLog();
-        result.accountTxData.emplace_back(
+        auto& accountTx = result.accountTxData.emplace_back(
             txMeta, sttx.getTransactionID(), journal);
-        std::string keyStr{(const char*)sttx.getTransactionID().data(), 32};
-        backend_->writeTransaction(
-            std::move(keyStr),
-            ledger.seq,
-            ledger.closeTime.time_since_epoch().count(),
-            std::move(*raw),
-            std::move(*txn.mutable_metadata_blob()));
+        if (backend_->storesAccountTxInline())
+        {
+            auto const& meta = txn.metadata_blob();
+            accountTx.inlineTx =
+                std::make_shared<Backend::TransactionAndMetadata const>(
+                    Backend::TransactionAndMetadata{
+                        Backend::Blob(raw.begin(), raw.end()),
+                        Backend::Blob(meta.begin(), meta.end()),
+                        ledger.seq,
+                        static_cast<std::uint32_t>(
+                            ledger.closeTime.time_since_epoch().count())});
+        }
     }
 
     // Remove all but the last NFTsData for each id. unique removes all
@@ -115,6 +122,44 @@ ReportingETL::insertTransactions(
     return result;
 }
 
+void
+ReportingETL::writeTransactions(
+    ripple::LedgerInfo const& ledger,
+    org::xrpl::rpc::v1::GetLedgerResponse& data,
+    FormattedTransactionsData const& formatted)
+{
+    auto& txns = *(data.mutable_transactions_list()->mutable_transactions());
+    // formatTransactions emplaces exactly one AccountTransactionsData per
+    // transaction, in order, so the hashes need not be computed again
+    assert(formatted.accountTxData.size() == txns.size());
+
+    for (std::size_t i = 0; i < formatted.accountTxData.size(); ++i)
+    {
+        auto& txn = txns[i];
+        auto const& hash = formatted.accountTxData[i].txHash;
+
+        log_.trace() << "Inserting transaction = " << hash;
+
+        std::string keyStr{(const char*)hash.data(), 32};
+        backend_->writeTransaction(
+            std::move(keyStr),
+            ledger.seq,
+            ledger.closeTime.time_since_epoch().count(),
+            std::move(*txn.mutable_transaction_blob()),
+            std::move(*txn.mutable_metadata_blob()));
+    }
+}
+
+FormattedTransactionsData
+ReportingETL::insertTransactions(
+    ripple::LedgerInfo const& ledger,
+    org::xrpl::rpc::v1::GetLedgerResponse& data)
+{
+    auto result = formatTransactions(ledger, data);
+    writeTransactions(ledger, data, result);
+    return result;
+}
+
 std::optional<ripple::LedgerInfo>
 ReportingETL::loadInitialLedger(uint32_t startingSequence)
 {
@@ -190,6 +235,8 @@ ReportingETL::publishLedger(ripple::LedgerInfo const& lgrInfo)
                 return backend_->fetchLedgerDiff(lgrInfo.seq, yield);
             });
 
+        // a no-op unless the key index is in use, see the constructor
+        backend_->keyIndex().update(diff, lgrInfo.seq);
         backend_->cache().update(diff, lgrInfo.seq);
         backend_->updateRange(lgrInfo.seq);
     }
@@ -220,10 +267,7 @@ ReportingETL::publishLedger(ripple::LedgerInfo const& lgrInfo)
 
         subscriptions_->pubLedger(lgrInfo, *fees, range, transactions.size());
 
-        for (auto& txAndMeta : transactions)
-            subscriptions_->pubTransaction(txAndMeta, lgrInfo);
-
-        subscriptions_->pubBookChanges(lgrInfo, transactions);
+        subscriptions_->pubLedgerTransactions(lgrInfo, transactions);
 
         log_.info() << "Published ledger " << std::to_string(lgrInfo.seq);
     }
@@ -304,10 +348,69 @@ ReportingETL::fetchLedgerDataAndDiff(uint32_t seq)
     return response;
 }
 
+std::optional<uint32_t>
+ReportingETL::latestKeysSequence() const
+{
+    if (backend_->cache().isFull())
+        return backend_->cache().latestLedgerSequence();
+    if (backend_->keyIndex().isFull())
+        return backend_->keyIndex().latestLedgerSequence();
+    return {};
+}
+
+std::optional<bool>
+ReportingETL::wasBookDir(ripple::uint256 const& key, uint32_t seq) const
+{
+    if (!backend_->cache().isFull())
+        return backend_->keyIndex().isBookDir(key);
+    auto const blob = backend_->cache().get(key, seq);
+    if (!blob)
+        return {};
+    return isBookDir(key, *blob);
+}
+
+std::optional<ripple::uint256>
+ReportingETL::successorKey(ripple::uint256 const& key, uint32_t seq) const
+{
+    if (!backend_->cache().isFull())
+        return backend_->keyIndex().successor(key, seq);
+    if (auto const succ = backend_->cache().getSuccessor(key, seq))
+        return succ->key;
+    return {};
+}
+
+std::optional<ripple::uint256>
+ReportingETL::predecessorKey(ripple::uint256 const& key, uint32_t seq) const
+{
+    if (!backend_->cache().isFull())
+        return backend_->keyIndex().predecessor(key, seq);
+    if (auto const pred = backend_->cache().getPredecessor(key, seq))
+        return pred->key;
+    return {};
+}
+
 std::pair<ripple::LedgerInfo, bool>
 ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
+{
+    ripple::LedgerInfo lgrInfo =
+        deserializeHeader(ripple::makeSlice(rawData.ledger_header()));
+    auto const start = std::chrono::steady_clock::now();
+    auto txData = formatTransactions(lgrInfo, rawData);
+    metrics_.record(
+        ETLMetrics::Stage::decode,
+        lgrInfo.seq,
+        std::chrono::duration_cast<ETLMetrics::Duration>(
+            std::chrono::steady_clock::now() - start));
+    return buildNextLedger(rawData, std::move(txData));
+}
+
+std::pair<ripple::LedgerInfo, bool>
+ReportingETL::buildNextLedger(
+    org::xrpl::rpc::v1::GetLedgerResponse& rawData,
+    FormattedTransactionsData&& insertTxResult)
 {
     log_.debug() << "Beginning ledger update";
+    auto const start = std::chrono::steady_clock::now();
     ripple::LedgerInfo lgrInfo =
         deserializeHeader(ripple::makeSlice(rawData.ledger_header()));
 
@@ -379,37 +482,41 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
                 log_.debug() << "object modified " << ripple::strHex(obj.key());
         }
     }
+    // Each blob is copied once, into the cache update, which is then moved
+    // into the cache. The protobuf strings themselves are moved into the
+    // backend writes, so the driver binds them without further copies
     std::vector<Backend::LedgerObject> cacheUpdates;
     cacheUpdates.reserve(rawData.ledger_objects().objects_size());
+    // created or deleted objects, whose successors are computed from the
+    // latest keys when rippled did not include them. true if deleted
+    std::vector<std::pair<ripple::uint256, bool>> createdOrDeleted;
     // TODO change these to unordered_set
     std::set<ripple::uint256> bookSuccessorsToCalculate;
-    std::set<ripple::uint256> modified;
     for (auto& obj : *(rawData.mutable_ledger_objects()->mutable_objects()))
     {
         auto key = ripple::uint256::fromVoidChecked(obj.key());
         assert(key);
-        cacheUpdates.push_back(
-            {*key, {obj.mutable_data()->begin(), obj.mutable_data()->end()}});
+        cacheUpdates.push_back({*key, {obj.data().begin(), obj.data().end()}});
         log_.debug() << "key = " << ripple::strHex(*key)
                      << " - mod type = " << obj.mod_type();
 
         if (obj.mod_type() != org::xrpl::rpc::v1::RawLedgerObject::MODIFIED &&
             !rawData.object_neighbors_included())
         {
-            log_.debug() << "object neighbors not included. using cache";
-            if (!backend_->cache().isFull() ||
-                backend_->cache().latestLedgerSequence() != lgrInfo.seq - 1)
+            log_.debug() << "object neighbors not included. using "
+                         << "latest keys";
+            if (latestKeysSequence() != lgrInfo.seq - 1)
                 throw std::runtime_error(
-                    "Cache is not full, but object neighbors were not "
-                    "included");
+                    "Neither cache nor key index is full, but object "
+                    "neighbors were not included");
             auto blob = obj.mutable_data();
             bool checkBookBase = false;
             bool isDeleted = (blob->size() == 0);
             if (isDeleted)
             {
-                auto old = backend_->cache().get(*key, lgrInfo.seq - 1);
+                auto old = wasBookDir(*key, lgrInfo.seq - 1);
                 assert(old);
-                checkBookBase = isBookDir(*key, *old);
+                checkBookBase = old.value_or(false);
             }
             else
                 checkBookBase = isBookDir(*key, *blob);
@@ -417,13 +524,12 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
             {
                 log_.debug() << "Is book dir. key = " << ripple::strHex(*key);
                 auto bookBase = getBookBase(*key);
-                auto oldFirstDir =
-                    backend_->cache().getSuccessor(bookBase, lgrInfo.seq - 1);
+                auto oldFirstDir = successorKey(bookBase, lgrInfo.seq - 1);
                 assert(oldFirstDir);
                 // We deleted the first directory, or we added a directory prior
                 // to the old first directory
-                if ((isDeleted && key == oldFirstDir->key) ||
-                    (!isDeleted && key < oldFirstDir->key))
+                if ((isDeleted && key == oldFirstDir) ||
+                    (!isDeleted && key < oldFirstDir))
                 {
                     log_.debug()
                         << "Need to recalculate book base successor. base = "
@@ -435,105 +541,94 @@ ReportingETL::buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData)
                 }
             }
         }
-        if (obj.mod_type() == org::xrpl::rpc::v1::RawLedgerObject::MODIFIED)
-            modified.insert(*key);
+        if (obj.mod_type() != org::xrpl::rpc::v1::RawLedgerObject::MODIFIED &&
+            !rawData.object_neighbors_included())
+            createdOrDeleted.emplace_back(*key, obj.data().empty());
 
         backend_->writeLedgerObject(
             std::move(*obj.mutable_key()),
             lgrInfo.seq,
             std::move(*obj.mutable_data()));
     }
-    backend_->cache().update(cacheUpdates, lgrInfo.seq);
-    // rippled didn't send successor information, so use our cache
+    auto const cacheUpdateTime =
+        ETLMetrics::Duration{util::timed<ETLMetrics::Duration>([&]() {
+            backend_->keyIndex().update(cacheUpdates, lgrInfo.seq);
+            backend_->cache().update(std::move(cacheUpdates), lgrInfo.seq);
+        })};
+    metrics_.record(
+        ETLMetrics::Stage::cacheUpdate, lgrInfo.seq, cacheUpdateTime);
+    // rippled didn't send successor information, so use the latest keys
     if (!rawData.object_neighbors_included())
     {
-        log_.debug() << "object neighbors not included. using cache";
-        if (!backend_->cache().isFull() ||
-            backend_->cache().latestLedgerSequence() != lgrInfo.seq)
+        log_.debug() << "object neighbors not included. using latest keys";
+        if (latestKeysSequence() != lgrInfo.seq)
             throw std::runtime_error(
-                "Cache is not full, but object neighbors were not "
-                "included");
-        for (auto const& obj : cacheUpdates)
+                "Neither cache nor key index is full, but object neighbors "
+                "were not included");
+        for (auto const& [key, isDeleted] : createdOrDeleted)
         {
-            if (modified.count(obj.key))
-                continue;
-            auto lb = backend_->cache().getPredecessor(obj.key, lgrInfo.seq);
-            if (!lb)
-                lb = {Backend::firstKey, {}};
-            auto ub = backend_->cache().getSuccessor(obj.key, lgrInfo.seq);
-            if (!ub)
-                ub = {Backend::lastKey, {}};
-            if (obj.blob.size() == 0)
+            auto lb =
+                predecessorKey(key, lgrInfo.seq).value_or(Backend::firstKey);
+            auto ub = successorKey(key, lgrInfo.seq).value_or(Backend::lastKey);
+            if (isDeleted)
             {
                 log_.debug() << "writing successor for deleted object "
-                             << ripple::strHex(obj.key) << " - "
-                             << ripple::strHex(lb->key) << " - "
-                             << ripple::strHex(ub->key);
+                             << ripple::strHex(key) << " - "
+                             << ripple::strHex(lb) << " - "
+                             << ripple::strHex(ub);
 
                 backend_->writeSuccessor(
-                    uint256ToString(lb->key),
-                    lgrInfo.seq,
-                    uint256ToString(ub->key));
+                    uint256ToString(lb), lgrInfo.seq, uint256ToString(ub));
             }
             else
             {
                 backend_->writeSuccessor(
-                    uint256ToString(lb->key),
-                    lgrInfo.seq,
-                    uint256ToString(obj.key));
+                    uint256ToString(lb), lgrInfo.seq, uint256ToString(key));
                 backend_->writeSuccessor(
-                    uint256ToString(obj.key),
-                    lgrInfo.seq,
-                    uint256ToString(ub->key));
+                    uint256ToString(key), lgrInfo.seq, uint256ToString(ub));
 
                 log_.debug() << "writing successor for new object "
-                             << ripple::strHex(lb->key) << " - "
-                             << ripple::strHex(obj.key) << " - "
-                             << ripple::strHex(ub->key);
+                             << ripple::strHex(lb) << " - "
+                             << ripple::strHex(key) << " - "
+                             << ripple::strHex(ub);
             }
         }
         for (auto const& base : bookSuccessorsToCalculate)
         {
-            auto succ = backend_->cache().getSuccessor(base, lgrInfo.seq);
-            if (succ)
-            {
-                backend_->writeSuccessor(
-                    uint256ToString(base),
-                    lgrInfo.seq,
-                    uint256ToString(succ->key));
-
-                log_.debug()
-                    << "Updating book successor " << ripple::strHex(base)
-                    << " - " << ripple::strHex(succ->key);
-            }
-            else
-            {
-                backend_->writeSuccessor(
-                    uint256ToString(base),
-                    lgrInfo.seq,
-                    uint256ToString(Backend::lastKey));
+            auto succ =
+                successorKey(base, lgrInfo.seq).value_or(Backend::lastKey);
+            backend_->writeSuccessor(
+                uint256ToString(base), lgrInfo.seq, uint256ToString(succ));
 
-                log_.debug()
-                    << "Updating book successor " << ripple::strHex(base)
-                    << " - " << ripple::strHex(Backend::lastKey);
-            }
+            log_.debug() << "Updating book successor " << ripple::strHex(base)
+                         << " - " << ripple::strHex(succ);
         }
     }
 
     log_.debug()
         << "Inserted/modified/deleted all objects. Number of objects = "
         << rawData.ledger_objects().objects_size();
-    FormattedTransactionsData insertTxResult =
-        insertTransactions(lgrInfo, rawData);
+    writeTransactions(lgrInfo, rawData, insertTxResult);
     log_.debug() << "Inserted all transactions. Number of transactions  = "
                  << rawData.transactions_list().transactions_size();
     backend_->writeAccountTransactions(std::move(insertTxResult.accountTxData));
     backend_->writeNFTs(std::move(insertTxResult.nfTokensData));
     backend_->writeNFTTransactions(std::move(insertTxResult.nfTokenTxData));
     log_.debug() << "wrote account_tx";
+    metrics_.record(
+        ETLMetrics::Stage::write,
+        lgrInfo.seq,
+        std::chrono::duration_cast<ETLMetrics::Duration>(
+            std::chrono::steady_clock::now() - start) -
+            cacheUpdateTime);
 
     auto [success, duration] = util::timed<std::chrono::duration<double>>(
         [&]() { return backend_->finishWrites(lgrInfo.seq); });
+    metrics_.record(
+        ETLMetrics::Stage::finishWrites,
+        lgrInfo.seq,
+        std::chrono::duration_cast<ETLMetrics::Duration>(
+            std::chrono::duration<double>(duration)));
 
     log_.debug() << "Finished writes. took " << std::to_string(duration);
     log_.debug() << "Finished ledger update. " << detail::toString(lgrInfo);
@@ -625,6 +720,11 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
                         return fetchLedgerDataAndDiff(currentSequence);
                     });
                 totalTime += time;
+                metrics_.record(
+                    ETLMetrics::Stage::extract,
+                    currentSequence,
+                    std::chrono::duration_cast<ETLMetrics::Duration>(
+                        std::chrono::duration<double>(time)));
 
                 // if the fetch is unsuccessful, stop. fetchLedger only
                 // returns false if the server is shutting down, or if the
@@ -658,19 +758,110 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
         });
     }
 
+    // With more than one transform thread, the transactions of the next few
+    // ledgers are decoded by a pool of decoders while the transformer writes
+    // the current one. Decoders take sequences in order, and the transformer
+    // consumes the decoded ledgers in order, so ledgers are still written and
+    // published strictly sequentially.
+    struct Decoded
+    {
+        std::optional<org::xrpl::rpc::v1::GetLedgerResponse> response;
+        std::optional<FormattedTransactionsData> txData;
+    };
+    std::mutex decodeMutex;
+    std::condition_variable decodeCv;
+    std::map<uint32_t, Decoded> decoded;
+    uint32_t nextToDecode = startSequence;
+    uint32_t nextToLoad = startSequence;
+    bool decodeDone = false;
+    // serializes popping so each extractor queue is popped in sequence order
+    std::mutex popMutex;
+    bool extractionDone = false;
+    uint32_t const maxDecodeAhead = transformThreads_ * 2;
+
+    std::vector<std::thread> decoders;
+    for (size_t i = 0; transformThreads_ > 1 && i < transformThreads_; ++i)
+    {
+        decoders.emplace_back([&, this]() {
+            beast::setCurrentThreadName("rippled: ReportingETL decode");
+            while (true)
+            {
+                std::unique_lock popLck(popMutex);
+                uint32_t sequence;
+                {
+                    std::unique_lock lck(decodeMutex);
+                    decodeCv.wait(lck, [&]() {
+                        return decodeDone ||
+                            nextToDecode - nextToLoad < maxDecodeAhead;
+                    });
+                    if (decodeDone || extractionDone)
+                        return;
+                    sequence = nextToDecode++;
+                }
+                Decoded result{getNext(sequence)->pop(), {}};
+                // the extractor of this sequence has stopped. Its queue will
+                // never be pushed to again
+                if (!result.response)
+                    extractionDone = true;
+                popLck.unlock();
+
+                if (result.response && !isStopping())
+                {
+                    auto const lgrInfo = deserializeHeader(
+                        ripple::makeSlice(result.response->ledger_header()));
+                    auto const start = std::chrono::steady_clock::now();
+                    result.txData =
+                        formatTransactions(lgrInfo, *result.response);
+                    metrics_.record(
+                        ETLMetrics::Stage::decode,
+                        lgrInfo.seq,
+                        std::chrono::duration_cast<ETLMetrics::Duration>(
+                            std::chrono::steady_clock::now() - start));
+                }
+
+                {
+                    std::unique_lock lck(decodeMutex);
+                    decoded.emplace(sequence, std::move(result));
+                }
+                decodeCv.notify_all();
+            }
+        });
+    }
+
+    auto popNext = [&](uint32_t sequence) -> Decoded {
+        if (decoders.empty())
+            return {getNext(sequence)->pop(), {}};
+
+        std::unique_lock lck(decodeMutex);
+        decodeCv.wait(lck, [&]() { return decoded.count(sequence) != 0; });
+        auto node = decoded.extract(sequence);
+        ++nextToLoad;
+        lck.unlock();
+        decodeCv.notify_all();
+        return std::move(node.mapped());
+    };
+
+    auto reportQueueDepths = [&]() {
+        for (size_t i = 0; i < queues.size(); ++i)
+            metrics_.setQueueDepth(
+                "extract_" + std::to_string(i), queues[i]->size());
+        std::unique_lock lck(decodeMutex);
+        metrics_.setQueueDepth("decoded", decoded.size());
+    };
+
     std::thread transformer{[this,
                              &minSequence,
                              &writeConflict,
                              &startSequence,
-                             &getNext,
+                             &popNext,
+                             &reportQueueDepths,
                              &lastPublishedSequence]() {
         beast::setCurrentThreadName("rippled: ReportingETL transform");
         uint32_t currentSequence = startSequence;
 
         while (!writeConflict)
         {
-            std::optional<org::xrpl::rpc::v1::GetLedgerResponse> fetchResponse{
-                getNext(currentSequence)->pop()};
+            auto [fetchResponse, txData] = popNext(currentSequence);
             ++currentSequence;
             // if fetchResponse is an empty optional, the extracter thread
             // has stopped and the transformer should stop as well
@@ -684,8 +875,11 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
             auto numTxns =
                 fetchResponse->transactions_list().transactions_size();
             auto numObjects = fetchResponse->ledger_objects().objects_size();
+            reportQueueDepths();
             auto start = std::chrono::system_clock::now();
-            auto [lgrInfo, success] = buildNextLedger(*fetchResponse);
+            auto [lgrInfo, success] = txData
+                ? buildNextLedger(*fetchResponse, std::move(*txData))
+                : buildNextLedger(*fetchResponse);
             auto end = std::chrono::system_clock::now();
 
             auto duration = ((end - start).count()) / 1000000000.0;
@@ -704,8 +898,15 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
             // success is false if the ledger was already written
             if (success)
             {
+                metrics_.recordSize(lgrInfo.seq, numTxns, numObjects);
                 boost::asio::post(publishStrand_, [this, lgrInfo = lgrInfo]() {
-                    publishLedger(lgrInfo);
+                    auto const duration = util::timed<ETLMetrics::Duration>(
+                        [&]() { publishLedger(lgrInfo); });
+                    metrics_.record(
+                        ETLMetrics::Stage::publish,
+                        lgrInfo.seq,
+                        ETLMetrics::Duration{duration});
+                    metrics_.finishLedger(lgrInfo.seq);
                 });
 
                 lastPublishedSequence = lgrInfo.seq;
@@ -735,6 +936,11 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
     }};
 
     transformer.join();
+    {
+        std::unique_lock lck(decodeMutex);
+        decodeDone = true;
+    }
+    decodeCv.notify_all();
     for (size_t i = 0; i < numExtractors; ++i)
     {
         // pop from each queue that might be blocked on a push
@@ -743,6 +949,9 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
     // wait for all of the extractors to stop
     for (auto& t : extractors)
         t.join();
+    // a decoder blocked on a pop is released by the extractor's final push
+    for (auto& t : decoders)
+        t.join();
     auto end = std::chrono::system_clock::now();
     log_.debug() << "Extracted and wrote "
                  << *lastPublishedSequence - startSequence << " in "
@@ -754,6 +963,154 @@ ReportingETL::runETLPipeline(uint32_t startSequence, int numExtractors)
     return lastPublishedSequence;
 }
 
+void
+ReportingETL::runBackfill()
+{
+    std::vector<BackfillRange> chunks;
+    for (auto const& range : backfillRanges_)
+    {
+        for (uint64_t start = range.start; start <= range.finish;
+             start += backfillChunkSize_)
+        {
+            auto const finish = std::min<uint64_t>(
+                start + backfillChunkSize_ - 1, range.finish);
+            chunks.push_back(
+                {static_cast<uint32_t>(start), static_cast<uint32_t>(finish)});
+        }
+    }
+
+    log_.info() << "Starting backfill of " << backfillRanges_.size()
+                << " ranges in " << chunks.size() << " chunks with "
+                << backfillThreads_ << " threads";
+    writing_ = true;
+    auto const begin = std::chrono::system_clock::now();
+
+    std::atomic_size_t nextChunk = 0;
+    // written by one worker each, read once they are joined
+    std::vector<char> done(chunks.size(), false);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min<size_t>(backfillThreads_, chunks.size());
+         ++i)
+    {
+        workers.emplace_back([this, &chunks, &done, &nextChunk]() {
+            beast::setCurrentThreadName("rippled: ReportingETL backfill");
+            for (auto idx = nextChunk++; idx < chunks.size();
+                 idx = nextChunk++)
+            {
+                if (!backfillChunk(chunks[idx].start, chunks[idx].finish))
+                    return;
+                done[idx] = true;
+            }
+        });
+    }
+    for (auto& t : workers)
+        t.join();
+
+    advanceTransactionHistory(chunks, done);
+    writing_ = false;
+    auto const end = std::chrono::system_clock::now();
+    log_.info() << "Finished backfill. took "
+                << ((end - begin).count()) / 1000000000.0
+                << " seconds. stopping = " << isStopping();
+}
+
+void
+ReportingETL::advanceTransactionHistory(
+    std::vector<BackfillRange> const& chunks,
+    std::vector<char> const& done)
+{
+    auto const range = backend_->hardFetchLedgerRangeNoThrow();
+    if (!range)
+    {
+        log_.warn() << "The database has no ledger range. Backfilled "
+                    << "transactions are served once it has one and the "
+                    << "backfill is run again";
+        return;
+    }
+    auto const stored = Backend::synchronousAndRetryOnTimeout([&](auto yield) {
+        return backend_->fetchTransactionHistoryStart(yield);
+    });
+    auto const current =
+        std::min(stored.value_or(range->minSequence), range->minSequence);
+
+    // walk down from the current start over chunks that end right below it.
+    // Ranges may overlap, so several chunks can end at the same ledger
+    std::map<uint32_t, uint32_t> startByFinish;
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        if (!done[i])
+            continue;
+        auto [it, inserted] =
+            startByFinish.emplace(chunks[i].finish, chunks[i].start);
+        if (!inserted)
+            it->second = std::min(it->second, chunks[i].start);
+    }
+    auto start = current;
+    for (auto it = startByFinish.find(start - 1); it != startByFinish.end();
+         it = startByFinish.find(start - 1))
+        start = it->second;
+
+    if (start < current)
+    {
+        backend_->writeTransactionHistoryStart(start);
+        log_.info() << "Transaction history now starts at ledger " << start;
+    }
+    else
+    {
+        log_.warn() << "Backfilled transactions are not served yet: no "
+                    << "backfilled chunk ends at ledger " << current - 1
+                    << ", right below the transaction history. Backfill the "
+                    << "gap up to it";
+    }
+}
+
+bool
+ReportingETL::backfillChunk(uint32_t start, uint32_t finish)
+{
+    auto const last = Backend::synchronousAndRetryOnTimeout([&](auto yield) {
+        return backend_->fetchLedgerBySequence(finish, yield);
+    });
+    if (last)
+    {
+        log_.info() << "Skipping backfilled chunk " << start << " - "
+                    << finish;
+        return true;
+    }
+
+    std::vector<std::pair<ripple::LedgerInfo, std::string>> headers;
+    for (auto seq = start; seq <= finish; ++seq)
+    {
+        if (isStopping())
+            return false;
+
+        auto response = loadBalancer_->fetchLedger(seq, false, false);
+        if (!response)
+            return false;
+
+        auto const lgrInfo =
+            deserializeHeader(ripple::makeSlice(response->ledger_header()));
+        auto insertTxResult = insertTransactions(lgrInfo, *response);
+        backend_->writeAccountTransactions(
+            std::move(insertTxResult.accountTxData));
+        backend_->writeNFTs(std::move(insertTxResult.nfTokensData));
+        backend_->writeNFTTransactions(
+            std::move(insertTxResult.nfTokenTxData));
+        headers.emplace_back(
+            lgrInfo, std::move(*response->mutable_ledger_header()));
+    }
+
+    // a header marks its ledger as backfilled, so it must not become visible
+    // before the rest of the ledger is durable. Only this chunk's writes are
+    // waited for, the other workers keep writing meanwhile
+    backend_->syncThreadWrites();
+    for (auto& [lgrInfo, header] : headers)
+        backend_->writeLedger(lgrInfo, std::move(header));
+    backend_->syncThreadWrites();
+
+    log_.info() << "Backfilled chunk " << start << " - " << finish;
+    return true;
+}
+
 // main loop. The software begins monitoring the ledgers that are validated
 // by the nework. The member networkValidatedLedgers_ keeps track of the
 // sequences of ledgers validated by the network. Whenever a ledger is validated
@@ -1034,6 +1391,156 @@ ReportingETL::loadCacheFromClioPeer(
     }
 }
 
+bool
+ReportingETL::loadCacheFromClioPeerBinary(
+    uint32_t ledgerIndex,
+    std::string const& ip,
+    std::string const& port,
+    boost::asio::yield_context& yield)
+{
+    log_.info() << "Loading cache from peer using binary transfer. ip = "
+                << ip << " . port = " << port;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    using tcp = boost::asio::ip::tcp;
+
+    auto const startTime = std::chrono::system_clock::now();
+
+    beast::error_code ec;
+    tcp::resolver resolver{ioContext_};
+    auto const endpoints = resolver.async_resolve(ip, port, yield[ec]);
+    if (ec)
+        return false;
+
+    auto connect = [&](boost::asio::yield_context& yield) {
+        beast::error_code ec;
+        auto stream = std::make_unique<beast::tcp_stream>(ioContext_);
+        stream->async_connect(endpoints, yield[ec]);
+        if (ec)
+        {
+            log_.error() << "Error connecting to peer = " << ec.message()
+                         << " - ip = " << ip;
+            return std::unique_ptr<beast::tcp_stream>{};
+        }
+        return stream;
+    };
+
+    auto fetch = [&](beast::tcp_stream& stream,
+                     CacheTransfer::Request const& request,
+                     boost::asio::yield_context& yield)
+        -> std::optional<CacheTransfer::Page> {
+        for (size_t numAttempts = 0; numAttempts < 5; ++numAttempts)
+        {
+            auto page = CacheTransfer::requestPage(stream, ip, request, yield);
+            if (!page)
+                return {};
+            if (page->status == http::status::ok)
+                return page;
+            // a peer whose cache lags its range by a ledger is about to
+            // catch up, anything else will not go away by retrying
+            if (page->error != "lgrNotFound" &&
+                page->error != "cacheNotCurrent")
+            {
+                log_.error() << "Peer could not serve cache. error = "
+                             << page->error << " - ip = " << ip;
+                return {};
+            }
+
+            log_.warn() << "Peer could not serve ledger yet. error = "
+                        << page->error << " ledger = " << ledgerIndex
+                        << ". Sleeping and trying again";
+            beast::error_code ec;
+            boost::asio::steady_timer timer{
+                ioContext_, std::chrono::seconds(1)};
+            timer.async_wait(yield[ec]);
+        }
+        log_.error() << " ledger not served by peer after 5 attempts. peer = "
+                     << ip << " ledger = " << ledgerIndex
+                     << ". Check your config and the health of the peer";
+        return {};
+    };
+
+    // Every marker is downloaded by its own coroutine over its own
+    // connection. The coroutines run on the strand of this one, so the state
+    // below is not synchronized
+    auto const markers =
+        getMarkers(std::clamp<size_t>(numCacheMarkers_, 1, maxMarkers));
+    size_t numRemaining = markers.size();
+    bool failed = false;
+    std::uint32_t maxSequence = ledgerIndex;
+    boost::asio::steady_timer done{
+        ioContext_, boost::asio::steady_timer::time_point::max()};
+
+    for (size_t i = 0; i < markers.size(); ++i)
+    {
+        CacheTransfer::Request request;
+        request.ledgerIndex = ledgerIndex;
+        request.limit = peerPageSize_;
+        request.compress = peerCompression_;
+        if (i != 0)
+            request.marker = markers[i];
+        if (i + 1 != markers.size())
+            request.end = markers[i + 1];
+
+        boost::asio::spawn(
+            yield,
+            [&, request](boost::asio::yield_context yield) mutable {
+                auto stream = connect(yield);
+                if (!stream)
+                    failed = true;
+
+                while (stream && !failed && !stopping_)
+                {
+                    auto page = fetch(*stream, request, yield);
+                    if (!page)
+                    {
+                        failed = true;
+                        break;
+                    }
+                    maxSequence = std::max(maxSequence, page->maxSequence);
+                    backend_->cache().update(page->objects, ledgerIndex, true);
+                    if (!page->marker)
+                        break;
+                    request.marker = page->marker;
+                }
+
+                if (--numRemaining == 0)
+                    done.cancel();
+            });
+    }
+    done.async_wait(yield[ec]);
+
+    if (failed || stopping_)
+        return false;
+
+    // The peer walks its state map at its most recent sequence, so anything
+    // deleted after ledgerIndex was skipped. Pick those up from the diffs
+    auto stream = connect(yield);
+    if (!stream)
+        return false;
+    for (auto seq = maxSequence; seq > ledgerIndex && !stopping_; --seq)
+    {
+        CacheTransfer::Request request;
+        request.ledgerIndex = ledgerIndex;
+        request.diff = seq;
+        request.compress = peerCompression_;
+
+        auto page = fetch(*stream, request, yield);
+        if (!page)
+            return false;
+        backend_->cache().update(page->objects, ledgerIndex, true);
+    }
+
+    auto const duration = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now() - startTime);
+    log_.info() << "Finished downloading ledger from clio node. ip = " << ip
+                << " . cache size = " << backend_->cache().size() << ". Took "
+                << duration.count() << " seconds";
+
+    backend_->cache().setFull();
+    return true;
+}
+
 void
 ReportingETL::loadCache(uint32_t seq)
 {
@@ -1041,6 +1548,13 @@ ReportingETL::loadCache(uint32_t seq)
     {
         backend_->cache().setDisabled();
         log_.warn() << "Cache is disabled. Not loading";
+        // a writer still needs every key to maintain the successor table.
+        // With the cache disabled, this only loads the key index
+        if (!readOnly_)
+        {
+            log_.info() << "Loading key index";
+            loadCacheFromDb(seq);
+        }
         return;
     }
     // sanity check to make sure we are not calling this multiple times
@@ -1059,13 +1573,18 @@ ReportingETL::loadCache(uint32_t seq)
 
     if (clioPeers.size() > 0)
     {
+        // the binary download coordinates its markers through the strand
         boost::asio::spawn(
-            ioContext_, [this, seq](boost::asio::yield_context yield) {
+            boost::asio::make_strand(ioContext_),
+            [this, seq](boost::asio::yield_context yield) {
                 for (auto const& peer : clioPeers)
                 {
+                    auto const port = std::to_string(peer.port);
                     // returns true on success
-                    if (loadCacheFromClioPeer(
-                            seq, peer.ip, std::to_string(peer.port), yield))
+                    if (loadCacheFromClioPeerBinary(
+                            seq, peer.ip, port, yield))
+                        return;
+                    if (loadCacheFromClioPeer(seq, peer.ip, port, yield))
                         return;
                 }
                 // if we couldn't successfully load from any peers, load from db
@@ -1170,6 +1689,7 @@ ReportingETL::loadCacheFromDb(uint32_t seq)
                             return backend_->fetchLedgerPage(
                                 cursor, seq, cachePageFetchSize_, false, yield);
                         });
+                        backend_->keyIndex().update(res.objects, seq, true);
                         backend_->cache().update(res.objects, seq, true);
                         if (!res.cursor || (end && *(res.cursor) > *end))
                             break;
@@ -1191,8 +1711,11 @@ ReportingETL::loadCacheFromDb(uint32_t seq)
                             std::chrono::duration_cast<std::chrono::seconds>(
                                 endTime - startTime);
                         log_.info() << "Finished loading cache. cache size = "
-                                    << backend_->cache().size() << ". Took "
+                                    << backend_->cache().size()
+                                    << ". key index size = "
+                                    << backend_->keyIndex().size() << ". Took "
                                     << duration.count() << " seconds";
+                        backend_->keyIndex().setFull();
                         backend_->cache().setFull();
                     }
                     else
@@ -1243,7 +1766,9 @@ ReportingETL::doWork()
 {
     worker_ = std::thread([this]() {
         beast::setCurrentThreadName("rippled: ReportingETL worker");
-        if (readOnly_)
+        if (!backfillRanges_.empty())
+            runBackfill();
+        else if (readOnly_)
             monitorReadOnly();
         else
             monitor();
@@ -1284,7 +1809,28 @@ ReportingETL::ReportingETL(
 
     extractorThreads_ =
         config.valueOr<uint32_t>("extractor_threads", extractorThreads_);
+    transformThreads_ = std::max(
+        config.valueOr<uint32_t>("transform_threads", transformThreads_), 1u);
     txnThreshold_ = config.valueOr<size_t>("txn_threshold", txnThreshold_);
+    if (config.contains("backfill"))
+    {
+        auto const backfill = config.section("backfill");
+        for (auto const& range : backfill.array("ranges"))
+        {
+            auto const start = range.valueOrThrow<uint32_t>(
+                "start", "Backfill range requires a start");
+            auto const finish = range.valueOrThrow<uint32_t>(
+                "finish", "Backfill range requires a finish");
+            if (start > finish)
+                throw std::runtime_error(
+                    "Backfill range start is greater than finish");
+            backfillRanges_.push_back({start, finish});
+        }
+        backfillThreads_ = std::max(
+            backfill.valueOr<uint32_t>("threads", backfillThreads_), 1u);
+        backfillChunkSize_ = std::max(
+            backfill.valueOr<uint32_t>("chunk_size", backfillChunkSize_), 1u);
+    }
     if (config.contains("cache"))
     {
         auto const cache = config.section("cache");
@@ -1303,6 +1849,12 @@ ReportingETL::ReportingETL(
             cache.valueOr<size_t>("num_markers", numCacheMarkers_);
         cachePageFetchSize_ =
             cache.valueOr<size_t>("page_fetch_size", cachePageFetchSize_);
+        peerPageSize_ = std::clamp(
+            cache.valueOr<std::uint32_t>("peer_page_size", peerPageSize_),
+            {1},
+            CacheTransfer::maxLimit);
+        peerCompression_ =
+            cache.valueOr<bool>("peer_compression", peerCompression_);
 
         if (auto peers = cache.maybeArray("peers"); peers)
         {
@@ -1323,4 +1875,10 @@ ReportingETL::ReportingETL(
                 std::default_random_engine(seed));
         }
     }
+
+    // a writer computes successors from the cache once it is full. Only a
+    // writer without a cache keeps the keys in the key index instead, so
+    // that no node holds every key twice
+    if (readOnly_ || cacheLoadStyle_ != CacheLoadStyle::NOT_AT_ALL)
+        backend_->keyIndex().setDisabled();
 }
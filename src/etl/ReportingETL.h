@@ -25,6 +25,8 @@
 #include <boost/beast/core/string.hpp>
 #include <boost/beast/websocket.hpp>
 #include <backend/BackendInterface.h>
+#include <etl/CacheTransfer.h>
+#include <etl/ETLMetrics.h>
 #include <etl/ETLSource.h>
 #include <log/Logger.h>
 #include <subscriptions/SubscriptionManager.h>
@@ -74,6 +76,11 @@ private:
     std::shared_ptr<ETLLoadBalancer> loadBalancer_;
     std::optional<std::uint32_t> onlineDeleteInterval_;
     std::uint32_t extractorThreads_ = 1;
+    // number of threads decoding transactions ahead of the thread writing
+    // ledgers during runETLPipeline. 1 decodes on the writing thread
+    std::uint32_t transformThreads_ = 1;
+    // per stage timing of the ledgers written by runETLPipeline
+    ETLMetrics metrics_;
 
     enum class CacheLoadStyle { ASYNC, SYNC, NOT_AT_ALL };
 
@@ -88,6 +95,11 @@ private:
     // number of ledger objects to fetch concurrently per marker during cache
     // download
     size_t cachePageFetchSize_ = 512;
+    // number of ledger objects to request per page when downloading the
+    // cache from a clio peer over the binary transfer endpoint
+    std::uint32_t peerPageSize_ = CacheTransfer::defaultLimit;
+    // whether to ask clio peers to deflate cache transfer pages
+    bool peerCompression_ = true;
     // thread responsible for syncing the cache on startup
     std::thread cacheDownloader_;
 
@@ -156,6 +168,19 @@ private:
     std::optional<uint32_t> startSequence_;
     std::optional<uint32_t> finishSequence_;
 
+    struct BackfillRange
+    {
+        uint32_t start;
+        uint32_t finish;
+    };
+
+    /// Historical ledger ranges to ingest, from the "backfill" section. When
+    /// set, the process backfills these ranges and does not perform ETL at
+    /// the tip. See runBackfill()
+    std::vector<BackfillRange> backfillRanges_;
+    std::uint32_t backfillThreads_ = 8;
+    std::uint32_t backfillChunkSize_ = 256;
+
     size_t txnThreshold_ = 0;
 
     /// The time that the most recently published ledger was published. Used by
@@ -209,6 +234,18 @@ private:
         std::string const& port,
         boost::asio::yield_context& yield);
 
+    /// Download the cache from a clio peer using the binary cache transfer
+    /// endpoint, walking numCacheMarkers_ key ranges in parallel. Must be
+    /// called from a coroutine running on a strand.
+    /// @return false if the peer could not serve the cache, in which case
+    /// the caller should fall back to loadCacheFromClioPeer
+    bool
+    loadCacheFromClioPeerBinary(
+        uint32_t ledgerSequence,
+        std::string const& ip,
+        std::string const& port,
+        boost::asio::yield_context& yield);
+
     /// Run ETL. Extracts ledgers and writes them to the database, until a
     /// write conflict occurs (or the server shuts down).
     /// @note database must already be populated when this function is
@@ -218,6 +255,38 @@ private:
     std::optional<uint32_t>
     runETLPipeline(uint32_t startSequence, int offset);
 
+    /// Ingest the configured historical ranges (backfillRanges_) instead of
+    /// following the network. Ranges are cut into chunks that are ingested
+    /// concurrently by backfillThreads_ threads. Only ledger headers,
+    /// transactions, account_tx and the nf_token tables are written; ledger
+    /// objects, successors and the cache only matter at the tip. State
+    /// lookups at a backfilled ledger would find nothing, so the ledger range
+    /// is not modified; several processes can each backfill their own ranges
+    /// against the same database. Instead, account_tx and nft_history serve
+    /// backfilled ledgers down to the transaction history start, see
+    /// advanceTransactionHistory(). A chunk whose last ledger header is
+    /// already in the database is skipped, so an interrupted backfill can be
+    /// resumed by restarting it with the same ranges.
+    void
+    runBackfill();
+
+    /// Lower the transaction history start over the completed chunks that
+    /// reach down from it without a gap. Chunks skipped because an earlier
+    /// run wrote them count as completed
+    /// @param chunks the chunks of this backfill
+    /// @param done whether each chunk is in the database
+    void
+    advanceTransactionHistory(
+        std::vector<BackfillRange> const& chunks,
+        std::vector<char> const& done);
+
+    /// Ingest one chunk of a backfill. Headers are written only once all of
+    /// the chunk's other data has been written, which is tracked per thread
+    /// so that workers don't wait for each other
+    /// @return false if the server is shutting down
+    bool
+    backfillChunk(uint32_t start, uint32_t finish);
+
     /// Monitor the network for newly validated ledgers. Also monitor the
     /// database to see if any process is writing those ledgers. This function
     /// is called when the application starts, and will only return when the
@@ -269,6 +338,48 @@ private:
         ripple::LedgerInfo const& ledger,
         org::xrpl::rpc::v1::GetLedgerResponse& data);
 
+    /// Decode the extracted transactions and derive the account and NFT data
+    /// to write for them, without writing anything. Safe to call for several
+    /// ledgers concurrently
+    /// @param ledger ledger the transactions belong to
+    /// @param data data extracted from an ETL source
+    /// @return the same as insertTransactions()
+    FormattedTransactionsData
+    formatTransactions(
+        ripple::LedgerInfo const& ledger,
+        org::xrpl::rpc::v1::GetLedgerResponse const& data) const;
+
+    /// Write the extracted transactions, moving the blobs out of data
+    /// @param ledger ledger the transactions belong to
+    /// @param data data extracted from an ETL source
+    /// @param formatted the result of formatTransactions() for data
+    void
+    writeTransactions(
+        ripple::LedgerInfo const& ledger,
+        org::xrpl::rpc::v1::GetLedgerResponse& data,
+        FormattedTransactionsData const& formatted);
+
+    /// The keys of the most recent ledger, used to compute successors when
+    /// rippled does not send object neighbors. They come from the cache once
+    /// it is full, and from the key index on a writer without a cache
+    /// @return the sequence of the latest ledger whose keys are all known
+    std::optional<uint32_t>
+    latestKeysSequence() const;
+
+    /// Whether key was a book directory in ledger seq. Empty if unknown
+    std::optional<bool>
+    wasBookDir(ripple::uint256 const& key, uint32_t seq) const;
+
+    /// Next key after key in ledger seq. Empty if there is none or seq is
+    /// not the latest ledger
+    std::optional<ripple::uint256>
+    successorKey(ripple::uint256 const& key, uint32_t seq) const;
+
+    /// Key before key in ledger seq. Empty if there is none or seq is not
+    /// the latest ledger
+    std::optional<ripple::uint256>
+    predecessorKey(ripple::uint256 const& key, uint32_t seq) const;
+
     // TODO update this documentation
     /// Build the next ledger using the previous ledger and the extracted data.
     /// This function calls insertTransactions()
@@ -280,6 +391,13 @@ private:
     std::pair<ripple::LedgerInfo, bool>
     buildNextLedger(org::xrpl::rpc::v1::GetLedgerResponse& rawData);
 
+    /// Same as above, with the transactions already run through
+    /// formatTransactions()
+    std::pair<ripple::LedgerInfo, bool>
+    buildNextLedger(
+        org::xrpl::rpc::v1::GetLedgerResponse& rawData,
+        FormattedTransactionsData&& insertTxResult);
+
     /// Attempt to read the specified ledger from the database, and then publish
     /// that ledger to the ledgers stream.
     /// @param ledgerSequence the sequence of the ledger to publish
@@ -371,6 +489,7 @@ public:
         result["etl_sources"] = loadBalancer_->toJson();
         result["is_writer"] = writing_.load();
         result["read_only"] = readOnly_;
+        result["etl_metrics"] = metrics_.report();
         auto last = getLastPublish();
         if (last.time_since_epoch().count() != 0)
             result["last_publish_age_seconds"] =
@@ -123,7 +123,7 @@ LogService::init(Config const& config)
     // get default severity, can be overridden per channel using
     // the `log_channels` array
     auto defaultSeverity = config.valueOr<Severity>("log_level", Severity::NFO);
-    static constexpr std::array<const char*, 7> channels = {
+    static constexpr std::array<const char*, 8> channels = {
         "General",
         "WebServer",
         "Backend",
@@ -131,6 +131,7 @@ LogService::init(Config const& config)
         "ETL",
         "Subscriptions",
         "Performance",
+        "Migration",
     };
 
     auto core = boost::log::core::get();
@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <migration/Migration.h>
+#include <migration/MigrationStore.h>
+
+namespace Migrations {
+
+void
+Throttle::acquire(std::size_t ops, boost::asio::yield_context& yield)
+{
+    if (opsPerSecond_ <= 0)
+        return;
+
+    // every acquisition pushes back the time at which the next one may
+    // proceed by the time its operations take at the budgeted rate
+    auto const now = std::chrono::steady_clock::now();
+    auto const start = std::max(next_, now);
+    next_ = start +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(ops / opsPerSecond_));
+
+    if (start > now)
+    {
+        boost::asio::steady_timer timer{ioc_, start};
+        boost::system::error_code ec;
+        timer.async_wait(yield[ec]);
+    }
+}
+
+Context::Context(
+    Backend::CassandraBackend& backend,
+    boost::asio::io_context& ioc,
+    MigrationStore& store,
+    Options const& options,
+    Backend::LedgerRange const& range,
+    std::uint32_t version)
+    : backend(backend)
+    , ioc(ioc)
+    , store(store)
+    , options(options)
+    , throttle(ioc, options.opsPerSecond)
+    , range(range)
+    , version(version)
+{
+}
+
+void
+Context::loadCheckpoints(boost::asio::yield_context& yield)
+{
+    committed_ = store.checkpoints(version, yield);
+}
+
+std::optional<std::string>
+Context::checkpoint(std::string const& scan) const
+{
+    if (auto it = committed_.find(scan); it != committed_.end())
+        return it->second;
+    return {};
+}
+
+void
+Context::setCheckpoint(std::string const& scan, std::string cursor)
+{
+    pending_[scan] = std::move(cursor);
+}
+
+void
+Context::commit()
+{
+    backend.sync();
+    for (auto& [scan, cursor] : pending_)
+    {
+        store.writeCheckpoint(version, scan, cursor);
+        committed_[scan] = std::move(cursor);
+    }
+    pending_.clear();
+}
+
+void
+Context::report(std::string const& tag, bool force)
+{
+    using namespace std::chrono;
+
+    auto const now = steady_clock::now();
+    if (!force && now - lastReport_ < seconds(10))
+        return;
+    lastReport_ = now;
+
+    auto const elapsed = duration<double>(now - start_).count();
+    log_.info() << tag << ": scanned " << rowsScanned << " rows ("
+                << rowsScanned / std::max(elapsed, 1.0) << "/s), wrote "
+                << recordsWritten << " records ("
+                << recordsWritten / std::max(elapsed, 1.0)
+                << "/s) in " << elapsed << " seconds";
+}
+
+}  // namespace Migrations
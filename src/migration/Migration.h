@@ -0,0 +1,238 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <backend/CassandraBackend.h>
+#include <log/Logger.h>
+
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Migrations {
+
+class MigrationStore;
+
+/// Settings shared by every migration, from the "migration" config section
+struct Options
+{
+    // budget of database operations per second, shared by all scans and
+    // writes of a migration. 0 means unlimited. Keeps a migration from
+    // starving a live ETL writer of the same cluster
+    double opsPerSecond = 0;
+    // number of key ranges a ledger scan walks in parallel
+    std::size_t numMarkers = 16;
+    // number of records buffered by a BatchWriter before they are written
+    std::size_t batchSize = 10000;
+    // reads that time out are retried this many times, this far apart
+    std::uint32_t maxRetries = 5;
+    std::chrono::seconds retryWait{60};
+};
+
+/**
+ * @brief Paces database operations to a budget of operations per second.
+ *
+ * Coroutines acquire the operations they are about to issue and are
+ * suspended until the budget allows them. Not thread safe; all users must
+ * run on the same strand.
+ */
+class Throttle
+{
+    boost::asio::io_context& ioc_;
+    double opsPerSecond_;
+    std::chrono::steady_clock::time_point next_ =
+        std::chrono::steady_clock::now();
+
+public:
+    Throttle(boost::asio::io_context& ioc, double opsPerSecond)
+        : ioc_(ioc), opsPerSecond_(opsPerSecond)
+    {
+    }
+
+    void
+    acquire(std::size_t ops, boost::asio::yield_context& yield);
+};
+
+/**
+ * @brief Everything a running migration has access to.
+ *
+ * Besides the backend, the context keeps the scan checkpoints of the
+ * migration and its progress counters. Checkpoints are only persisted by
+ * commit(), once every write issued before it has completed, so a restarted
+ * migration never skips data that was not written.
+ *
+ * Migrations run on a single threaded io_context. Concurrent scans are
+ * coroutines sharing the context without locking.
+ */
+class Context
+{
+    clio::Logger log_{"Migration"};
+
+    std::map<std::string, std::string> committed_;
+    std::map<std::string, std::string> pending_;
+    std::chrono::steady_clock::time_point start_ =
+        std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastReport_ = start_;
+
+public:
+    Backend::CassandraBackend& backend;
+    boost::asio::io_context& ioc;
+    MigrationStore& store;
+    Options const& options;
+    Throttle throttle;
+    Backend::LedgerRange range;
+    std::uint32_t version;
+
+    std::size_t rowsScanned = 0;
+    std::size_t recordsWritten = 0;
+
+    Context(
+        Backend::CassandraBackend& backend,
+        boost::asio::io_context& ioc,
+        MigrationStore& store,
+        Options const& options,
+        Backend::LedgerRange const& range,
+        std::uint32_t version);
+
+    /// Read the checkpoints persisted by an earlier, interrupted run
+    void
+    loadCheckpoints(boost::asio::yield_context& yield);
+
+    /// The persisted cursor of a scan. An empty cursor means the scan has
+    /// completed; nullopt that it never committed any progress
+    std::optional<std::string>
+    checkpoint(std::string const& scan) const;
+
+    /// Record the cursor of a scan, to be persisted by the next commit()
+    void
+    setCheckpoint(std::string const& scan, std::string cursor);
+
+    /// Wait for every write issued so far, then persist the pending
+    /// checkpoints. Every BatchWriter commits when it flushes, so a migration
+    /// with more than one writer must flush all of them before a commit
+    void
+    commit();
+
+    /// Log the progress counters, at most every few seconds unless forced
+    void
+    report(std::string const& tag, bool force = false);
+
+    /// Call f, retrying on DatabaseTimeout as configured
+    template <class F>
+    auto
+    retry(F&& f, boost::asio::yield_context& yield)
+    {
+        for (std::uint32_t attempt = 0;; ++attempt)
+        {
+            try
+            {
+                return f();
+            }
+            catch (Backend::DatabaseTimeout const&)
+            {
+                if (attempt >= options.maxRetries)
+                    throw;
+                log_.warn() << "Database timeout. Retrying in "
+                            << options.retryWait.count() << " seconds";
+                boost::asio::steady_timer timer{ioc, options.retryWait};
+                boost::system::error_code ec;
+                timer.async_wait(yield[ec]);
+            }
+        }
+    }
+};
+
+/**
+ * @brief A versioned change to the data or schema of the database.
+ *
+ * Migrations are run once each, in increasing order of version, by the
+ * MigrationRunner. Most are a scan of a table or a ledger (see Scans.h),
+ * a transform of each page and a BatchWriter.
+ */
+class Migration
+{
+public:
+    virtual ~Migration() = default;
+
+    virtual std::uint32_t
+    version() const = 0;
+
+    virtual std::string
+    description() const = 0;
+
+    virtual void
+    run(Context& ctx, boost::asio::yield_context& yield) = 0;
+};
+
+/**
+ * @brief Buffers the records produced by a migration and writes them in
+ * batches, within the throttle budget. Each flush commits the context.
+ */
+template <class T>
+class BatchWriter
+{
+    Context& ctx_;
+    std::function<void(std::vector<T>&&)> write_;
+    std::vector<T> buffer_;
+
+public:
+    BatchWriter(Context& ctx, std::function<void(std::vector<T>&&)> write)
+        : ctx_(ctx), write_(std::move(write))
+    {
+    }
+
+    void
+    add(std::vector<T>&& records, boost::asio::yield_context& yield)
+    {
+        buffer_.insert(
+            buffer_.end(),
+            std::make_move_iterator(records.begin()),
+            std::make_move_iterator(records.end()));
+        if (buffer_.size() >= ctx_.options.batchSize)
+            flush(yield);
+    }
+
+    void
+    flush(boost::asio::yield_context& yield)
+    {
+        if (!buffer_.empty())
+            ctx_.throttle.acquire(buffer_.size(), yield);
+
+        // Nothing below suspends, so every checkpoint pending at this point
+        // covers records that are in the buffer, even if other scans added to
+        // it while we were waiting on the throttle
+        if (!buffer_.empty())
+        {
+            ctx_.recordsWritten += buffer_.size();
+            write_(std::move(buffer_));
+            buffer_ = {};
+        }
+        ctx_.commit();
+    }
+};
+
+}  // namespace Migrations
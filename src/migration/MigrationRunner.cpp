@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <etl/ETLHelpers.h>
+#include <migration/MigrationRunner.h>
+#include <migration/MigrationStore.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Migrations {
+
+Options
+makeOptions(clio::Config const& config)
+{
+    Options options;
+    options.opsPerSecond = config.valueOr<double>(
+        "migration.ops_per_second", options.opsPerSecond);
+    options.numMarkers = std::clamp<std::size_t>(
+        config.valueOr<std::size_t>("migration.markers", options.numMarkers),
+        1,
+        maxMarkers);
+    options.batchSize = config.valueOr<std::size_t>(
+        "migration.batch_size", options.batchSize);
+    options.maxRetries = config.valueOr<std::uint32_t>(
+        "migration.max_retries", options.maxRetries);
+    options.retryWait = std::chrono::seconds{config.valueOr<std::uint32_t>(
+        "migration.retry_wait_seconds",
+        static_cast<std::uint32_t>(options.retryWait.count()))};
+    return options;
+}
+
+void
+MigrationRunner::add(std::unique_ptr<Migration> migration)
+{
+    auto const version = migration->version();
+    auto it = std::lower_bound(
+        migrations_.begin(),
+        migrations_.end(),
+        version,
+        [](auto const& m, std::uint32_t v) { return m->version() < v; });
+    if (it != migrations_.end() && (*it)->version() == version)
+        throw std::runtime_error(
+            "Duplicate migration version " + std::to_string(version));
+    migrations_.insert(it, std::move(migration));
+}
+
+void
+MigrationRunner::run(
+    Backend::CassandraBackend& backend,
+    boost::asio::io_context& ioc,
+    Options const& options,
+    boost::asio::yield_context& yield)
+{
+    auto const range = backend.hardFetchLedgerRangeNoThrow(yield);
+    if (!range)
+    {
+        log_.info() << "There is no data to migrate";
+        return;
+    }
+
+    MigrationStore store{backend};
+    auto const applied = store.appliedVersions(yield);
+
+    for (auto const& migration : migrations_)
+    {
+        auto const version = migration->version();
+        if (applied.contains(version))
+        {
+            log_.info() << "Migration " << version << " already applied";
+            continue;
+        }
+
+        log_.info() << "Running migration " << version << " - "
+                    << migration->description() << " over ledgers "
+                    << range->minSequence << " to " << range->maxSequence;
+
+        Context ctx{backend, ioc, store, options, *range, version};
+        ctx.loadCheckpoints(yield);
+        migration->run(ctx, yield);
+        ctx.commit();
+        ctx.report("Migration " + std::to_string(version), true);
+
+        store.markApplied(version, migration->description());
+        store.clearCheckpoints(version);
+        log_.info() << "Migration " << version << " done";
+    }
+}
+
+}  // namespace Migrations
@@ -0,0 +1,63 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <config/Config.h>
+#include <log/Logger.h>
+#include <migration/Migration.h>
+
+#include <boost/asio/spawn.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace Migrations {
+
+/// Read the "migration" section of the config
+Options
+makeOptions(clio::Config const& config);
+
+/**
+ * @brief Runs every registered migration that has not been applied to the
+ * database yet, in increasing order of version.
+ *
+ * A migration is marked as applied once it returns, and its checkpoints are
+ * then removed. A migration that throws is left pending and resumes from its
+ * last committed checkpoints on the next run.
+ */
+class MigrationRunner
+{
+    clio::Logger log_{"Migration"};
+
+    std::vector<std::unique_ptr<Migration>> migrations_;
+
+public:
+    /// Register a migration. Throws if its version is already registered
+    void
+    add(std::unique_ptr<Migration> migration);
+
+    void
+    run(Backend::CassandraBackend& backend,
+        boost::asio::io_context& ioc,
+        Options const& options,
+        boost::asio::yield_context& yield);
+};
+
+}  // namespace Migrations
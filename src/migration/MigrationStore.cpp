@@ -0,0 +1,178 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <migration/MigrationStore.h>
+
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+namespace Migrations {
+
+namespace {
+
+void
+executeSimpleStatement(CassSession* session, std::string const& query)
+{
+    CassStatement* statement = cass_statement_new(query.c_str(), 0);
+    CassFuture* fut = cass_session_execute(session, statement);
+    CassError const rc = cass_future_error_code(fut);
+    cass_future_free(fut);
+    cass_statement_free(statement);
+
+    if (rc != CASS_OK)
+    {
+        std::stringstream ss;
+        ss << "Error executing " << query << ": " << cass_error_desc(rc);
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void
+prepare(
+    Backend::CassandraPreparedStatement& prepared,
+    std::stringstream const& query,
+    CassSession* session)
+{
+    if (!prepared.prepareStatement(query, session))
+        throw std::runtime_error("Error preparing " + query.str());
+}
+
+}  // namespace
+
+MigrationStore::MigrationStore(Backend::CassandraBackend& backend)
+    : backend_(backend)
+{
+    auto* session = backend_.cautionGetSession();
+    auto const prefix = backend_.tablePrefix();
+
+    std::stringstream query;
+    query << "CREATE TABLE IF NOT EXISTS " << prefix << "migrations"
+          << " (version bigint PRIMARY KEY, description text,"
+          << " applied_at timestamp)";
+    executeSimpleStatement(session, query.str());
+
+    query.str("");
+    query << "CREATE TABLE IF NOT EXISTS " << prefix
+          << "migration_checkpoints"
+          << " (version bigint, scan text, cursor blob,"
+          << " PRIMARY KEY (version, scan))";
+    executeSimpleStatement(session, query.str());
+
+    query.str("");
+    query << "SELECT version FROM " << prefix << "migrations";
+    prepare(selectApplied_, query, session);
+
+    query.str("");
+    query << "INSERT INTO " << prefix << "migrations"
+          << " (version, description, applied_at) VALUES (?,?,?)";
+    prepare(insertApplied_, query, session);
+
+    query.str("");
+    query << "SELECT scan, cursor FROM " << prefix << "migration_checkpoints"
+          << " WHERE version = ?";
+    prepare(selectCheckpoints_, query, session);
+
+    query.str("");
+    query << "INSERT INTO " << prefix << "migration_checkpoints"
+          << " (version, scan, cursor) VALUES (?,?,?)";
+    prepare(insertCheckpoint_, query, session);
+
+    query.str("");
+    query << "DELETE FROM " << prefix << "migration_checkpoints"
+          << " WHERE version = ?";
+    prepare(deleteCheckpoints_, query, session);
+}
+
+std::set<std::uint32_t>
+MigrationStore::appliedVersions(boost::asio::yield_context& yield) const
+{
+    Backend::CassandraStatement statement{selectApplied_};
+    auto result = backend_.executeAsyncRead(statement, yield);
+
+    std::set<std::uint32_t> versions;
+    if (!result.hasResult())
+        return versions;
+    do
+    {
+        versions.insert(result.getUInt32());
+    } while (result.nextRow());
+    return versions;
+}
+
+void
+MigrationStore::markApplied(
+    std::uint32_t version,
+    std::string const& description)
+{
+    auto const now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+
+    Backend::CassandraStatement statement{insertApplied_};
+    statement.bindNextInt(version);
+    statement.bindNextString(description);
+    statement.bindNextInt(static_cast<std::int64_t>(now.count()));
+    backend_.executeSyncWrite(statement);
+}
+
+std::map<std::string, std::string>
+MigrationStore::checkpoints(
+    std::uint32_t version,
+    boost::asio::yield_context& yield) const
+{
+    Backend::CassandraStatement statement{selectCheckpoints_};
+    statement.bindNextInt(version);
+    auto result = backend_.executeAsyncRead(statement, yield);
+
+    std::map<std::string, std::string> cursors;
+    if (!result.hasResult())
+        return cursors;
+    do
+    {
+        auto scan = result.getBytes();
+        auto cursor = result.getBytes();
+        cursors.emplace(
+            std::string{scan.begin(), scan.end()},
+            std::string{cursor.begin(), cursor.end()});
+    } while (result.nextRow());
+    return cursors;
+}
+
+void
+MigrationStore::writeCheckpoint(
+    std::uint32_t version,
+    std::string const& scan,
+    std::string const& cursor)
+{
+    Backend::CassandraStatement statement{insertCheckpoint_};
+    statement.bindNextInt(version);
+    statement.bindNextString(scan);
+    statement.bindNextBytes(cursor);
+    backend_.executeSyncWrite(statement);
+}
+
+void
+MigrationStore::clearCheckpoints(std::uint32_t version)
+{
+    Backend::CassandraStatement statement{deleteCheckpoints_};
+    statement.bindNextInt(version);
+    backend_.executeSyncWrite(statement);
+}
+
+}  // namespace Migrations
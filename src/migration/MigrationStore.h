@@ -0,0 +1,78 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <backend/CassandraBackend.h>
+#include <log/Logger.h>
+
+#include <boost/asio/spawn.hpp>
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+namespace Migrations {
+
+/**
+ * @brief Records which migrations have been applied, and the checkpoints of
+ * the one in progress, in tables next to the data being migrated:
+ *
+ *     migrations (version, description, applied_at)
+ *     migration_checkpoints (version, scan, cursor)
+ */
+class MigrationStore
+{
+    clio::Logger log_{"Migration"};
+
+    Backend::CassandraBackend& backend_;
+
+    Backend::CassandraPreparedStatement selectApplied_;
+    Backend::CassandraPreparedStatement insertApplied_;
+    Backend::CassandraPreparedStatement selectCheckpoints_;
+    Backend::CassandraPreparedStatement insertCheckpoint_;
+    Backend::CassandraPreparedStatement deleteCheckpoints_;
+
+public:
+    /// Creates the tables if they do not exist yet
+    explicit MigrationStore(Backend::CassandraBackend& backend);
+
+    std::set<std::uint32_t>
+    appliedVersions(boost::asio::yield_context& yield) const;
+
+    void
+    markApplied(std::uint32_t version, std::string const& description);
+
+    /// Cursors of every scan of the given migration, by scan name
+    std::map<std::string, std::string>
+    checkpoints(std::uint32_t version, boost::asio::yield_context& yield)
+        const;
+
+    void
+    writeCheckpoint(
+        std::uint32_t version,
+        std::string const& scan,
+        std::string const& cursor);
+
+    void
+    clearCheckpoints(std::uint32_t version);
+};
+
+}  // namespace Migrations
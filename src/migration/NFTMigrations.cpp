@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <backend/DBHelpers.h>
+#include <etl/NFTHelpers.h>
+#include <migration/NFTMigrations.h>
+#include <migration/Scans.h>
+
+#include <sstream>
+
+// local to compilation unit loggers
+namespace {
+clio::Logger gLog{"Migration"};
+}  // namespace
+
+namespace Migrations {
+
+void
+NFTokenMintURIs::run(Context& ctx, boost::asio::yield_context& yield)
+{
+    BatchWriter<NFTsData> writer{ctx, [&](std::vector<NFTsData>&& nfts) {
+                                     ctx.backend.writeNFTs(std::move(nfts));
+                                 }};
+
+    std::stringstream query;
+    query << "SELECT hash FROM " << ctx.backend.tablePrefix()
+          << "nf_token_transactions";
+
+    scanTable(
+        ctx,
+        "nf_token_transactions",
+        query.str(),
+        1000,
+        [&](Backend::CassandraResult& result,
+            boost::asio::yield_context& yield) {
+            std::vector<ripple::uint256> hashes;
+            do
+            {
+                hashes.push_back(result.getUInt256());
+            } while (result.nextRow());
+
+            auto const txs = ctx.retry(
+                [&]() { return ctx.backend.fetchTransactions(hashes, yield); },
+                yield);
+
+            std::vector<NFTsData> nfts;
+            for (auto const& tx : txs)
+            {
+                if (tx.ledgerSequence > ctx.range.maxSequence)
+                    continue;
+
+                ripple::STTx const sttx{ripple::SerialIter{
+                    tx.transaction.data(), tx.transaction.size()}};
+                if (sttx.getTxnType() != ripple::TxType::ttNFTOKEN_MINT)
+                    continue;
+
+                ripple::TxMeta const txMeta{
+                    sttx.getTransactionID(), tx.ledgerSequence, tx.metadata};
+                nfts.push_back(
+                    std::get<1>(getNFTDataFromTx(txMeta, sttx)).value());
+            }
+            writer.add(std::move(nfts), yield);
+        },
+        yield);
+
+    writer.flush(yield);
+}
+
+void
+InitialLedgerNFTs::run(Context& ctx, boost::asio::yield_context& yield)
+{
+    BatchWriter<NFTsData> writer{ctx, [&](std::vector<NFTsData>&& nfts) {
+                                     ctx.backend.writeNFTs(std::move(nfts));
+                                 }};
+    auto const sequence = ctx.range.minSequence;
+
+    scanLedger(
+        ctx,
+        "initial_ledger",
+        sequence,
+        10000,
+        [&](std::vector<Backend::LedgerObject>&& objects,
+            boost::asio::yield_context& yield) {
+            std::vector<NFTsData> nfts;
+            for (auto const& object : objects)
+            {
+                if (!isNFTokenPage(object.blob))
+                    continue;
+
+                auto const objectNFTs = getNFTDataFromObj(
+                    sequence,
+                    std::string(object.key.begin(), object.key.end()),
+                    std::string(object.blob.begin(), object.blob.end()));
+                nfts.insert(nfts.end(), objectNFTs.begin(), objectNFTs.end());
+            }
+            writer.add(std::move(nfts), yield);
+        },
+        yield);
+
+    writer.flush(yield);
+}
+
+void
+DropIssuerNFTokens::run(Context& ctx, boost::asio::yield_context&)
+{
+    std::stringstream query;
+    query << "DROP TABLE IF EXISTS " << ctx.backend.tablePrefix()
+          << "issuer_nf_tokens";
+    CassStatement* statement = cass_statement_new(query.str().c_str(), 0);
+    CassFuture* fut =
+        cass_session_execute(ctx.backend.cautionGetSession(), statement);
+    CassError const rc = cass_future_error_code(fut);
+    cass_future_free(fut);
+    cass_statement_free(statement);
+
+    if (rc != CASS_OK)
+        gLog.warn() << "Could not drop old issuer_nf_tokens table. If it "
+                       "still exists, you should drop it yourself";
+}
+
+}  // namespace Migrations
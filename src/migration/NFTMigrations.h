@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <migration/Migration.h>
+
+/// The migrations that fix up NFT data written by earlier versions of clio
+namespace Migrations {
+
+/**
+ * @brief Look at all NFT transactions recorded in `nf_token_transactions` and
+ * reload any NFTokenMint transactions. These will contain the URI of any
+ * tokens that were minted after our start sequence. We look at transactions
+ * for this step instead of directly at the tokens in `nf_tokens` because we
+ * also want to cover the extreme edge case of a token that is re-minted with
+ * a different URI.
+ */
+class NFTokenMintURIs : public Migration
+{
+public:
+    std::uint32_t
+    version() const override
+    {
+        return 1;
+    }
+
+    std::string
+    description() const override
+    {
+        return "Load URIs of minted NFTs from nf_token_transactions";
+    }
+
+    void
+    run(Context& ctx, boost::asio::yield_context& yield) override;
+};
+
+/**
+ * @brief Pull every object from our initial ledger and load all NFTs found in
+ * any NFTokenPage object. Prior to this migration, we were not pulling out
+ * NFTs from the initial ledger, so all these NFTs would be missed. This will
+ * also record the URI of any NFTs minted prior to the start sequence.
+ */
+class InitialLedgerNFTs : public Migration
+{
+public:
+    std::uint32_t
+    version() const override
+    {
+        return 2;
+    }
+
+    std::string
+    description() const override
+    {
+        return "Load NFTs of the initial ledger";
+    }
+
+    void
+    run(Context& ctx, boost::asio::yield_context& yield) override;
+};
+
+/**
+ * @brief Drop the old `issuer_nf_tokens` table, which is replaced by
+ * `issuer_nf_tokens_v2`. Normally, we should probably not drop old tables in
+ * migrations, but here it is safe since the old table wasn't yet being used
+ * to serve any data anyway.
+ */
+class DropIssuerNFTokens : public Migration
+{
+public:
+    std::uint32_t
+    version() const override
+    {
+        return 3;
+    }
+
+    std::string
+    description() const override
+    {
+        return "Drop issuer_nf_tokens";
+    }
+
+    void
+    run(Context& ctx, boost::asio::yield_context& yield) override;
+};
+
+}  // namespace Migrations
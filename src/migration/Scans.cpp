@@ -0,0 +1,260 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <migration/Scans.h>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <optional>
+#include <set>
+#include <sstream>
+
+// local to compilation unit loggers
+namespace {
+clio::Logger gLog{"Migration"};
+
+// number of ledgers whose diffs seed the ranges of a ledger scan
+constexpr std::uint32_t numSeedLedgers = 16;
+}  // namespace
+
+namespace Migrations {
+
+void
+scanTable(
+    Context& ctx,
+    std::string const& name,
+    std::string const& query,
+    std::uint32_t pageSize,
+    TablePageHandler const& onPage,
+    boost::asio::yield_context& yield)
+{
+    auto pagingState = ctx.checkpoint(name);
+    if (pagingState && pagingState->empty())
+    {
+        gLog.info() << name << ": already scanned";
+        return;
+    }
+    if (pagingState)
+        gLog.info() << name << ": resuming from checkpoint";
+
+    std::stringstream ss;
+    ss << query;
+    Backend::CassandraPreparedStatement prepared;
+    if (!prepared.prepareStatement(ss, ctx.backend.cautionGetSession()))
+        throw std::runtime_error(name + ": could not prepare " + query);
+
+    std::string state = pagingState.value_or("");
+    do
+    {
+        ctx.throttle.acquire(pageSize, yield);
+
+        Backend::CassandraStatement statement{prepared};
+        statement.setPaging(pageSize, state);
+        auto result = ctx.retry(
+            [&]() { return ctx.backend.executeAsyncRead(statement, yield); },
+            yield);
+
+        state = result.pagingState();
+        ctx.rowsScanned += result.numRows();
+        if (result.hasResult())
+            onPage(result, yield);
+
+        // an empty paging state marks the scan as done
+        ctx.setCheckpoint(name, state);
+        ctx.report(name);
+    } while (!state.empty());
+}
+
+std::vector<ripple::uint256>
+ledgerScanBoundaries(
+    BackendInterface const& backend,
+    std::uint32_t sequence,
+    std::size_t numRanges,
+    boost::asio::yield_context& yield)
+{
+    if (numRanges < 2)
+        return {};
+
+    // Objects changed by the following ledgers are spread evenly over the
+    // key space. The ones that already existed at sequence are in the
+    // successor table there
+    std::set<ripple::uint256> seen;
+    for (std::uint32_t i = 0; i < numSeedLedgers; ++i)
+    {
+        for (auto& object : backend.fetchLedgerDiff(sequence + i, yield))
+            seen.insert(object.key);
+    }
+    std::vector<ripple::uint256> candidates{seen.begin(), seen.end()};
+    auto const blobs = backend.fetchLedgerObjects(candidates, sequence, yield);
+
+    std::vector<ripple::uint256> keys;
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+    {
+        if (blobs[i].size())
+            keys.push_back(candidates[i]);
+    }
+
+    auto const numBoundaries = std::min(numRanges - 1, keys.size());
+    std::vector<ripple::uint256> boundaries;
+    for (std::size_t i = 1; i <= numBoundaries; ++i)
+        boundaries.push_back(keys[i * keys.size() / (numBoundaries + 1)]);
+    return boundaries;
+}
+
+Backend::LedgerPage
+fetchLedgerRangePage(
+    BackendInterface const& backend,
+    std::optional<ripple::uint256> const& cursor,
+    std::optional<ripple::uint256> const& end,
+    std::uint32_t sequence,
+    std::uint32_t pageSize,
+    boost::asio::yield_context& yield)
+{
+    auto page =
+        backend.fetchLedgerPage(cursor, sequence, pageSize, false, yield);
+    if (!end)
+        return page;
+
+    auto& objects = page.objects;
+    auto it = std::find_if(
+        objects.begin(), objects.end(), [&](auto const& object) {
+            return object.key > *end;
+        });
+    if (it != objects.end())
+    {
+        objects.erase(it, objects.end());
+        page.cursor = {};
+    }
+    else if (page.cursor && *page.cursor >= *end)
+    {
+        page.cursor = {};
+    }
+    return page;
+}
+
+void
+scanLedger(
+    Context& ctx,
+    std::string const& name,
+    std::uint32_t sequence,
+    std::uint32_t pageSize,
+    LedgerPageHandler const& onPage,
+    boost::asio::yield_context& yield)
+{
+    auto const boundaries = ctx.retry(
+        [&]() {
+            return ledgerScanBoundaries(
+                ctx.backend, sequence, ctx.options.numMarkers, yield);
+        },
+        yield);
+    auto const numRanges = boundaries.size() + 1;
+    gLog.info() << name << ": scanning in " << numRanges << " ranges";
+
+    std::size_t numRemaining = numRanges;
+    std::exception_ptr error;
+    boost::asio::steady_timer done{
+        ctx.ioc, boost::asio::steady_timer::time_point::max()};
+
+    for (std::size_t i = 0; i < numRanges; ++i)
+    {
+        // the number of ranges is part of the name, so that checkpoints of a
+        // scan split differently are not mixed up
+        auto const scan = name + "/" + std::to_string(i) + "of" +
+            std::to_string(numRanges);
+
+        // the cursor is the key of the last object handed to onPage
+        std::optional<ripple::uint256> cursor;
+        if (i != 0)
+            cursor = boundaries[i - 1];
+        if (auto checkpoint = ctx.checkpoint(scan); checkpoint)
+        {
+            if (checkpoint->empty())
+            {
+                --numRemaining;
+                continue;
+            }
+            cursor = ripple::uint256::fromVoid(checkpoint->data());
+        }
+
+        // keys up to and including the next boundary belong to this range
+        std::optional<ripple::uint256> end;
+        if (i != boundaries.size())
+            end = boundaries[i];
+
+        boost::asio::spawn(
+            yield,
+            [&, scan, cursor, end](boost::asio::yield_context yield) mutable {
+                try
+                {
+                    bool more = true;
+                    while (more && !error)
+                    {
+                        ctx.throttle.acquire(pageSize, yield);
+                        auto page = ctx.retry(
+                            [&]() {
+                                return fetchLedgerRangePage(
+                                    ctx.backend,
+                                    cursor,
+                                    end,
+                                    sequence,
+                                    pageSize,
+                                    yield);
+                            },
+                            yield);
+
+                        auto& objects = page.objects;
+                        more = page.cursor.has_value();
+                        ctx.rowsScanned += objects.size();
+                        if (more)
+                            cursor = page.cursor;
+
+                        if (!objects.empty())
+                            onPage(std::move(objects), yield);
+
+                        ctx.setCheckpoint(
+                            scan,
+                            more ? std::string{cursor->begin(), cursor->end()}
+                                 : std::string{});
+                        ctx.report(name);
+                    }
+                }
+                catch (...)
+                {
+                    if (!error)
+                        error = std::current_exception();
+                }
+
+                if (--numRemaining == 0)
+                    done.cancel();
+            });
+    }
+
+    if (numRemaining != 0)
+    {
+        boost::system::error_code ec;
+        done.async_wait(yield[ec]);
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+}  // namespace Migrations
@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <migration/Migration.h>
+
+#include <boost/asio/spawn.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// Resumable, throttled scans that migrations are built from. A scan records
+/// its cursor in the context after each page, under the given name, and
+/// resumes from the last committed cursor when a migration is restarted.
+namespace Migrations {
+
+using TablePageHandler = std::function<
+    void(Backend::CassandraResult&, boost::asio::yield_context&)>;
+
+using LedgerPageHandler = std::function<void(
+    std::vector<Backend::LedgerObject>&&,
+    boost::asio::yield_context&)>;
+
+/// Page through the rows returned by a CQL query. The cursor is the driver's
+/// paging state, so the query must be the same across restarts
+void
+scanTable(
+    Context& ctx,
+    std::string const& name,
+    std::string const& query,
+    std::uint32_t pageSize,
+    TablePageHandler const& onPage,
+    boost::asio::yield_context& yield);
+
+/// Keys of objects in the ledger at the given sequence that split its state
+/// map into at most numRanges ranges of about the same size. Walking the
+/// successor table only works from keys it holds, so the ranges start from
+/// keys found in the diffs of the ledgers that follow sequence and not from
+/// synthetic markers
+std::vector<ripple::uint256>
+ledgerScanBoundaries(
+    BackendInterface const& backend,
+    std::uint32_t sequence,
+    std::size_t numRanges,
+    boost::asio::yield_context& yield);
+
+/// One page of the objects after cursor, up to and including end. The
+/// cursor of the page is unset once the range is done
+Backend::LedgerPage
+fetchLedgerRangePage(
+    BackendInterface const& backend,
+    std::optional<ripple::uint256> const& cursor,
+    std::optional<ripple::uint256> const& end,
+    std::uint32_t sequence,
+    std::uint32_t pageSize,
+    boost::asio::yield_context& yield);
+
+/// Page through every object of the ledger at the given sequence. The key
+/// space is split into up to Options::numMarkers ranges that are walked
+/// concurrently, each with its own checkpoint
+void
+scanLedger(
+    Context& ctx,
+    std::string const& name,
+    std::uint32_t sequence,
+    std::uint32_t pageSize,
+    LedgerPageHandler const& onPage,
+    boost::asio::yield_context& yield);
+
+}  // namespace Migrations
@@ -264,6 +264,59 @@ isClioOnly(string const& method)
     return handlerTable.isClioOnly(method);
 }
 
+// Commands reading as many objects as their limit allows, walking the state
+// map, an order book or a history
+static unordered_set<string> scanCommands{
+    "account_channels",
+    "account_lines",
+    "account_nfts",
+    "account_objects",
+    "account_offers",
+    "account_tx",
+    "book_changes",
+    "book_offers",
+    "gateway_balances",
+    "ledger_data",
+    "nft_history",
+    "noripple_check"};
+
+WorkQueue::Lane
+laneFor(boost::json::object const& request)
+{
+    // websocket requests name a command and are flat, JSON-RPC ones name a
+    // method and hold their parameters in an array
+    auto const* params = &request;
+    auto const* method = request.if_contains("command");
+    if (!method)
+    {
+        method = request.if_contains("method");
+        auto const* array = request.if_contains("params");
+        if (array && array->is_array() && !array->as_array().empty() &&
+            array->as_array()[0].is_object())
+            params = &array->as_array()[0].as_object();
+    }
+
+    if (!method || !method->is_string())
+        return WorkQueue::Lane::lookup;
+
+    string const name = method->as_string().c_str();
+    if (scanCommands.contains(name))
+        return WorkQueue::Lane::scan;
+
+    // a ledger is cheap, unless its transactions or state are included
+    if (name == "ledger")
+    {
+        for (auto const* field : {"transactions", "full", "accounts"})
+        {
+            auto const* flag = params->if_contains(field);
+            if (flag && flag->is_bool() && flag->as_bool())
+                return WorkQueue::Lane::scan;
+        }
+    }
+
+    return WorkQueue::Lane::lookup;
+}
+
 bool
 shouldSuppressValidatedFlag(RPC::Context const& context)
 {
@@ -327,6 +380,8 @@ shouldForwardToRippled(Context const& ctx)
 Result
 buildResponse(Context const& ctx)
 {
+    Backend::ScopedReadMeter scopedMeter{ctx.yield, ctx.meter};
+
     if (shouldForwardToRippled(ctx))
     {
         boost::json::object toForward = ctx.params;
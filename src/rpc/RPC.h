@@ -68,6 +68,8 @@ struct Context : public util::Taggable
     Backend::LedgerRange const& range;
     Counters& counters;
     std::string clientIp;
+    // database work done by the handler, metered by buildResponse
+    mutable Backend::ReadMeter meter;
 
     Context(
         boost::asio::yield_context& yield_,
@@ -141,6 +143,11 @@ validHandler(std::string const& method);
 bool
 isClioOnly(std::string const& method);
 
+/// The work queue lane of a websocket or JSON-RPC request, by how expensive
+/// its method is expected to be
+WorkQueue::Lane
+laneFor(boost::json::object const& request);
+
 Status
 getLimit(RPC::Context const& context, std::uint32_t& limit);
 
@@ -152,7 +159,10 @@ logDuration(Context const& ctx, T const& dur)
     std::stringstream ss;
     ss << ctx.tag() << "Request processing duration = "
        << std::chrono::duration_cast<std::chrono::milliseconds>(dur).count()
-       << " milliseconds. request = " << ctx.params;
+       << " milliseconds. reads = " << ctx.meter.reads
+       << " rows = " << ctx.meter.rows
+       << " cache_hits = " << ctx.meter.cacheHits
+       << ". request = " << ctx.params;
     auto seconds =
         std::chrono::duration_cast<std::chrono::seconds>(dur).count();
     if (seconds > 10)
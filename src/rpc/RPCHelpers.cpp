@@ -19,6 +19,7 @@
 
 #include <ripple/basics/StringUtilities.h>
 #include <backend/BackendInterface.h>
+#include <backend/DirectoryPrefetcher.h>
 #include <log/Logger.h>
 #include <rpc/RPCHelpers.h>
 #include <util/Profiler.h>
@@ -736,7 +737,6 @@ traverseOwnedNodes(
     auto cursor = AccountCursor({beast::zero, 0});
 
     auto const rootIndex = owner;
-    auto currentIndex = rootIndex;
     // track the current page we are accessing, will return it as the next hint
     auto currentPage = startHint;
 
@@ -748,20 +748,18 @@ traverseOwnedNodes(
 
     auto start = std::chrono::system_clock::now();
 
+    // reads the directory pages ahead of the walk
+    Backend::DirectoryPrefetcher pages{backend, rootIndex.key, sequence};
+
     // If startAfter is not zero try jumping to that page using the hint
     if (hexMarker.isNonZero())
     {
-        auto const hintIndex = ripple::keylet::page(rootIndex, startHint);
-        auto hintDir =
-            backend.fetchLedgerObject(hintIndex.key, sequence, yield);
+        auto const hintDir = pages.fetchPage(startHint, limit, yield);
 
         if (!hintDir)
             return Status(ripple::rpcINVALID_PARAMS, "Invalid marker");
 
-        ripple::SerialIter it{hintDir->data(), hintDir->size()};
-        ripple::SLE sle{it, hintIndex.key};
-
-        if (auto const& indexes = sle.getFieldV256(ripple::sfIndexes);
+        if (auto const& indexes = hintDir->getFieldV256(ripple::sfIndexes);
             std::find(std::begin(indexes), std::end(indexes), hexMarker) ==
             std::end(indexes))
         {
@@ -769,19 +767,16 @@ traverseOwnedNodes(
             return AccountCursor({beast::zero, 0});
         }
 
-        currentIndex = hintIndex;
         bool found = false;
         for (;;)
         {
-            auto const ownerDir =
-                backend.fetchLedgerObject(currentIndex.key, sequence, yield);
+            auto const ownerDir = pages.fetchPage(currentPage, limit, yield);
 
             if (!ownerDir)
                 return Status(
                     ripple::rpcINVALID_PARAMS, "Owner directory not found");
 
-            ripple::SerialIter it{ownerDir->data(), ownerDir->size()};
-            ripple::SLE sle{it, currentIndex.key};
+            auto const& sle = *ownerDir;
 
             for (auto const& key : sle.getFieldV256(ripple::sfIndexes))
             {
@@ -811,22 +806,20 @@ traverseOwnedNodes(
             if (uNodeNext == 0)
                 break;
 
-            currentIndex = ripple::keylet::page(rootIndex, uNodeNext);
             currentPage = uNodeNext;
         }
     }
     else
     {
+        std::uint64_t page = 0;
         for (;;)
         {
-            auto const ownerDir =
-                backend.fetchLedgerObject(currentIndex.key, sequence, yield);
+            auto const ownerDir = pages.fetchPage(page, limit, yield);
 
             if (!ownerDir)
                 break;
 
-            ripple::SerialIter it{ownerDir->data(), ownerDir->size()};
-            ripple::SLE sle{it, currentIndex.key};
+            auto const& sle = *ownerDir;
 
             for (auto const& key : sle.getFieldV256(ripple::sfIndexes))
             {
@@ -846,7 +839,7 @@ traverseOwnedNodes(
             if (uNodeNext == 0)
                 break;
 
-            currentIndex = ripple::keylet::page(rootIndex, uNodeNext);
+            page = uNodeNext;
             currentPage = uNodeNext;
         }
     }
@@ -1612,7 +1605,12 @@ traverseTransactions(
         cursor = {*ledgerIndex, *transactionIndex};
     }
 
-    auto minIndex = context.range.minSequence;
+    // backfilled ledgers below the ledger range hold their transactions
+    auto const historyMin = std::min(
+        context.range.minSequence,
+        context.backend->fetchTransactionHistoryStart(context.yield)
+            .value_or(context.range.minSequence));
+    auto minIndex = historyMin;
     auto maxIndex = context.range.maxSequence;
     std::optional<int64_t> min;
     std::optional<int64_t> max;
@@ -1629,8 +1627,7 @@ traverseTransactions(
 
         if (*min != -1)
         {
-            if (context.range.maxSequence < *min ||
-                context.range.minSequence > *min)
+            if (context.range.maxSequence < *min || historyMin > *min)
                 return Status{
                     RippledError::rpcLGR_IDX_MALFORMED,
                     "ledgerSeqMinOutOfRange"};
@@ -1654,8 +1651,7 @@ traverseTransactions(
 
         if (*max != -1)
         {
-            if (context.range.maxSequence < *max ||
-                context.range.minSequence > *max)
+            if (context.range.maxSequence < *max || historyMin > *max)
                 return Status{RippledError::rpcLGR_IDXS_INVALID};
             else
                 maxIndex = static_cast<uint32_t>(*max);
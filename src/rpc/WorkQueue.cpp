@@ -19,12 +19,175 @@
 
 #include <rpc/WorkQueue.h>
 
+#include <algorithm>
+#include <bit>
+#include <string>
+
+namespace {
+
+char const*
+laneName(std::size_t lane)
+{
+    static constexpr char const* names[] = {"priority", "lookup", "scan"};
+    return names[lane];
+}
+
+}  // namespace
+
+void
+WorkQueue::WaitHistogram::record(std::uint64_t waitUs)
+{
+    auto const bucket = std::min<std::size_t>(
+        std::bit_width(waitUs / firstBucketUs), numBuckets - 1);
+    ++buckets_[bucket];
+}
+
+boost::json::object
+WorkQueue::WaitHistogram::toJson() const
+{
+    boost::json::object distribution;
+    for (std::size_t i = 0; i < numBuckets; ++i)
+    {
+        std::string label;
+        if (i == 0)
+        {
+            label = "<" + std::to_string(firstBucketUs);
+        }
+        else
+        {
+            auto const low = firstBucketUs << (i - 1);
+            label = std::to_string(low);
+            if (i == numBuckets - 1)
+                label += "+";
+            else
+                label += "-" + std::to_string(2 * low - 1);
+        }
+        distribution[label] = buckets_[i].load();
+    }
+    return distribution;
+}
+
 WorkQueue::WorkQueue(std::uint32_t numWorkers, uint32_t maxSize)
 {
     if (maxSize != 0)
         maxSize_ = maxSize;
-    while (--numWorkers)
+
+    // One thread for the priority lane, a quarter of the rest for scans and
+    // the others for lookups. Every lane needs at least one thread
+    auto const numThreads = std::max<std::uint32_t>(numWorkers, numLanes);
+    auto const numScan = std::max<std::uint32_t>((numThreads - 1) / 4, 1);
+    numLookup_ = numThreads - 1 - numScan;
+
+    threads_.emplace_back([this] { work(Lane::priority); });
+    for (std::uint32_t i = 0; i < numLookup_; ++i)
+        threads_.emplace_back([this] { work(Lane::lookup); });
+    for (std::uint32_t i = 0; i < numScan; ++i)
+        threads_.emplace_back([this] { work(Lane::scan); });
+}
+
+WorkQueue::~WorkQueue()
+{
+    for (auto& lane : lanes_)
+    {
+        lane.work.reset();
+        lane.ioc.stop();
+    }
+    for (auto& thread : threads_)
+        thread.join();
+}
+
+void
+WorkQueue::work(Lane lane)
+{
+    auto& own = lanes_[static_cast<std::size_t>(lane)];
+    while (!own.ioc.stopped())
+    {
+        if (own.ioc.poll_one() != 0 || steal(lane))
+            continue;
+
+        // Idle from here on, so that jobs queued in the other lanes wake
+        // this thread up with an empty handler. Those queued before are
+        // looked for once more
+        ++own.idle;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!steal(lane))
+            own.ioc.run_one();
+        --own.idle;
+    }
+}
+
+bool
+WorkQueue::steal(Lane lane)
+{
+    if (lane == Lane::priority)
+        return false;
+
+    for (std::size_t i = 0; i < numLanes; ++i)
+    {
+        auto const other = static_cast<Lane>(i);
+        if (other == lane)
+            continue;
+
+        if (lane == Lane::lookup && other == Lane::scan)
+        {
+            // a lookup never waits for every lookup thread to finish a scan
+            if (++lookupsOnScans_ >= numLookup_)
+            {
+                --lookupsOnScans_;
+                continue;
+            }
+            auto const ran = lanes_[i].ioc.poll_one() != 0;
+            --lookupsOnScans_;
+            if (ran)
+                return true;
+        }
+        else if (lanes_[i].ioc.poll_one() != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+WorkQueue::wake(Lane lane)
+{
+    auto const index = static_cast<std::size_t>(lane);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lanes_[index].idle != 0)
+        return;
+
+    // the priority thread never steals
+    for (std::size_t i = 1; i < numLanes; ++i)
+    {
+        if (i != index && lanes_[i].idle != 0)
+        {
+            boost::asio::post(lanes_[i].ioc, [] {});
+            return;
+        }
+    }
+}
+
+boost::json::object
+WorkQueue::report() const
+{
+    boost::json::object obj;
+    obj["queued"] = queued_;
+    obj["queued_duration_us"] = durationUs_;
+    obj["current_queue_size"] = curSize_;
+    obj["max_queue_size"] = maxSize_;
+
+    boost::json::object lanes;
+    for (std::size_t i = 0; i < numLanes; ++i)
     {
-        threads_.emplace_back([this] { ioc_.run(); });
+        auto const& state = lanes_[i];
+        boost::json::object lane;
+        lane["queued"] = state.queued.load();
+        lane["queued_duration_us"] = state.durationUs.load();
+        lane["current_queue_size"] = state.curSize.load();
+        lane["wait_us"] = state.waits.toJson();
+        lanes[laneName(i)] = std::move(lane);
     }
+    obj["lanes"] = std::move(lanes);
+    return obj;
 }
@@ -25,14 +25,66 @@
 #include <boost/asio/spawn.hpp>
 #include <boost/json.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <queue>
 #include <shared_mutex>
 #include <thread>
+#include <vector>
 
 class WorkQueue
 {
+public:
+    /// Jobs are queued in lanes by how expensive they are expected to be, so
+    /// that cheap requests never wait behind expensive ones. Every lane has
+    /// its own io_context and threads. An idle lookup or scan thread steals
+    /// jobs from the other lanes, except that one lookup thread never runs
+    /// scans. The priority thread only runs its own lane.
+    enum class Lane : std::size_t {
+        // whitelisted clients
+        priority = 0,
+        // requests reading a bounded number of objects
+        lookup,
+        // requests walking the state map, an order book or a history
+        scan,
+    };
+
+    static constexpr std::size_t numLanes = 3;
+
+private:
+    // Power of two buckets of the time jobs waited in their lane, from
+    // below 64us to 1s and more
+    class WaitHistogram
+    {
+        static constexpr std::size_t numBuckets = 16;
+        static constexpr std::uint64_t firstBucketUs = 64;
+
+        std::array<std::atomic_uint64_t, numBuckets> buckets_ = {};
+
+    public:
+        void
+        record(std::uint64_t waitUs);
+
+        boost::json::object
+        toJson() const;
+    };
+
+    struct LaneState
+    {
+        boost::asio::io_context ioc;
+        std::optional<boost::asio::io_context::work> work{ioc};
+        std::atomic_uint64_t queued = 0;
+        std::atomic_uint64_t durationUs = 0;
+        std::atomic_uint64_t curSize = 0;
+        // threads of the lane blocked waiting for a job
+        std::atomic_uint32_t idle = 0;
+        WaitHistogram waits;
+    };
+
     // these are cumulative for the lifetime of the process
     std::atomic_uint64_t queued_ = 0;
     std::atomic_uint64_t durationUs_ = 0;
@@ -41,12 +93,20 @@ class WorkQueue
     uint32_t maxSize_ = std::numeric_limits<uint32_t>::max();
     clio::Logger log_{"RPC"};
 
+    std::uint32_t numLookup_ = 0;
+    // lookup threads running a job of the scan lane
+    std::atomic_uint32_t lookupsOnScans_ = 0;
+
 public:
     WorkQueue(std::uint32_t numWorkers, uint32_t maxSize = 0);
 
+    ~WorkQueue();
+
+    /// Spawn a coroutine running f in the given lane. Jobs of whitelisted
+    /// clients always run in the priority lane and are never rejected
     template <typename F>
     bool
-    postCoro(F&& f, bool isWhiteListed)
+    postCoro(F&& f, bool isWhiteListed, Lane lane = Lane::lookup)
     {
         if (curSize_ >= maxSize_ && !isWhiteListed)
         {
@@ -54,13 +114,41 @@ public:
                         << curSize_ << " max size = " << maxSize_;
             return false;
         }
+        if (isWhiteListed)
+            lane = Lane::priority;
+
+        spawnCoro(std::forward<F>(f), lane);
+        return true;
+    }
+
+    /// Spawn a coroutine running f in the given lane, for a job admitted by
+    /// postCoro that turned out to belong to another lane once it ran. Never
+    /// rejected
+    template <typename F>
+    void
+    repostCoro(F&& f, Lane lane)
+    {
+        spawnCoro(std::forward<F>(f), lane);
+    }
+
+    boost::json::object
+    report() const;
+
+private:
+    template <typename F>
+    void
+    spawnCoro(F&& f, Lane lane)
+    {
+        auto& state = lanes_[static_cast<std::size_t>(lane)];
         ++curSize_;
+        ++state.curSize;
         auto start = std::chrono::system_clock::now();
         // Each time we enqueue a job, we want to post a symmetrical job that
         // will dequeue and run the job at the front of the job queue.
         boost::asio::spawn(
-            ioc_,
-            [this, f = std::move(f), start](boost::asio::yield_context yield) {
+            state.ioc,
+            [this, &state, f = std::move(f), start](
+                boost::asio::yield_context yield) {
                 auto run = std::chrono::system_clock::now();
                 auto wait =
                     std::chrono::duration_cast<std::chrono::microseconds>(
@@ -70,28 +158,32 @@ public:
                 // durationUs_
                 ++queued_;
                 durationUs_ += wait;
+                ++state.queued;
+                state.durationUs += wait;
+                state.waits.record(wait > 0 ? wait : 0);
                 log_.info() << "WorkQueue wait time = " << wait
                             << " queue size = " << curSize_;
                 f(yield);
+                --state.curSize;
                 --curSize_;
             });
-        return true;
+        wake(lane);
     }
 
-    boost::json::object
-    report() const
-    {
-        boost::json::object obj;
-        obj["queued"] = queued_;
-        obj["queued_duration_us"] = durationUs_;
-        obj["current_queue_size"] = curSize_;
-        obj["max_queue_size"] = maxSize_;
-        return obj;
-    }
+    // Run jobs of the given lane, stealing from the other lanes when the own
+    // one is idle. Blocks on the own lane when there is nothing to run
+    void
+    work(Lane lane);
 
-private:
-    std::vector<std::thread> threads_ = {};
+    // Run one job of the lanes the given lane steals from, if any is queued
+    bool
+    steal(Lane lane);
 
-    boost::asio::io_context ioc_ = {};
-    std::optional<boost::asio::io_context::work> work_{ioc_};
+    // Wake up a thread that steals from the given lane, if the lane has no
+    // idle thread of its own to run the job just queued
+    void
+    wake(Lane lane);
+
+    std::array<LaneState, numLanes> lanes_;
+    std::vector<std::thread> threads_ = {};
 };
@@ -68,6 +68,8 @@ doServerInfo(Context const& context)
         info[JS(counters)] = context.counters.report();
         info[JS(counters)].as_object()["subscriptions"] =
             context.subscriptions->report();
+        info[JS(counters)].as_object()["subscription_publishes"] =
+            context.subscriptions->publishReport();
     }
 
     auto serverInfoRippled = context.balancer->forwardToRippled(
@@ -114,6 +116,12 @@ doServerInfo(Context const& context)
     if (admin)
     {
         info["etl"] = context.etl->getInfo();
+
+        auto const& coalescer = context.backend->coalescer();
+        info["backend"] = boost::json::object{
+            {"coalesced_reads", coalescer.numCoalesced()},
+            {"batched_reads", coalescer.numBatched()},
+            {"write_batches", context.backend->writeBatches().toJson()}};
     }
 
     return response;
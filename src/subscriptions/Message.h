@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <boost/asio/buffer.hpp>
+
 #include <string>
 
 // This class should only be constructed once, then it can
@@ -42,15 +44,22 @@ public:
 
     ~Message() = default;
 
-    char*
-    data()
+    char const*
+    data() const
     {
         return message_.data();
     }
 
     std::size_t
-    size()
+    size() const
     {
         return message_.size();
     }
+
+    // The payload, written as is to every subscriber
+    boost::asio::const_buffer
+    buffer() const
+    {
+        return boost::asio::buffer(message_);
+    }
 };
@@ -21,6 +21,29 @@
 #include <subscriptions/SubscriptionManager.h>
 #include <webserver/WsBase.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+SendQueueLimits
+SendQueueLimits::make(clio::Config const& config)
+{
+    SendQueueLimits limits;
+    limits.maxMessages = config.valueOr<std::size_t>(
+        "subscription_send_queue.max_messages", limits.maxMessages);
+    limits.maxBytes = config.valueOr<std::size_t>(
+        "subscription_send_queue.max_bytes", limits.maxBytes);
+    if (auto policy = config.valueOr<std::string>(
+            "subscription_send_queue.policy", "disconnect");
+        policy == "drop")
+        limits.policy = Policy::drop;
+    else if (policy != "disconnect")
+        throw std::runtime_error("Invalid send queue policy: " + policy);
+    return limits;
+}
+
 void
 Subscription::subscribe(std::shared_ptr<WsBase> const& session)
 {
@@ -186,12 +209,118 @@ SubscriptionManager::pubLedger(
     ledgerSubscribers_.publish(message);
 }
 
-void
-SubscriptionManager::pubTransaction(
+SubscriptionManager::OwnerFunds
+SubscriptionManager::fetchOwnerFunds(
+    std::vector<Backend::TransactionAndMetadata> const& transactions,
+    std::uint32_t const seq)
+{
+    OwnerFunds ownerFunds;
+    for (auto const& blobs : transactions)
+    {
+        ripple::SerialIter it{
+            blobs.transaction.data(), blobs.transaction.size()};
+        ripple::STTx const tx{it};
+        if (tx.getTxnType() != ripple::ttOFFER_CREATE)
+            continue;
+
+        auto const account = tx.getAccountID(ripple::sfAccount);
+        auto const issue = tx.getFieldAmount(ripple::sfTakerGets).issue();
+        if (account != issue.account)
+            ownerFunds.emplace(
+                std::make_tuple(account, issue.currency, issue.account),
+                ripple::STAmount{});
+    }
+
+    if (ownerFunds.empty())
+        return ownerFunds;
+
+    Backend::retryOnTimeout([&]() {
+        Backend::synchronous([&](boost::asio::yield_context& yield) {
+            for (auto& entry : ownerFunds)
+            {
+                boost::asio::spawn(
+                    yield,
+                    [this, &entry, seq](boost::asio::yield_context yield) {
+                        auto const& [account, currency, issuer] = entry.first;
+                        entry.second = RPC::accountHolds(
+                            *backend_,
+                            seq,
+                            account,
+                            currency,
+                            issuer,
+                            true,
+                            yield);
+                    });
+            }
+        });
+    });
+
+    return ownerFunds;
+}
+
+SubscriptionManager::TransactionMessage
+SubscriptionManager::formatTransaction(
     Backend::TransactionAndMetadata const& blobs,
-    ripple::LedgerInfo const& lgrInfo)
+    ripple::LedgerInfo const& lgrInfo,
+    OwnerFunds const& ownerFunds,
+    bool skipUninterested) const
 {
     auto [tx, meta] = RPC::deserializeTxPlusMeta(blobs, lgrInfo.seq);
+
+    TransactionMessage formatted;
+    formatted.index = meta->getIndex();
+    formatted.accounts = meta->getAffectedAccounts();
+
+    std::unordered_set<ripple::Book> alreadySent;
+
+    for (auto const& node : meta->getNodes())
+    {
+        if (node.getFieldU16(ripple::sfLedgerEntryType) == ripple::ltOFFER)
+        {
+            ripple::SField const* field = nullptr;
+
+            // We need a field that contains the TakerGets and TakerPays
+            // parameters.
+            if (node.getFName() == ripple::sfModifiedNode)
+                field = &ripple::sfPreviousFields;
+            else if (node.getFName() == ripple::sfCreatedNode)
+                field = &ripple::sfNewFields;
+            else if (node.getFName() == ripple::sfDeletedNode)
+                field = &ripple::sfFinalFields;
+
+            if (field)
+            {
+                auto data = dynamic_cast<const ripple::STObject*>(
+                    node.peekAtPField(*field));
+
+                if (data && data->isFieldPresent(ripple::sfTakerPays) &&
+                    data->isFieldPresent(ripple::sfTakerGets))
+                {
+                    // determine the OrderBook
+                    ripple::Book book{
+                        data->getFieldAmount(ripple::sfTakerGets).issue(),
+                        data->getFieldAmount(ripple::sfTakerPays).issue()};
+                    if (alreadySent.insert(book).second)
+                        formatted.books.push_back(book);
+                }
+            }
+        }
+    }
+
+    auto const interested = !skipUninterested || !txSubscribers_.empty() ||
+        std::any_of(formatted.accounts.begin(),
+                    formatted.accounts.end(),
+                    [this](auto const& account) {
+                        return accountSubscribers_.interested(account);
+                    }) ||
+        std::any_of(formatted.books.begin(),
+                    formatted.books.end(),
+                    [this](auto const& book) {
+                        return bookSubscribers_.interested(book);
+                    });
+    if (!interested)
+        return formatted;
+
     boost::json::object pubObj;
     pubObj["transaction"] = RPC::toJson(*tx);
     pubObj["meta"] = RPC::toJson(*meta);
@@ -218,67 +347,127 @@ SubscriptionManager::pubTransaction(
         auto amount = tx->getFieldAmount(ripple::sfTakerGets);
         if (account != amount.issue().account)
         {
-            ripple::STAmount ownerFunds;
-            auto fetchFundsSynchronous = [&]() {
-                Backend::synchronous([&](boost::asio::yield_context& yield) {
-                    ownerFunds = RPC::accountFunds(
-                        *backend_, lgrInfo.seq, amount, account, yield);
-                });
-            };
-
-            Backend::retryOnTimeout(fetchFundsSynchronous);
-
-            pubObj["transaction"].as_object()["owner_funds"] =
-                ownerFunds.getText();
+            ripple::STAmount funds;
+            if (auto it = ownerFunds.find(std::make_tuple(
+                    account, amount.getCurrency(), amount.getIssuer()));
+                it != ownerFunds.end())
+            {
+                funds = it->second;
+            }
+            else
+            {
+                auto fetchFundsSynchronous = [&]() {
+                    Backend::synchronous(
+                        [&](boost::asio::yield_context& yield) {
+                            funds = RPC::accountFunds(
+                                *backend_, lgrInfo.seq, amount, account, yield);
+                        });
+                };
+
+                Backend::retryOnTimeout(fetchFundsSynchronous);
+            }
+
+            pubObj["transaction"].as_object()["owner_funds"] = funds.getText();
         }
     }
 
-    auto pubMsg = std::make_shared<Message>(boost::json::serialize(pubObj));
-    txSubscribers_.publish(pubMsg);
+    formatted.message =
+        std::make_shared<Message>(boost::json::serialize(pubObj));
+    return formatted;
+}
 
-    auto accounts = meta->getAffectedAccounts();
+void
+SubscriptionManager::publishTransaction(TransactionMessage const& formatted)
+{
+    if (!formatted.message)
+    {
+        accountSubscribers_.skipped(formatted.accounts.size());
+        bookSubscribers_.skipped(formatted.books.size());
+        return;
+    }
 
-    for (auto const& account : accounts)
-        accountSubscribers_.publish(pubMsg, account);
+    txSubscribers_.publish(formatted.message);
 
-    std::unordered_set<ripple::Book> alreadySent;
+    for (auto const& account : formatted.accounts)
+        accountSubscribers_.publish(formatted.message, account);
 
-    for (auto const& node : meta->getNodes())
-    {
-        if (node.getFieldU16(ripple::sfLedgerEntryType) == ripple::ltOFFER)
-        {
-            ripple::SField const* field = nullptr;
+    for (auto const& book : formatted.books)
+        bookSubscribers_.publish(formatted.message, book);
+}
 
-            // We need a field that contains the TakerGets and TakerPays
-            // parameters.
-            if (node.getFName() == ripple::sfModifiedNode)
-                field = &ripple::sfPreviousFields;
-            else if (node.getFName() == ripple::sfCreatedNode)
-                field = &ripple::sfNewFields;
-            else if (node.getFName() == ripple::sfDeletedNode)
-                field = &ripple::sfFinalFields;
+void
+SubscriptionManager::pubTransaction(
+    Backend::TransactionAndMetadata const& blobs,
+    ripple::LedgerInfo const& lgrInfo,
+    OwnerFunds const& ownerFunds)
+{
+    publishTransaction(formatTransaction(blobs, lgrInfo, ownerFunds, false));
+}
 
-            if (field)
+void
+SubscriptionManager::pubLedgerTransactions(
+    ripple::LedgerInfo const& lgrInfo,
+    std::vector<Backend::TransactionAndMetadata> const& transactions)
+{
+    if (!txSubscribers_.empty() || !accountSubscribers_.empty() ||
+        !bookSubscribers_.empty())
+    {
+        auto const ownerFunds = fetchOwnerFunds(transactions, lgrInfo.seq);
+
+        // Transactions are claimed one at a time by this thread and by up to
+        // one helper per subscription worker
+        std::vector<TransactionMessage> formatted(transactions.size());
+        std::atomic_size_t next = 0;
+        std::exception_ptr error;
+        std::mutex mtx;
+        std::condition_variable cv;
+        auto format = [&]() {
+            try
             {
-                auto data = dynamic_cast<const ripple::STObject*>(
-                    node.peekAtPField(*field));
-
-                if (data && data->isFieldPresent(ripple::sfTakerPays) &&
-                    data->isFieldPresent(ripple::sfTakerGets))
-                {
-                    // determine the OrderBook
-                    ripple::Book book{
-                        data->getFieldAmount(ripple::sfTakerGets).issue(),
-                        data->getFieldAmount(ripple::sfTakerPays).issue()};
-                    if (alreadySent.find(book) == alreadySent.end())
-                    {
-                        bookSubscribers_.publish(pubMsg, book);
-                        alreadySent.insert(book);
-                    }
-                }
+                for (auto i = next++; i < transactions.size(); i = next++)
+                    formatted[i] = formatTransaction(
+                        transactions[i], lgrInfo, ownerFunds, true);
             }
+            catch (...)
+            {
+                next = transactions.size();
+                std::lock_guard lck(mtx);
+                if (!error)
+                    error = std::current_exception();
+            }
+        };
+
+        auto running = std::min(
+            workers_.size(),
+            transactions.empty() ? 0 : transactions.size() - 1);
+        for (auto i = running; i > 0; --i)
+        {
+            boost::asio::post(ioc_, [&]() {
+                format();
+                std::lock_guard lck(mtx);
+                if (--running == 0)
+                    cv.notify_one();
+            });
         }
+
+        format();
+        std::unique_lock lck(mtx);
+        cv.wait(lck, [&]() { return running == 0; });
+        if (error)
+            std::rethrow_exception(error);
+
+        std::sort(
+            formatted.begin(),
+            formatted.end(),
+            [](auto const& lhs, auto const& rhs) {
+                return lhs.index < rhs.index;
+            });
+        for (auto const& txn : formatted)
+            publishTransaction(txn);
     }
+
+    if (!bookChangesSubscribers_.empty())
+        pubBookChanges(lgrInfo, transactions);
 }
 
 void
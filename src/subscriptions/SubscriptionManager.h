@@ -24,10 +24,38 @@
 #include <log/Logger.h>
 #include <subscriptions/Message.h>
 
+#include <ripple/protocol/STAmount.h>
+
+#include <map>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_set>
 
 class WsBase;
 
+/**
+ * @brief Caps on the messages a websocket session holds while its client is
+ * slow to read them.
+ *
+ * Only published stream messages are subject to the caps; responses to the
+ * client's own requests are always queued.
+ */
+struct SendQueueLimits
+{
+    enum class Policy { drop, disconnect };
+
+    // 0 disables the corresponding cap
+    std::size_t maxMessages = 10000;
+    std::size_t maxBytes = 64 * 1024 * 1024;
+    // what happens to a session whose queue is full: drop the message being
+    // published, or close the connection so the client knows it missed data
+    Policy policy = Policy::disconnect;
+
+    static SendQueueLimits
+    make(clio::Config const& config);
+};
+
 class Subscription
 {
     boost::asio::io_context::strand strand_;
@@ -67,6 +95,55 @@ public:
     }
 };
 
+/**
+ * @brief Keys with at least one subscriber, readable without taking a lock.
+ *
+ * A published set is never modified. Writers, which are rare, copy it, change
+ * the copy and swap it in, so publishers can check for interest before doing
+ * any work for a key.
+ */
+template <class Key>
+class InterestSet
+{
+    using Set = std::unordered_set<Key>;
+
+    std::shared_ptr<Set const> keys_ = std::make_shared<Set const>();
+    std::mutex writeMtx_;
+
+public:
+    bool
+    contains(Key const& key) const
+    {
+        return std::atomic_load(&keys_)->contains(key);
+    }
+
+    void
+    add(Key const& key)
+    {
+        std::lock_guard lck(writeMtx_);
+        auto const current = std::atomic_load(&keys_);
+        if (current->contains(key))
+            return;
+
+        auto next = std::make_shared<Set>(*current);
+        next->insert(key);
+        std::atomic_store(&keys_, std::shared_ptr<Set const>(std::move(next)));
+    }
+
+    void
+    remove(Key const& key)
+    {
+        std::lock_guard lck(writeMtx_);
+        auto const current = std::atomic_load(&keys_);
+        if (!current->contains(key))
+            return;
+
+        auto next = std::make_shared<Set>(*current);
+        next->erase(key);
+        std::atomic_store(&keys_, std::shared_ptr<Set const>(std::move(next)));
+    }
+};
+
 template <class Key>
 class SubscriptionMap
 {
@@ -76,6 +153,14 @@ class SubscriptionMap
     boost::asio::io_context::strand strand_;
     std::unordered_map<Key, subscribers> subscribers_ = {};
     std::atomic_uint64_t subCount_ = 0;
+    // Keys are added before the subscription is posted to the strand, so a
+    // publish right after subscribing is not filtered out, and removed on the
+    // strand once their last subscriber is gone
+    InterestSet<Key> interest_;
+    // publishes posted to the strand, and publishes skipped because no one
+    // was subscribed to the key
+    std::atomic_uint64_t matched_ = 0;
+    std::atomic_uint64_t unmatched_ = 0;
 
 public:
     SubscriptionMap() = delete;
@@ -98,10 +183,37 @@ public:
     publish(std::shared_ptr<Message> const& message, Key const& key);
 
     std::uint64_t
-    count()
+    count() const
     {
         return subCount_.load();
     }
+
+    bool
+    empty() const
+    {
+        return count() == 0;
+    }
+
+    /// Whether a publish for the key would reach anyone
+    bool
+    interested(Key const& key) const
+    {
+        return interest_.contains(key);
+    }
+
+    /// Count publishes for keys that were dropped before publishing because
+    /// no one was interested in them
+    void
+    skipped(std::size_t count)
+    {
+        unmatched_ += count;
+    }
+
+    boost::json::object
+    publishReport() const
+    {
+        return {{"matched", matched_.load()}, {"unmatched", unmatched_.load()}};
+    }
 };
 
 template <class T>
@@ -161,7 +273,11 @@ SubscriptionMap<Key>::subscribe(
     std::shared_ptr<WsBase> const& session,
     Key const& account)
 {
+    interest_.add(account);
     boost::asio::post(strand_, [this, session, account]() {
+        // the key may have been dropped from the interest set by an
+        // unsubscribe that ran after it was added above
+        interest_.add(account);
         addSession(session, subscribers_[account], subCount_);
     });
 }
@@ -186,6 +302,7 @@ SubscriptionMap<Key>::unsubscribe(
         if (subscribers_[account].size() == 0)
         {
             subscribers_.erase(account);
+            interest_.remove(account);
         }
     });
 }
@@ -196,11 +313,24 @@ SubscriptionMap<Key>::publish(
     std::shared_ptr<Message> const& message,
     Key const& account)
 {
+    if (!interest_.contains(account))
+    {
+        ++unmatched_;
+        return;
+    }
+
+    ++matched_;
     boost::asio::post(strand_, [this, account, message]() {
-        if (!subscribers_.contains(account))
+        auto it = subscribers_.find(account);
+        if (it == subscribers_.end())
             return;
 
-        sendToSubscribers(message, subscribers_[account], subCount_);
+        sendToSubscribers(message, it->second, subCount_);
+        if (it->second.empty())
+        {
+            subscribers_.erase(it);
+            interest_.remove(account);
+        }
     });
 }
 
@@ -225,6 +355,7 @@ class SubscriptionManager
     SubscriptionMap<ripple::Book> bookSubscribers_;
 
     std::shared_ptr<Backend::BackendInterface const> backend_;
+    SendQueueLimits const sendQueueLimits_;
 
 public:
     static std::shared_ptr<SubscriptionManager>
@@ -233,12 +364,14 @@ public:
         std::shared_ptr<Backend::BackendInterface const> const& b)
     {
         auto numThreads = config.valueOr<uint64_t>("subscription_workers", 1);
-        return std::make_shared<SubscriptionManager>(numThreads, b);
+        return std::make_shared<SubscriptionManager>(
+            numThreads, b, SendQueueLimits::make(config));
     }
 
     SubscriptionManager(
         std::uint64_t numThreads,
-        std::shared_ptr<Backend::BackendInterface const> const& b)
+        std::shared_ptr<Backend::BackendInterface const> const& b,
+        SendQueueLimits sendQueueLimits = {})
         : ledgerSubscribers_(ioc_)
         , txSubscribers_(ioc_)
         , txProposedSubscribers_(ioc_)
@@ -249,6 +382,7 @@ public:
         , accountProposedSubscribers_(ioc_)
         , bookSubscribers_(ioc_)
         , backend_(b)
+        , sendQueueLimits_(sendQueueLimits)
     {
         work_.emplace(ioc_);
 
@@ -272,6 +406,12 @@ public:
             worker.join();
     }
 
+    SendQueueLimits const&
+    sendQueueLimits() const
+    {
+        return sendQueueLimits_;
+    }
+
     boost::json::object
     subLedger(boost::asio::yield_context& yield, session_ptr session);
 
@@ -296,10 +436,45 @@ public:
     void
     unsubTransactions(session_ptr session);
 
+    // Funds of the owners of offers created in a ledger, keyed by (account,
+    // currency, issuer) of the TakerGets amount
+    using OwnerFunds = std::map<
+        std::tuple<ripple::AccountID, ripple::Currency, ripple::AccountID>,
+        ripple::STAmount>;
+
+    /**
+     * @brief Read the owner_funds of every OfferCreate in a ledger.
+     *
+     * The funds of each distinct owner and asset are read once, and all of
+     * them concurrently, so that publishing the ledger's transactions does
+     * not wait on the database once per offer.
+     */
+    OwnerFunds
+    fetchOwnerFunds(
+        std::vector<Backend::TransactionAndMetadata> const& transactions,
+        std::uint32_t seq);
+
+    /**
+     * @brief Publish a transaction. owner_funds of an OfferCreate is taken
+     * from ownerFunds, and only read from the database when missing there.
+     */
     void
     pubTransaction(
         Backend::TransactionAndMetadata const& blobs,
-        ripple::LedgerInfo const& lgrInfo);
+        ripple::LedgerInfo const& lgrInfo,
+        OwnerFunds const& ownerFunds = {});
+
+    /**
+     * @brief Publish the transactions of a ledger and its book changes.
+     *
+     * Transactions are converted to JSON concurrently on the subscription
+     * workers and published in transaction index order. Nothing is built for
+     * streams without subscribers.
+     */
+    void
+    pubLedgerTransactions(
+        ripple::LedgerInfo const& lgrInfo,
+        std::vector<Backend::TransactionAndMetadata> const& transactions);
 
     void
     subAccount(ripple::AccountID const& account, session_ptr& session);
@@ -355,6 +530,16 @@ public:
     void
     cleanup(session_ptr session);
 
+    /// Account and book publishes that reached the strand or were skipped
+    boost::json::object
+    publishReport() const
+    {
+        return {
+            {"account", accountSubscribers_.publishReport()},
+            {"accounts_proposed", accountProposedSubscribers_.publishReport()},
+            {"books", bookSubscribers_.publishReport()}};
+    }
+
     boost::json::object
     report()
     {
@@ -374,6 +559,28 @@ public:
     }
 
 private:
+    // A transaction rendered for publishing and the streams it goes to.
+    // message is null when no one was interested in the transaction
+    struct TransactionMessage
+    {
+        std::uint32_t index = 0;
+        std::shared_ptr<Message> message;
+        boost::container::flat_set<ripple::AccountID> accounts;
+        std::vector<ripple::Book> books;
+    };
+
+    // With skipUninterested, no message is built when neither the
+    // transactions stream nor any affected account or book has subscribers
+    TransactionMessage
+    formatTransaction(
+        Backend::TransactionAndMetadata const& blobs,
+        ripple::LedgerInfo const& lgrInfo,
+        OwnerFunds const& ownerFunds,
+        bool skipUninterested) const;
+
+    void
+    publishTransaction(TransactionMessage const& formatted);
+
     void
     sendAll(std::string const& pubMsg, std::unordered_set<session_ptr>& subs);
 
@@ -22,7 +22,14 @@
 #include <boost/asio.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -43,11 +50,33 @@ public:
 /**
  * @brief A simple denial of service guard used for rate limiting.
  *
+ * Clients are keyed by their binary address and spread over shards, each
+ * with its own lock, so concurrent requests from different clients rarely
+ * contend.
+ *
  * @tparam SweepHandler Type of the sweep handler
  */
 template <typename SweepHandler>
 class BasicDOSGuard : public BaseDOSGuard
 {
+    // Binary form of a client address, IPv4 addresses mapped into IPv6
+    using IpKey = boost::asio::ip::address_v6::bytes_type;
+
+    struct IpKeyHash
+    {
+        std::size_t
+        operator()(IpKey const& key) const noexcept
+        {
+            std::uint64_t high;
+            std::uint64_t low;
+            std::memcpy(&high, key.data(), sizeof(high));
+            std::memcpy(&low, key.data() + sizeof(high), sizeof(low));
+            auto const hash = (high ^ (low * 0x9e3779b97f4a7c15ull)) *
+                0xff51afd7ed558ccdull;
+            return hash ^ (hash >> 32);
+        }
+    };
+
     // Accumulated state per IP, state will be reset accordingly
     struct ClientState
     {
@@ -57,15 +86,38 @@ class BasicDOSGuard : public BaseDOSGuard
         std::uint32_t requestsCount = 0;
     };
 
-    mutable std::mutex mtx_;
-    // accumulated states map
-    std::unordered_map<std::string, ClientState> ipState_;
-    std::unordered_map<std::string, std::uint32_t> ipConnCount_;
-    std::unordered_set<std::string> const whitelist_;
+    // Token bucket charged with the measured cost of the requests of an IP.
+    // It refills continuously and can go into debt, so one expensive request
+    // blocks its client until the cost is paid back
+    struct CostBucket
+    {
+        double tokens;
+        std::chrono::steady_clock::time_point updated;
+    };
+
+    struct Shard
+    {
+        std::mutex mtx;
+        // accumulated states map
+        std::unordered_map<IpKey, ClientState, IpKeyHash> ipState;
+        std::unordered_map<IpKey, std::uint32_t, IpKeyHash> ipConnCount;
+        // buckets that are not full, the others are not kept
+        std::unordered_map<IpKey, CostBucket, IpKeyHash> ipCost;
+    };
+
+    static constexpr std::size_t numShards = 64;
+
+    mutable std::array<Shard, numShards> shards_;
+    std::unordered_set<IpKey, IpKeyHash> const whitelist_;
 
     std::uint32_t const maxFetches_;
     std::uint32_t const maxConnCount_;
     std::uint32_t const maxRequestCount_;
+    // size of the cost bucket of each IP, 0 disables cost accounting
+    double const maxCost_;
+    double const costPerSecond_;
+    // requests of a JSON-RPC batch that count as one against maxRequestCount_
+    std::uint32_t const batchRequestsPerCharge_;
     clio::Logger log_{"RPC"};
 
 public:
@@ -80,10 +132,33 @@ public:
         , maxFetches_{config.valueOr("dos_guard.max_fetches", 1000000u)}
         , maxConnCount_{config.valueOr("dos_guard.max_connections", 20u)}
         , maxRequestCount_{config.valueOr("dos_guard.max_requests", 20u)}
+        , maxCost_{config.valueOr("dos_guard.max_cost", 0.0)}
+        , costPerSecond_{config.valueOr("dos_guard.cost_per_second", maxCost_)}
+        , batchRequestsPerCharge_{
+              config.valueOr("dos_guard.batch_requests_per_charge", 1u)}
     {
+        // a client in debt would never be let back in
+        if (maxCost_ > 0 && costPerSecond_ <= 0)
+            throw std::runtime_error(
+                "dos_guard.cost_per_second must be positive when "
+                "dos_guard.max_cost is set");
+        if (batchRequestsPerCharge_ == 0)
+            throw std::runtime_error(
+                "dos_guard.batch_requests_per_charge must be positive");
+
         sweepHandler.setup(this);
     }
 
+    /**
+     * @brief Number of the requests of a JSON-RPC batch that count as one
+     * request against the request limit. 1 unless configured otherwise
+     */
+    [[nodiscard]] std::uint32_t
+    batchRequestsPerCharge() const noexcept
+    {
+        return batchRequestsPerCharge_;
+    }
+
     /**
      * @brief Check whether an ip address is in the whitelist or not
      *
@@ -94,7 +169,7 @@ public:
     [[nodiscard]] bool
     isWhiteListed(std::string const& ip) const noexcept
     {
-        return whitelist_.contains(ip);
+        return isWhiteListed(toKey(ip));
     }
 
     /**
@@ -107,36 +182,13 @@ public:
     [[nodiscard]] bool
     isOk(std::string const& ip) const noexcept
     {
-        if (whitelist_.contains(ip))
+        auto const key = toKey(ip);
+        if (isWhiteListed(key))
             return true;
 
-        {
-            std::scoped_lock lck(mtx_);
-            if (ipState_.find(ip) != ipState_.end())
-            {
-                auto [transferedByte, requests] = ipState_.at(ip);
-                if (transferedByte > maxFetches_ || requests > maxRequestCount_)
-                {
-                    log_.warn()
-                        << "Dosguard:Client surpassed the rate limit. ip = "
-                        << ip << " Transfered Byte:" << transferedByte
-                        << " Requests:" << requests;
-                    return false;
-                }
-            }
-            auto it = ipConnCount_.find(ip);
-            if (it != ipConnCount_.end())
-            {
-                if (it->second > maxConnCount_)
-                {
-                    log_.warn()
-                        << "Dosguard:Client surpassed the rate limit. ip = "
-                        << ip << " Concurrent connection:" << it->second;
-                    return false;
-                }
-            }
-        }
-        return true;
+        auto& shard = shardFor(key);
+        std::scoped_lock lck(shard.mtx);
+        return isOk(shard, key, ip);
     }
 
     /**
@@ -147,10 +199,13 @@ public:
     void
     increment(std::string const& ip) noexcept
     {
-        if (whitelist_.contains(ip))
+        auto const key = toKey(ip);
+        if (isWhiteListed(key))
             return;
-        std::scoped_lock lck{mtx_};
-        ipConnCount_[ip]++;
+
+        auto& shard = shardFor(key);
+        std::scoped_lock lck{shard.mtx};
+        shard.ipConnCount[key]++;
     }
 
     /**
@@ -161,13 +216,16 @@ public:
     void
     decrement(std::string const& ip) noexcept
     {
-        if (whitelist_.contains(ip))
+        auto const key = toKey(ip);
+        if (isWhiteListed(key))
             return;
-        std::scoped_lock lck{mtx_};
-        assert(ipConnCount_[ip] > 0);
-        ipConnCount_[ip]--;
-        if (ipConnCount_[ip] == 0)
-            ipConnCount_.erase(ip);
+
+        auto& shard = shardFor(key);
+        std::scoped_lock lck{shard.mtx};
+        auto it = shard.ipConnCount.find(key);
+        assert(it != shard.ipConnCount.end() && it->second > 0);
+        if (it != shard.ipConnCount.end() && --it->second == 0)
+            shard.ipConnCount.erase(it);
     }
 
     /**
@@ -185,15 +243,14 @@ public:
     [[maybe_unused]] bool
     add(std::string const& ip, uint32_t numObjects) noexcept
     {
-        if (whitelist_.contains(ip))
+        auto const key = toKey(ip);
+        if (isWhiteListed(key))
             return true;
 
-        {
-            std::scoped_lock lck(mtx_);
-            ipState_[ip].transferedByte += numObjects;
-        }
-
-        return isOk(ip);
+        auto& shard = shardFor(key);
+        std::scoped_lock lck(shard.mtx);
+        shard.ipState[key].transferedByte += numObjects;
+        return isOk(shard, key, ip);
     }
 
     /**
@@ -210,36 +267,194 @@ public:
     [[maybe_unused]] bool
     request(std::string const& ip) noexcept
     {
-        if (whitelist_.contains(ip))
+        auto const key = toKey(ip);
+        if (isWhiteListed(key))
             return true;
 
-        {
-            std::scoped_lock lck(mtx_);
-            ipState_[ip].requestsCount++;
-        }
+        auto& shard = shardFor(key);
+        std::scoped_lock lck(shard.mtx);
+        shard.ipState[key].requestsCount++;
+        return isOk(shard, key, ip);
+    }
 
-        return isOk(ip);
+    /**
+     * @brief Charges the measured cost of a served request to the given ip
+     * address.
+     *
+     * The cost is taken from the token bucket of the ip address, which
+     * refills at dos_guard.cost_per_second up to dos_guard.max_cost. Once the
+     * bucket is empty the operation is no longer allowed and false is
+     * returned; true is returned otherwise.
+     *
+     * @param ip
+     * @param cost
+     * @return true
+     * @return false
+     */
+    [[maybe_unused]] bool
+    charge(std::string const& ip, std::uint64_t cost) noexcept
+    {
+        auto const key = toKey(ip);
+        if (maxCost_ == 0 || isWhiteListed(key))
+            return true;
+
+        auto const now = std::chrono::steady_clock::now();
+        auto& shard = shardFor(key);
+        std::scoped_lock lck(shard.mtx);
+        auto const it =
+            shard.ipCost.try_emplace(key, CostBucket{maxCost_, now}).first;
+        it->second.tokens = available(it->second, now) - cost;
+        it->second.updated = now;
+        return isOk(shard, key, ip);
     }
 
     /**
      * @brief Instantly clears all fetch counters added by @see add(std::string
-     * const&, uint32_t)
+     * const&, uint32_t), and forgets the cost buckets that refilled
      */
     void
     clear() noexcept override
     {
-        std::scoped_lock lck(mtx_);
-        ipState_.clear();
+        auto const now = std::chrono::steady_clock::now();
+        for (auto& shard : shards_)
+        {
+            std::scoped_lock lck(shard.mtx);
+            shard.ipState.clear();
+            std::erase_if(shard.ipCost, [&](auto const& entry) {
+                return available(entry.second, now) >= maxCost_;
+            });
+        }
     }
 
 private:
-    [[nodiscard]] std::unordered_set<std::string> const
+    /**
+     * @brief Parse an ip address into its binary key. A string that is not
+     * an address is keyed on its hash, in a range real IPv6 addresses do not
+     * use, so that it is still accounted for.
+     */
+    [[nodiscard]] static IpKey
+    toKey(std::string const& ip) noexcept
+    {
+        // dotted IPv4, by far the most common, is parsed by hand as it is
+        // several times cheaper than the generic parser
+        IpKey key{};
+        key[10] = key[11] = 0xff;
+        std::size_t octet = 12;
+        unsigned value = 0;
+        unsigned digits = 0;
+        for (auto const c : ip)
+        {
+            if (c >= '0' && c <= '9' && digits < 3)
+            {
+                value = value * 10 + (c - '0');
+                ++digits;
+            }
+            else if (c == '.' && digits && octet < 15 && value < 256)
+            {
+                key[octet++] = static_cast<unsigned char>(value);
+                value = digits = 0;
+            }
+            else
+            {
+                octet = 0;
+                break;
+            }
+        }
+        if (octet == 15 && digits && value < 256)
+        {
+            key[15] = static_cast<unsigned char>(value);
+            return key;
+        }
+
+        boost::system::error_code ec;
+        auto const address = boost::asio::ip::make_address(ip, ec);
+        if (!ec)
+        {
+            if (address.is_v4())
+                return boost::asio::ip::make_address_v6(
+                           boost::asio::ip::v4_mapped, address.to_v4())
+                    .to_bytes();
+            return address.to_v6().to_bytes();
+        }
+
+        // 0100::/64 is the discard-only prefix, never a client address
+        key = {};
+        key[0] = 0x01;
+        auto const hash = std::hash<std::string>{}(ip);
+        std::memcpy(key.data() + 8, &hash, std::min(sizeof(hash), size_t{8}));
+        return key;
+    }
+
+    [[nodiscard]] bool
+    isWhiteListed(IpKey const& key) const noexcept
+    {
+        return !whitelist_.empty() && whitelist_.contains(key);
+    }
+
+    [[nodiscard]] Shard&
+    shardFor(IpKey const& key) const noexcept
+    {
+        return shards_[IpKeyHash{}(key) % numShards];
+    }
+
+    // Tokens in a cost bucket once refilled up to now
+    [[nodiscard]] double
+    available(
+        CostBucket const& bucket,
+        std::chrono::steady_clock::time_point now) const noexcept
+    {
+        std::chrono::duration<double> const elapsed = now - bucket.updated;
+        return std::min(
+            maxCost_, bucket.tokens + elapsed.count() * costPerSecond_);
+    }
+
+    // Check the limits of a client whose shard is locked by the caller
+    [[nodiscard]] bool
+    isOk(Shard const& shard, IpKey const& key, std::string const& ip)
+        const noexcept
+    {
+        if (auto it = shard.ipState.find(key); it != shard.ipState.end())
+        {
+            auto [transferedByte, requests] = it->second;
+            if (transferedByte > maxFetches_ || requests > maxRequestCount_)
+            {
+                log_.warn() << "Dosguard:Client surpassed the rate limit. ip = "
+                            << ip << " Transfered Byte:" << transferedByte
+                            << " Requests:" << requests;
+                return false;
+            }
+        }
+        if (auto it = shard.ipCost.find(key); it != shard.ipCost.end())
+        {
+            auto const tokens =
+                available(it->second, std::chrono::steady_clock::now());
+            if (tokens <= 0)
+            {
+                log_.warn() << "Dosguard:Client surpassed the rate limit. ip = "
+                            << ip << " Cost debt:" << -tokens;
+                return false;
+            }
+        }
+        if (auto it = shard.ipConnCount.find(key);
+            it != shard.ipConnCount.end())
+        {
+            if (it->second > maxConnCount_)
+            {
+                log_.warn() << "Dosguard:Client surpassed the rate limit. ip = "
+                            << ip << " Concurrent connection:" << it->second;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::unordered_set<IpKey, IpKeyHash> const
     getWhitelist(clio::Config const& config) const
     {
-        using T = std::unordered_set<std::string> const;
+        using T = std::unordered_set<IpKey, IpKeyHash> const;
         auto whitelist = config.arrayOr("dos_guard.whitelist", {});
         auto const transform = [](auto const& elem) {
-            return elem.template value<std::string>();
+            return toKey(elem.template value<std::string>());
         };
         return T{
             boost::transform_iterator(std::begin(whitelist), transform),
@@ -21,6 +21,7 @@
 
 #include <boost/asio/dispatch.hpp>
 #include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
@@ -30,12 +31,15 @@
 #include <boost/json.hpp>
 #include <algorithm>
 #include <cstdlib>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>
 
+#include <etl/CacheTransfer.h>
 #include <etl/ReportingETL.h>
 #include <log/Logger.h>
 #include <main/Build.h>
@@ -46,6 +50,7 @@
 #include <util/Taggable.h>
 #include <vector>
 #include <webserver/DOSGuard.h>
+#include <webserver/JsonBody.h>
 
 // TODO: consider removing those - visible to anyone including this header
 namespace http = boost::beast::http;
@@ -59,6 +64,33 @@ static std::string defaultResponse =
     " Test</h1><p>This page shows xrpl reporting http(s) "
     "connectivity is working.</p></body></html>";
 
+// Maximum number of requests read from a connection ahead of the response to
+// the oldest of them
+static constexpr std::size_t maxPipelinedRequests = 16;
+
+// Maximum number of requests in a JSON-RPC batch
+static constexpr std::size_t maxBatchSize = 256;
+
+// The work queue lane of a JSON-RPC request or batch. A batch goes to the
+// lane of its most expensive request
+inline WorkQueue::Lane
+requestLane(boost::json::value const& request)
+{
+    if (auto const* object = request.if_object())
+        return RPC::laneFor(*object);
+
+    auto lane = WorkQueue::Lane::lookup;
+    if (auto const* batch = request.if_array())
+    {
+        for (auto const& value : *batch)
+        {
+            if (auto const* object = value.if_object())
+                lane = std::max(lane, RPC::laneFor(*object));
+        }
+    }
+    return lane;
+}
+
 // From Boost Beast examples http_server_flex.cpp
 template <class Derived>
 class HttpBase : public util::Taggable
@@ -71,46 +103,44 @@ class HttpBase : public util::Taggable
         return static_cast<Derived&>(*this);
     }
 
-    struct send_lambda
+    // Hands the response to one of the pipelined requests back to the
+    // session. Can be called from any thread
+    struct Responder
     {
-        HttpBase& self_;
-
-        explicit send_lambda(HttpBase& self) : self_(self)
-        {
-        }
+        std::shared_ptr<Derived> session_;
+        std::uint64_t sequence_;
 
         template <bool isRequest, class Body, class Fields>
         void
         operator()(http::message<isRequest, Body, Fields>&& msg) const
         {
-            if (self_.dead())
-                return;
-
             // The lifetime of the message has to extend
             // for the duration of the async operation so
             // we use a shared_ptr to manage it.
             auto sp = std::make_shared<http::message<isRequest, Body, Fields>>(
                 std::move(msg));
 
-            // Store a type-erased version of the shared
-            // pointer in the class to keep it alive.
-            self_.res_ = sp;
-
-            // Write the response
-            http::async_write(
-                self_.derived().stream(),
-                *sp,
-                boost::beast::bind_front_handler(
-                    &HttpBase::on_write,
-                    self_.derived().shared_from_this(),
-                    sp->need_eof()));
+            // The session only keeps the type-erased write of the message
+            auto session = session_;
+            auto write = [session, sp]() {
+                http::async_write(
+                    session->stream(),
+                    *sp,
+                    boost::beast::bind_front_handler(
+                        &HttpBase::on_write, session, sp->need_eof()));
+            };
+
+            net::post(
+                session->stream().get_executor(),
+                [session, sequence = sequence_, write = std::move(write)]() {
+                    session->on_response(sequence, std::move(write));
+                });
         }
     };
 
     boost::system::error_code ec_;
     boost::asio::io_context& ioc_;
     http::request<http::string_body> req_;
-    std::shared_ptr<void> res_;
     std::shared_ptr<BackendInterface const> backend_;
     std::shared_ptr<SubscriptionManager> subscriptions_;
     std::shared_ptr<ETLLoadBalancer> balancer_;
@@ -119,7 +149,25 @@ class HttpBase : public util::Taggable
     clio::DOSGuard& dosGuard_;
     RPC::Counters& counters_;
     WorkQueue& workQueue_;
-    send_lambda lambda_;
+
+    // Writes of the responses to the requests being handled, in the order
+    // the requests were read. Empty until the response is ready. A response
+    // is written once all the ones before it are
+    std::deque<std::function<void()>> pending_;
+    // sequence of the request at the front of pending_
+    std::uint64_t firstPending_ = 0;
+    bool reading_ = false;
+    bool writing_ = false;
+    // set once the client is not going to send any more requests
+    bool closing_ = false;
+    // websocket upgrade waiting for the pending responses to be written
+    std::optional<http::request<http::string_body>> upgrade_;
+    // timeout of reads and writes on the stream
+    std::chrono::steady_clock::duration timeout_ = std::chrono::seconds(30);
+    // whether the read in flight was started with a timeout
+    bool readTimed_ = false;
+    // bounds a read started without a timeout once every response is written
+    net::steady_timer idleTimer_;
 
 protected:
     clio::Logger log_{"WebServer"};
@@ -188,7 +236,7 @@ public:
         , dosGuard_(dosGuard)
         , counters_(counters)
         , workQueue_(queue)
-        , lambda_(*this)
+        , idleTimer_(ioc)
         , buffer_(std::move(buffer))
     {
         perfLog_.debug() << tag() << "http session created";
@@ -205,18 +253,40 @@ public:
         return dosGuard_;
     }
 
+    // Timeout of reads and writes. Must be set before the session is run
+    void
+    setTimeout(std::chrono::steady_clock::duration timeout)
+    {
+        timeout_ = timeout;
+    }
+
+    // Read the next request, unless one is already being read or too many
+    // requests are waiting for their response. Requests are read while the
+    // ones before them are handled, so a client pipelining its requests does
+    // not pay a round trip per request
     void
     do_read()
     {
-        if (dead())
+        if (dead() || reading_ || closing_ || upgrade_ ||
+            pending_.size() >= maxPipelinedRequests)
             return;
+        reading_ = true;
+
         // Make the request empty before reading,
         // otherwise the operation behavior is undefined.
         req_ = {};
 
-        // Set the timeout.
-        boost::beast::get_lowest_layer(derived().stream())
-            .expires_after(std::chrono::seconds(30));
+        // A handler slower than the timeout must not time out the read of
+        // the next request, closing the connection its response is owed to.
+        // So the read only times out if no response is owed, otherwise the
+        // idle timer takes over once they are written, see on_write. Only
+        // applies to the read when a response is being written
+        auto& stream = boost::beast::get_lowest_layer(derived().stream());
+        readTimed_ = pending_.empty();
+        if (readTimed_)
+            stream.expires_after(timeout_);
+        else
+            stream.expires_never();
 
         // Read a request
         http::async_read(
@@ -231,10 +301,18 @@ public:
     on_read(boost::beast::error_code ec, std::size_t bytes_transferred)
     {
         boost::ignore_unused(bytes_transferred);
+        reading_ = false;
+        idleTimer_.cancel();
 
-        // This means they closed the connection
+        // This means they closed the connection. Responses to the requests
+        // already read are still written
         if (ec == http::error::end_of_stream)
-            return derived().do_close();
+        {
+            closing_ = true;
+            if (pending_.empty())
+                derived().do_close();
+            return;
+        }
 
         if (ec)
             return httpFail(ec, "read");
@@ -246,87 +324,110 @@ public:
             return;
         }
 
+        if (boost::beast::websocket::is_upgrade(req_))
+        {
+            // The stream is handed over to the websocket session once the
+            // responses to the requests before the upgrade are written
+            upgrade_ = std::move(req_);
+            if (pending_.empty())
+                do_upgrade();
+            return;
+        }
+
+        auto const version = req_.version();
+        auto const keepAlive = req_.keep_alive();
         auto const httpResponse = [&](http::status status,
                                       std::string content_type,
                                       std::string message) {
-            http::response<http::string_body> res{status, req_.version()};
+            http::response<http::string_body> res{status, version};
             res.set(
                 http::field::server,
                 "clio-server-" + Build::getClioVersionString());
             res.set(http::field::content_type, content_type);
-            res.keep_alive(req_.keep_alive());
+            res.keep_alive(keepAlive);
             res.body() = std::string(message);
             res.prepare_payload();
             return res;
         };
 
-        if (boost::beast::websocket::is_upgrade(req_))
-        {
-            upgraded_ = true;
-            // Disable the timeout.
-            // The websocket::stream uses its own timeout settings.
-            boost::beast::get_lowest_layer(derived().stream()).expires_never();
-            return make_websocket_session(
-                ioc_,
-                derived().release_stream(),
-                derived().ip(),
-                std::move(req_),
-                std::move(buffer_),
-                backend_,
-                subscriptions_,
-                balancer_,
-                etl_,
-                tagFactory_,
-                dosGuard_,
-                counters_,
-                workQueue_);
-        }
+        if (!keepAlive)
+            closing_ = true;
+
+        auto session = derived().shared_from_this();
+        Responder respond{session, firstPending_ + pending_.size()};
+        pending_.emplace_back();
 
         // to avoid overwhelm work queue, the request limit check should be
         // before posting to queue the web socket creation will be guarded via
         // connection limit
         if (!dosGuard_.request(ip.value()))
         {
-            return lambda_(httpResponse(
+            respond(httpResponse(
                 http::status::service_unavailable,
                 "text/plain",
                 "Server is overloaded"));
+            return do_read();
         }
 
         log_.info() << tag() << "Received request from ip = " << *ip
                     << " - posting to WorkQueue";
 
-        auto session = derived().shared_from_this();
-
         // Requests are handed using coroutines. Here we spawn a coroutine
-        // which will asynchronously handle a request.
+        // which will asynchronously handle a request. The lane of a request
+        // is only known once its body is parsed, which the worker does after
+        // the request is admitted to the lookup lane. Invalid JSON is
+        // answered by handle_request
+        auto const isWhiteListed = dosGuard_.isWhiteListed(*ip);
         if (!workQueue_.postCoro(
-                [this, ip, session](boost::asio::yield_context yield) {
-                    handle_request(
-                        yield,
-                        std::move(req_),
-                        lambda_,
-                        backend_,
-                        subscriptions_,
-                        balancer_,
-                        etl_,
-                        tagFactory_,
-                        dosGuard_,
-                        counters_,
-                        *ip,
-                        session,
-                        perfLog_);
+                [this,
+                 session,
+                 respond,
+                 ip = *ip,
+                 isWhiteListed,
+                 req = std::move(req_)](
+                    boost::asio::yield_context yield) mutable {
+                    run_request(
+                        yield, std::move(req), respond, ip, isWhiteListed);
                 },
-                dosGuard_.isWhiteListed(*ip)))
+                isWhiteListed))
         {
             // Non-whitelist connection rejected due to full connection
             // queue
-            lambda_(httpResponse(
+            respond(httpResponse(
                 http::status::ok,
                 "application/json",
                 boost::json::serialize(
                     RPC::makeError(RPC::RippledError::rpcTOO_BUSY))));
         }
+
+        do_read();
+    }
+
+    void
+    on_response(std::uint64_t sequence, std::function<void()> write)
+    {
+        if (dead())
+            return;
+
+        pending_[sequence - firstPending_] = std::move(write);
+        do_write();
+    }
+
+    // Write the response to the oldest pending request, if it is ready
+    void
+    do_write()
+    {
+        if (dead() || writing_ || pending_.empty() || !pending_.front())
+            return;
+        writing_ = true;
+
+        // Only applies to the write when a request is being read
+        boost::beast::get_lowest_layer(derived().stream())
+            .expires_after(timeout_);
+
+        // The write stays at the front of pending_, keeping the response
+        // alive, for the duration of the write
+        pending_.front()();
     }
 
     void
@@ -336,6 +437,7 @@ public:
         std::size_t bytes_transferred)
     {
         boost::ignore_unused(bytes_transferred);
+        writing_ = false;
 
         if (ec)
             return httpFail(ec, "write");
@@ -348,24 +450,305 @@ public:
         }
 
         // We're done with the response so delete it
-        res_ = nullptr;
+        pending_.pop_front();
+        ++firstPending_;
 
-        // Read another request
+        if (pending_.empty())
+        {
+            if (upgrade_)
+                return do_upgrade();
+            if (closing_ && !reading_)
+                return derived().do_close();
+            if (reading_ && !readTimed_)
+                start_idle_timer();
+        }
+
+        do_write();
+        // Reading may have stopped at the pipelining limit
         do_read();
     }
+
+private:
+    // Close the connection unless a request is read within the timeout. For
+    // a read started while responses were owed, whose own timer can't be set
+    // while it is in flight
+    void
+    start_idle_timer()
+    {
+        idleTimer_.expires_after(timeout_);
+        idleTimer_.async_wait(net::bind_executor(
+            derived().stream().get_executor(),
+            [session = derived().shared_from_this()](
+                boost::system::error_code ec) {
+                if (!ec && session->reading_)
+                    session->httpFail(
+                        boost::beast::error::timeout, "idle timeout");
+            }));
+    }
+
+    // Parse the body of an admitted request and handle it in the lane the
+    // request belongs to. Runs on a worker, the I/O threads never parse the
+    // bodies clients send
+    void
+    run_request(
+        boost::asio::yield_context& yield,
+        http::request<http::string_body>&& req,
+        Responder respond,
+        std::string const& ip,
+        bool isWhiteListed)
+    {
+        std::optional<boost::json::value> body;
+        auto lane = WorkQueue::Lane::lookup;
+        if (req.method() == http::verb::post)
+        {
+            try
+            {
+                body = boost::json::parse(req.body());
+                lane = requestLane(*body);
+            }
+            catch (std::runtime_error const&)
+            {
+            }
+        }
+
+        auto handle = [this,
+                       session = derived().shared_from_this(),
+                       respond,
+                       ip,
+                       req = std::move(req),
+                       body = std::move(body)](
+                          boost::asio::yield_context yield) mutable {
+            handle_request(
+                yield,
+                std::move(req),
+                std::move(body),
+                respond,
+                ioc_,
+                backend_,
+                subscriptions_,
+                balancer_,
+                etl_,
+                tagFactory_,
+                dosGuard_,
+                counters_,
+                ip,
+                session,
+                perfLog_);
+        };
+
+        if (isWhiteListed || lane == WorkQueue::Lane::lookup)
+            return handle(yield);
+        workQueue_.repostCoro(std::move(handle), lane);
+    }
+
+    void
+    do_upgrade()
+    {
+        upgraded_ = true;
+        // Disable the timeout.
+        // The websocket::stream uses its own timeout settings.
+        boost::beast::get_lowest_layer(derived().stream()).expires_never();
+        make_websocket_session(
+            ioc_,
+            derived().release_stream(),
+            derived().ip(),
+            std::move(*upgrade_),
+            std::move(buffer_),
+            backend_,
+            subscriptions_,
+            balancer_,
+            etl_,
+            tagFactory_,
+            dosGuard_,
+            counters_,
+            workQueue_);
+    }
 };
 
+// Execute one JSON-RPC request and build the object sent back for it. Errors
+// are reported in the returned object.
+template <class Session>
+boost::json::object
+handle_rpc(
+    boost::asio::yield_context& yc,
+    boost::json::object request,
+    std::shared_ptr<BackendInterface const> const& backend,
+    std::shared_ptr<SubscriptionManager> const& subscriptions,
+    std::shared_ptr<ETLLoadBalancer> const& balancer,
+    std::shared_ptr<ReportingETL const> const& etl,
+    util::TagDecoratorFactory const& tagFactory,
+    Backend::LedgerRange const& range,
+    clio::DOSGuard& dosGuard,
+    RPC::Counters& counters,
+    std::string const& ip,
+    Session& http,
+    clio::Logger& perfLog)
+{
+    if (!request.contains("params"))
+        request["params"] = boost::json::array({boost::json::object{}});
+
+    std::optional<RPC::Context> context = RPC::make_HttpContext(
+        yc,
+        request,
+        backend,
+        subscriptions,
+        balancer,
+        etl,
+        tagFactory.with(std::cref(http.tag())),
+        range,
+        counters,
+        ip);
+
+    if (!context)
+        return RPC::makeError(RPC::RippledError::rpcBAD_SYNTAX);
+
+    boost::json::object response;
+    auto [v, timeDiff] =
+        util::timed([&]() { return RPC::buildResponse(*context); });
+
+    auto us = std::chrono::duration<int, std::milli>(timeDiff);
+    RPC::logDuration(*context, us);
+
+    // clients are charged for the database work their requests caused
+    dosGuard.charge(ip, context->meter.cost());
+
+    if (auto status = std::get_if<RPC::Status>(&v))
+    {
+        counters.rpcErrored(context->method);
+        auto error = RPC::makeError(*status);
+        error["request"] = request;
+        response["result"] = error;
+
+        perfLog.debug() << http.tag() << "Encountered error: "
+                        << boost::json::serialize(error);
+    }
+    else
+    {
+        // This can still technically be an error. Clio counts forwarded
+        // requests as successful.
+
+        counters.rpcComplete(context->method, us);
+
+        auto result = std::get<boost::json::object>(v);
+        if (result.contains("result") && result.at("result").is_object())
+            result = result.at("result").as_object();
+
+        if (!result.contains("error"))
+            result["status"] = "success";
+
+        response["result"] = result;
+    }
+
+    boost::json::array warnings;
+    warnings.emplace_back(RPC::makeWarning(RPC::warnRPC_CLIO));
+    auto lastCloseAge = context->etl->lastCloseAgeSeconds();
+    if (lastCloseAge >= 60)
+        warnings.emplace_back(RPC::makeWarning(RPC::warnRPC_OUTDATED));
+    response["warnings"] = warnings;
+    return response;
+}
+
+// Execute the requests of a JSON-RPC batch and return their responses in
+// request order. Every request is handled by its own coroutine. The coroutines
+// run on the strand of yc, so the state below is not synchronized, and their
+// database reads overlap. admit is called with the index of each request, in
+// order, before it runs. Once it refuses one, that request and the ones after
+// it get rpcSLOW_DOWN in their slots without running. A request that is not an
+// object or whose handling throws gets an error object in its slot. A batch
+// that is empty or holds more than maxBatchSize requests is answered by a
+// single error object.
+template <class Admit, class Handle>
+boost::json::value
+handle_batch(
+    boost::asio::yield_context& yc,
+    boost::asio::io_context& ioc,
+    boost::json::array const& batch,
+    Admit&& admit,
+    Handle&& handle,
+    clio::Logger& log)
+{
+    if (batch.empty() || batch.size() > maxBatchSize)
+        return RPC::makeError(
+            RPC::RippledError::rpcBAD_SYNTAX,
+            std::nullopt,
+            "Batch must hold between 1 and " + std::to_string(maxBatchSize) +
+                " requests.");
+
+    boost::json::array responses(batch.size());
+    std::size_t numRemaining = batch.size();
+    boost::asio::steady_timer done{
+        ioc, boost::asio::steady_timer::time_point::max()};
+
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        if (!admit(i))
+        {
+            // neither this request nor the ones after it run
+            numRemaining -= batch.size() - i;
+            for (; i < batch.size(); ++i)
+                responses[i] = RPC::makeError(RPC::RippledError::rpcSLOW_DOWN);
+            break;
+        }
+
+        boost::asio::spawn(yc, [&, i](boost::asio::yield_context yield) {
+            try
+            {
+                if (batch[i].is_object())
+                    responses[i] = handle(yield, batch[i].as_object());
+                else
+                    responses[i] =
+                        RPC::makeError(RPC::RippledError::rpcBAD_SYNTAX);
+            }
+            catch (std::exception const& e)
+            {
+                log.error() << "Caught exception in batch request " << i
+                            << " : " << e.what();
+                responses[i] = RPC::makeError(RPC::RippledError::rpcINTERNAL);
+            }
+
+            if (--numRemaining == 0)
+                done.cancel();
+        });
+    }
+
+    if (numRemaining != 0)
+    {
+        boost::system::error_code ec;
+        done.async_wait(yc[ec]);
+    }
+    return responses;
+}
+
+// The admission of the requests of a JSON-RPC batch from ip, for handle_batch.
+// The first request was charged when the batch was read. Every further
+// dosGuard.batchRequestsPerCharge() requests, by default each of them, are
+// charged again, and are refused once the ip is over its request limit
+inline auto
+chargeBatchRequests(clio::DOSGuard& dosGuard, std::string const& ip)
+{
+    return [&dosGuard, &ip, perCharge = dosGuard.batchRequestsPerCharge()](
+               std::size_t i) {
+        return i == 0 || i % perCharge != 0 || dosGuard.request(ip);
+    };
+}
+
 // This function produces an HTTP response for the given
 // request. The type of the response object depends on the
 // contents of the request, so the interface requires the
 // caller to pass a generic lambda for receiving the response.
+//
+// The body of a POST request is either a single JSON-RPC request object or a
+// batch: an array of request objects, answered by an array of the responses
+// in the same order.
 template <class Body, class Allocator, class Send, class Session>
 void
 handle_request(
     boost::asio::yield_context& yc,
     boost::beast::http::
         request<Body, boost::beast::http::basic_fields<Allocator>>&& req,
+    std::optional<boost::json::value> body,
     Send&& send,
+    boost::asio::io_context& ioc,
     std::shared_ptr<BackendInterface const> backend,
     std::shared_ptr<SubscriptionManager> subscriptions,
     std::shared_ptr<ETLLoadBalancer> balancer,
@@ -392,6 +775,36 @@ handle_request(
         return res;
     };
 
+    if (req.method() == http::verb::get)
+    {
+        std::string_view const target{req.target().data(), req.target().size()};
+        if (auto const transfer = CacheTransfer::parseTarget(target); transfer)
+        {
+            // a transfer dumps the whole ledger state, only whitelisted
+            // peers are served
+            if (!dosGuard.isWhiteListed(ip))
+                return send(httpResponse(
+                    http::status::forbidden, "text/plain", "forbidden"));
+
+            try
+            {
+                auto const page =
+                    CacheTransfer::fetchPage(*backend, *transfer, yc);
+                auto res = CacheTransfer::makeResponse(
+                    page, transfer->compress, req.version());
+                res.keep_alive(req.keep_alive());
+                return send(std::move(res));
+            }
+            catch (Backend::DatabaseTimeout const&)
+            {
+                return send(httpResponse(
+                    http::status::service_unavailable,
+                    "text/plain",
+                    "tooBusy"));
+            }
+        }
+    }
+
     if (req.method() == http::verb::get && req.body() == "")
     {
         send(httpResponse(http::status::ok, "text/html", defaultResponse));
@@ -408,16 +821,8 @@ handle_request(
                         << "http received request from work queue: "
                         << req.body();
 
-        boost::json::object request;
-        std::string responseStr = "";
-        try
-        {
-            request = boost::json::parse(req.body()).as_object();
-
-            if (!request.contains("params"))
-                request["params"] = boost::json::array({boost::json::object{}});
-        }
-        catch (std::runtime_error const& e)
+        // the body was parsed when the request was read
+        if (!body)
         {
             return send(httpResponse(
                 http::status::ok,
@@ -426,6 +831,8 @@ handle_request(
                     RPC::makeError(RPC::RippledError::rpcBAD_SYNTAX))));
         }
 
+        auto& request = *body;
+
         auto range = backend->fetchLedgerRange();
         if (!range)
             return send(httpResponse(
@@ -434,76 +841,95 @@ handle_request(
                 boost::json::serialize(
                     RPC::makeError(RPC::RippledError::rpcNOT_READY))));
 
-        std::optional<RPC::Context> context = RPC::make_HttpContext(
-            yc,
-            request,
-            backend,
-            subscriptions,
-            balancer,
-            etl,
-            tagFactory.with(std::cref(http->tag())),
-            *range,
-            counters,
-            ip);
-
-        if (!context)
-            return send(httpResponse(
-                http::status::ok,
-                "application/json",
-                boost::json::serialize(
-                    RPC::makeError(RPC::RippledError::rpcBAD_SYNTAX))));
-
-        boost::json::object response;
-        auto [v, timeDiff] =
-            util::timed([&]() { return RPC::buildResponse(*context); });
-
-        auto us = std::chrono::duration<int, std::milli>(timeDiff);
-        RPC::logDuration(*context, us);
-
-        if (auto status = std::get_if<RPC::Status>(&v))
+        boost::json::value response;
+        if (request.is_array())
         {
-            counters.rpcErrored(context->method);
-            auto error = RPC::makeError(*status);
-            error["request"] = request;
-            response["result"] = error;
-
-            perfLog.debug()
-                << http->tag() << "Encountered error: " << responseStr;
+            response = handle_batch(
+                yc,
+                ioc,
+                request.as_array(),
+                chargeBatchRequests(dosGuard, ip),
+                [&](boost::asio::yield_context& yield,
+                    boost::json::object const& entry) {
+                    return handle_rpc(
+                        yield,
+                        entry,
+                        backend,
+                        subscriptions,
+                        balancer,
+                        etl,
+                        tagFactory,
+                        *range,
+                        dosGuard,
+                        counters,
+                        ip,
+                        *http,
+                        perfLog);
+                },
+                perfLog);
         }
         else
         {
-            // This can still technically be an error. Clio counts forwarded
-            // requests as successful.
-
-            counters.rpcComplete(context->method, us);
-
-            auto result = std::get<boost::json::object>(v);
-            if (result.contains("result") && result.at("result").is_object())
-                result = result.at("result").as_object();
-
-            if (!result.contains("error"))
-                result["status"] = "success";
-
-            response["result"] = result;
+            auto result = handle_rpc(
+                yc,
+                std::move(request.as_object()),
+                backend,
+                subscriptions,
+                balancer,
+                etl,
+                tagFactory,
+                *range,
+                dosGuard,
+                counters,
+                ip,
+                *http,
+                perfLog);
+
+            if (!result.contains("warnings"))
+                return send(httpResponse(
+                    http::status::ok,
+                    "application/json",
+                    boost::json::serialize(result)));
+            response = std::move(result);
         }
 
-        boost::json::array warnings;
-        warnings.emplace_back(RPC::makeWarning(RPC::warnRPC_CLIO));
-        auto lastCloseAge = context->etl->lastCloseAgeSeconds();
-        if (lastCloseAge >= 60)
-            warnings.emplace_back(RPC::makeWarning(RPC::warnRPC_OUTDATED));
-        response["warnings"] = warnings;
-        responseStr = boost::json::serialize(response);
-        if (!dosGuard.add(ip, responseStr.size()))
+        // The response is accounted for once it is serialized, so the load
+        // warning goes out with the responses after the one that crossed
+        // the limit. This way the response is only serialized once
+        if (!dosGuard.isOk(ip))
         {
-            response["warning"] = "load";
-            warnings.emplace_back(RPC::makeWarning(RPC::warnRPC_RATE_LIMIT));
-            response["warnings"] = warnings;
-            // reserialize when we need to include this warning
-            responseStr = boost::json::serialize(response);
+            auto const addLoadWarning = [](boost::json::value& value) {
+                auto* const obj = value.if_object();
+                if (!obj || !obj->contains("warnings"))
+                    return;
+                (*obj)["warning"] = "load";
+                (*obj)["warnings"].as_array().emplace_back(
+                    RPC::makeWarning(RPC::warnRPC_RATE_LIMIT));
+            };
+
+            if (response.is_array())
+            {
+                for (auto& value : response.as_array())
+                    addLoadWarning(value);
+            }
+            else
+            {
+                addLoadWarning(response);
+            }
         }
-        return send(
-            httpResponse(http::status::ok, "application/json", responseStr));
+
+        http::response<JsonBody> res{http::status::ok, req.version()};
+        res.set(
+            http::field::server,
+            "clio-server-" + Build::getClioVersionString());
+        res.set(http::field::content_type, "application/json");
+        res.keep_alive(req.keep_alive());
+        res.body().json = std::move(response);
+        res.body().onSerialized = [&dosGuard, ip](std::size_t size) {
+            dosGuard.add(ip, size);
+        };
+        res.prepare_payload();
+        return send(std::move(res));
     }
     catch (std::exception const& e)
     {
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+#include <boost/optional.hpp>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+/// An HTTP body holding a JSON value, which is serialized a chunk at a time
+/// straight into the buffers written to the stream. A large response is never
+/// held as one string next to its DOM, and its first bytes are sent while the
+/// rest is still being serialized. The size of the body is not known upfront,
+/// so it is sent with chunked transfer encoding.
+struct JsonBody
+{
+    struct value_type
+    {
+        boost::json::value json;
+        // called with the number of bytes of the value handed to the stream
+        // once the write is over, also when it was cut short
+        std::function<void(std::size_t)> onSerialized;
+    };
+
+    static constexpr std::size_t chunkSize = 16384;
+
+    class writer
+    {
+        value_type const& body_;
+        boost::json::serializer serializer_;
+        std::array<char, chunkSize> buffer_;
+        std::size_t size_ = 0;
+
+    public:
+        using const_buffers_type = boost::asio::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer(
+            boost::beast::http::header<isRequest, Fields> const&,
+            value_type const& body)
+            : body_(body)
+        {
+        }
+
+        ~writer()
+        {
+            if (size_ != 0 && body_.onSerialized)
+                body_.onSerialized(size_);
+        }
+
+        void
+        init(boost::beast::error_code& ec)
+        {
+            serializer_.reset(&body_.json);
+            ec = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>>
+        get(boost::beast::error_code& ec)
+        {
+            ec = {};
+            if (serializer_.done())
+                return boost::none;
+
+            // the chunk stays valid until the next call
+            auto const chunk = serializer_.read(buffer_.data(), buffer_.size());
+            size_ += chunk.size();
+
+            return std::make_pair(
+                const_buffers_type{chunk.data(), chunk.size()},
+                !serializer_.done());
+        }
+    };
+};
@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#pragma once
+
+#include <log/Logger.h>
+#include <subscriptions/Message.h>
+#include <subscriptions/SubscriptionManager.h>
+#include <util/Taggable.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+/**
+ * @brief Messages waiting to be written to a websocket session.
+ *
+ * Published messages are capped by SendQueueLimits; responses to the
+ * client's own requests are always queued. Not thread safe: a session only
+ * touches its queue on its websocket's executor.
+ */
+class SendQueue
+{
+    SendQueueLimits const limits_;
+    clio::Logger log_;
+    util::BaseTagDecorator const& tag_;
+
+    std::deque<std::shared_ptr<Message>> messages_;
+    std::size_t bytes_ = 0;
+    // published messages dropped since the queue last had room
+    std::uint64_t dropped_ = 0;
+
+public:
+    enum class Result { queued, dropped, disconnect };
+
+    SendQueue(
+        SendQueueLimits const& limits,
+        clio::Logger log,
+        util::BaseTagDecorator const& tag)
+        : limits_(limits), log_(std::move(log)), tag_(tag)
+    {
+    }
+
+    /**
+     * @brief Whether a published message of the given size does not fit.
+     */
+    bool
+    full(std::size_t size) const
+    {
+        return (limits_.maxMessages &&
+                messages_.size() >= limits_.maxMessages) ||
+            (limits_.maxBytes && bytes_ + size > limits_.maxBytes);
+    }
+
+    /**
+     * @brief Queue a message.
+     *
+     * A published message that does not fit is dropped, or disconnect is
+     * returned for the session to close, according to the policy. The first
+     * drop of a run and the first published message queued after it are
+     * logged, rather than every dropped message.
+     *
+     * @param msg The message
+     * @param published Whether msg was published to a stream rather than
+     * sent in response to the client
+     * @return What happened to msg
+     */
+    Result
+    push(std::shared_ptr<Message> msg, bool published)
+    {
+        if (published && full(msg->size()))
+        {
+            if (limits_.policy == SendQueueLimits::Policy::disconnect)
+                return Result::disconnect;
+
+            if (dropped_++ == 0)
+                log_.warn() << tag_ << "Send queue full with "
+                            << messages_.size() << " messages, " << bytes_
+                            << " bytes. Dropping published messages";
+            return Result::dropped;
+        }
+
+        if (published && dropped_ != 0)
+        {
+            log_.warn() << tag_ << "Send queue has room again after "
+                        << dropped_ << " published messages were dropped";
+            dropped_ = 0;
+        }
+
+        bytes_ += msg->size();
+        messages_.push_back(std::move(msg));
+        return Result::queued;
+    }
+
+    /**
+     * @brief The message to write next. The queue must not be empty.
+     */
+    Message const&
+    front() const
+    {
+        return *messages_.front();
+    }
+
+    /**
+     * @brief Remove the front message once it is written.
+     */
+    void
+    pop()
+    {
+        bytes_ -= messages_.front()->size();
+        messages_.pop_front();
+    }
+
+    bool
+    empty() const
+    {
+        return messages_.empty();
+    }
+
+    std::size_t
+    size() const
+    {
+        return messages_.size();
+    }
+
+    /*! @brief Total size of the queued messages. */
+    std::size_t
+    bytes() const
+    {
+        return bytes_;
+    }
+};
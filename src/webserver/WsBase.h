@@ -31,6 +31,7 @@
 #include <util/Profiler.h>
 #include <util/Taggable.h>
 #include <webserver/DOSGuard.h>
+#include <webserver/SendQueue.h>
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
@@ -127,8 +128,10 @@ class WsSession : public WsBase,
     WorkQueue& queue_;
     std::mutex mtx_;
 
+    // Messages waiting to be written, the front one being written when
+    // sending_ is set. Only touched on the websocket's executor
     bool sending_ = false;
-    std::queue<std::shared_ptr<Message>> messages_;
+    SendQueue messages_;
 
 protected:
     std::optional<std::string> ip_;
@@ -171,6 +174,11 @@ public:
         , dosGuard_(dosGuard)
         , counters_(counters)
         , queue_(queue)
+        , messages_(
+              subscriptions ? subscriptions->sendQueueLimits()
+                            : SendQueueLimits{},
+              perfLog_,
+              tag())
         , ip_(ip)
     {
         perfLog_.info() << tag() << "session created";
@@ -196,7 +204,7 @@ public:
     {
         sending_ = true;
         derived().ws().async_write(
-            net::buffer(messages_.front()->data(), messages_.front()->size()),
+            messages_.front().buffer(),
             boost::beast::bind_front_handler(
                 &WsSession::on_write, derived().shared_from_this()));
     }
@@ -225,6 +233,29 @@ public:
         do_write();
     }
 
+    // Queue a message for writing. Published messages that do not fit in the
+    // queue are dropped, or the session is closed, according to the policy
+    void
+    enqueue(std::shared_ptr<Message> msg, bool published)
+    {
+        if (ec_)
+            return;
+
+        switch (messages_.push(std::move(msg), published))
+        {
+            case SendQueue::Result::queued:
+                maybe_send_next();
+                break;
+            case SendQueue::Result::dropped:
+                break;
+            case SendQueue::Result::disconnect:
+                wsFail(
+                    boost::asio::error::no_buffer_space,
+                    "Send queue full, disconnecting slow client");
+                break;
+        }
+    }
+
     void
     send(std::shared_ptr<Message> msg) override
     {
@@ -232,17 +263,21 @@ public:
             derived().ws().get_executor(),
             [this,
              self = derived().shared_from_this(),
-             msg = std::move(msg)]() {
-                messages_.push(std::move(msg));
-                maybe_send_next();
+             msg = std::move(msg)]() mutable {
+                enqueue(std::move(msg), true);
             });
     }
 
     void
     send(std::string&& msg)
     {
-        auto sharedMsg = std::make_shared<Message>(std::move(msg));
-        send(sharedMsg);
+        net::dispatch(
+            derived().ws().get_executor(),
+            [this,
+             self = derived().shared_from_this(),
+             msg = std::make_shared<Message>(std::move(msg))]() mutable {
+                enqueue(std::move(msg), false);
+            });
     }
 
     void
@@ -252,6 +287,13 @@ public:
         derived().ws().set_option(websocket::stream_base::timeout::suggested(
             boost::beast::role_type::server));
 
+        // Write every message as a single frame. Published messages are
+        // shared by all subscribers, and without compression an unfragmented
+        // frame is written as the frame header gathered with that shared
+        // buffer: no per subscriber copy, and one write per message instead
+        // of one per write_buffer_bytes of payload
+        derived().ws().auto_fragment(false);
+
         // Set a decorator to change the Server of the handshake
         derived().ws().set_option(websocket::stream_base::decorator(
             [](websocket::response_type& res) {
@@ -350,6 +392,9 @@ public:
             auto us = std::chrono::duration<int, std::milli>(timeDiff);
             logDuration(*context, us);
 
+            // clients are charged for the database work their requests caused
+            dosGuard_.charge(*ip, context->meter.cost());
+
             if (auto status = std::get_if<RPC::Status>(&v))
             {
                 counters_.rpcErrored(context->method);
@@ -394,16 +439,16 @@ public:
         auto lastCloseAge = etl_->lastCloseAgeSeconds();
         if (lastCloseAge >= 60)
             warnings.emplace_back(RPC::makeWarning(RPC::warnRPC_OUTDATED));
-        response["warnings"] = warnings;
-        std::string responseStr = boost::json::serialize(response);
-        if (!dosGuard_.add(*ip, responseStr.size()))
+        // the warning goes out with the responses after the one that crossed
+        // the limit, so the response is serialized only once
+        if (!dosGuard_.isOk(*ip))
         {
             response["warning"] = "load";
             warnings.emplace_back(RPC::makeWarning(RPC::warnRPC_RATE_LIMIT));
-            response["warnings"] = warnings;
-            // reserialize if we need to include this warning
-            responseStr = boost::json::serialize(response);
         }
+        response["warnings"] = warnings;
+        std::string responseStr = boost::json::serialize(response);
+        dosGuard_.add(*ip, responseStr.size());
         send(std::move(responseStr));
     }
 
@@ -468,6 +513,7 @@ public:
             request = raw.as_object();
 
             auto id = request.contains("id") ? request.at("id") : nullptr;
+            auto const lane = RPC::laneFor(request);
             perfLog_.debug() << tag() << "Adding to work queue";
 
             if (!queue_.postCoro(
@@ -476,7 +522,8 @@ public:
                      id](boost::asio::yield_context yield) {
                         shared_this->handle_request(std::move(r), id, yield);
                     },
-                    dosGuard_.isWhiteListed(*ip)))
+                    dosGuard_.isWhiteListed(*ip),
+                    lane))
                 sendError(RPC::RippledError::rpcTOO_BUSY, id, request);
         }
 
@@ -0,0 +1,275 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+
+#include <etl/CacheTransfer.h>
+
+#include <boost/asio/spawn.hpp>
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <string>
+
+namespace {
+
+std::vector<Backend::LedgerObject>
+makeObjects()
+{
+    std::vector<Backend::LedgerObject> objects;
+    for (unsigned char i = 0; i < 16; ++i)
+    {
+        Backend::LedgerObject obj;
+        obj.key.data()[0] = i;
+        obj.blob = Backend::Blob(i * 100, i);
+        objects.push_back(std::move(obj));
+    }
+    return objects;
+}
+
+}  // namespace
+
+TEST(CacheTransferTest, FramesRoundTrip)
+{
+    auto const objects = makeObjects();
+    auto const decoded =
+        CacheTransfer::decodeFrames(CacheTransfer::encodeFrames(objects));
+    ASSERT_TRUE(decoded);
+    ASSERT_EQ(decoded->size(), objects.size());
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        EXPECT_EQ((*decoded)[i].key, objects[i].key);
+        EXPECT_EQ((*decoded)[i].blob, objects[i].blob);
+    }
+}
+
+TEST(CacheTransferTest, TruncatedFrameRejected)
+{
+    auto encoded = CacheTransfer::encodeFrames(makeObjects());
+    encoded.pop_back();
+    EXPECT_FALSE(CacheTransfer::decodeFrames(encoded));
+}
+
+TEST(CacheTransferTest, CompressionRoundTrip)
+{
+    auto const encoded = CacheTransfer::encodeFrames(makeObjects());
+    auto const compressed = CacheTransfer::compress(encoded);
+    EXPECT_LT(compressed.size(), encoded.size());
+    auto const decompressed =
+        CacheTransfer::decompress(compressed, encoded.size());
+    ASSERT_TRUE(decompressed);
+    EXPECT_EQ(*decompressed, encoded);
+
+    // a body inflating past the size of the page is not trusted
+    EXPECT_FALSE(CacheTransfer::decompress(compressed, encoded.size() - 1));
+}
+
+TEST(CacheTransferTest, TargetRoundTrip)
+{
+    CacheTransfer::Request request;
+    request.ledgerIndex = 123;
+    request.limit = 1000;
+    request.marker = ripple::uint256{1};
+    request.end = ripple::uint256{2};
+    request.compress = true;
+
+    auto const parsed =
+        CacheTransfer::parseTarget(CacheTransfer::makeTarget(request));
+    ASSERT_TRUE(parsed);
+    EXPECT_EQ(parsed->ledgerIndex, 123);
+    EXPECT_EQ(parsed->limit, 1000);
+    EXPECT_EQ(parsed->marker, request.marker);
+    EXPECT_EQ(parsed->end, request.end);
+    EXPECT_FALSE(parsed->diff);
+    EXPECT_TRUE(parsed->compress);
+
+    EXPECT_FALSE(CacheTransfer::parseTarget("/"));
+    EXPECT_FALSE(CacheTransfer::parseTarget("/cache_transfer?limit=10"));
+}
+
+namespace {
+
+// the cache treats the zero key as the start of the state map and empty blobs
+// as deletions, so leave the first object out
+std::vector<Backend::LedgerObject>
+makeStateObjects()
+{
+    auto objects = makeObjects();
+    objects.erase(objects.begin());
+    return objects;
+}
+
+}  // namespace
+
+class CacheTransferServeTest : public HandlerBaseTest
+{
+protected:
+    // Serve one page over a loopback connection and request it like a peer
+    std::optional<CacheTransfer::Page>
+    transfer(CacheTransfer::Request const& request)
+    {
+        namespace http = boost::beast::http;
+        using tcp = boost::asio::ip::tcp;
+
+        tcp::acceptor acceptor{
+            ctx, {boost::asio::ip::make_address("127.0.0.1"), 0}};
+        auto const endpoint = acceptor.local_endpoint();
+        std::optional<CacheTransfer::Page> page;
+
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            boost::beast::tcp_stream stream{acceptor.async_accept(yield)};
+            boost::beast::flat_buffer buffer;
+            http::request<http::string_body> req;
+            http::async_read(stream, buffer, req, yield);
+
+            auto const parsed = CacheTransfer::parseTarget(
+                std::string_view{req.target().data(), req.target().size()});
+            ASSERT_TRUE(parsed);
+            auto const served =
+                CacheTransfer::fetchPage(*mockBackendPtr, *parsed, yield);
+            auto res = CacheTransfer::makeResponse(
+                served, parsed->compress, req.version());
+            if (tamper)
+            {
+                tamper(res);
+                res.prepare_payload();
+            }
+            http::async_write(stream, res, yield);
+        });
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            boost::beast::tcp_stream stream{ctx};
+            stream.async_connect(endpoint, yield);
+            page = CacheTransfer::requestPage(
+                stream, "127.0.0.1", request, yield);
+        });
+        ctx.run();
+        return page;
+    }
+
+    // changes the served response before it is sent, to act as a peer
+    // misbehaving
+    std::function<void(
+        boost::beast::http::response<boost::beast::http::string_body>&)>
+        tamper;
+
+    void
+    loadCache(std::uint32_t seq)
+    {
+        mockBackendPtr->cache().update(makeStateObjects(), seq, false);
+        mockBackendPtr->cache().setFull();
+    }
+};
+
+TEST_F(CacheTransferServeTest, ServesWholeRange)
+{
+    mockBackendPtr->updateRange(10);
+    mockBackendPtr->updateRange(30);
+    loadCache(30);
+
+    CacheTransfer::Request request;
+    request.ledgerIndex = 30;
+    request.compress = true;
+    auto const page = transfer(request);
+
+    ASSERT_TRUE(page);
+    EXPECT_EQ(page->status, boost::beast::http::status::ok);
+    EXPECT_EQ(page->maxSequence, 30);
+    EXPECT_FALSE(page->marker);
+    auto const objects = makeStateObjects();
+    ASSERT_EQ(page->objects.size(), objects.size());
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        EXPECT_EQ(page->objects[i].key, objects[i].key);
+        EXPECT_EQ(page->objects[i].blob, objects[i].blob);
+    }
+}
+
+TEST_F(CacheTransferServeTest, ServesPageWithinRange)
+{
+    mockBackendPtr->updateRange(10);
+    mockBackendPtr->updateRange(30);
+    loadCache(30);
+
+    auto const objects = makeStateObjects();
+    CacheTransfer::Request request;
+    request.ledgerIndex = 30;
+    request.marker = objects[1].key;
+    request.end = objects[10].key;
+    request.limit = 4;
+    auto const page = transfer(request);
+
+    ASSERT_TRUE(page);
+    EXPECT_EQ(page->status, boost::beast::http::status::ok);
+    ASSERT_EQ(page->objects.size(), 4);
+    EXPECT_EQ(page->objects.front().key, objects[2].key);
+    EXPECT_EQ(page->marker, objects[5].key);
+}
+
+TEST_F(CacheTransferServeTest, LaggingCacheIsNotServed)
+{
+    // the range moved on before the cache did. Walking the state map now
+    // would fall back to the successor table and end the range early
+    mockBackendPtr->updateRange(10);
+    mockBackendPtr->updateRange(30);
+    loadCache(29);
+
+    CacheTransfer::Request request;
+    request.ledgerIndex = 29;
+    request.marker = makeStateObjects()[3].key;
+    auto const page = transfer(request);
+
+    ASSERT_TRUE(page);
+    EXPECT_EQ(
+        page->status, boost::beast::http::status::service_unavailable);
+    EXPECT_EQ(page->error, "cacheNotCurrent");
+    EXPECT_TRUE(page->objects.empty());
+}
+
+TEST_F(CacheTransferServeTest, OversizedPageIsRejected)
+{
+    mockBackendPtr->updateRange(10);
+    mockBackendPtr->updateRange(30);
+    loadCache(30);
+
+    CacheTransfer::Request request;
+    request.ledgerIndex = 30;
+    request.limit = 2;
+    tamper = [&](auto& res) {
+        res.body().resize(CacheTransfer::maxPageSize(request.limit) + 1);
+    };
+    EXPECT_FALSE(transfer(request));
+}
+
+TEST_F(CacheTransferServeTest, OversizedInflatedPageIsRejected)
+{
+    mockBackendPtr->updateRange(10);
+    mockBackendPtr->updateRange(30);
+    loadCache(30);
+
+    CacheTransfer::Request request;
+    request.ledgerIndex = 30;
+    request.limit = 2;
+    request.compress = true;
+    // zeroes deflate to a body far smaller than the limit
+    tamper = [&](auto& res) {
+        res.body() = CacheTransfer::compress(
+            std::string(CacheTransfer::maxPageSize(request.limit) + 1, 0));
+    };
+    EXPECT_FALSE(transfer(request));
+}
@@ -25,6 +25,15 @@
 #include <boost/json/parse.hpp>
 #include <gmock/gmock.h>
 
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 using namespace testing;
 using namespace clio;
 using namespace std;
@@ -54,6 +63,18 @@ constexpr static auto JSONData2 = R"JSON(
     }
 )JSON";
 
+constexpr static auto JSONDataCost = R"JSON(
+    {
+        "dos_guard": {
+            "max_fetches": 100,
+            "max_connections": 2,
+            "max_cost": 10,
+            "cost_per_second": 0.001,
+            "whitelist": ["127.0.0.1"]
+        }
+    }
+)JSON";
+
 constexpr static auto IP = "127.0.0.2";
 
 class FakeSweepHandler
@@ -151,6 +172,97 @@ TEST_F(DOSGuardTest, RequestLimitOnTimer)
     EXPECT_TRUE(guard.isOk(IP));  // can request again
 }
 
+TEST_F(DOSGuardTest, AddressForms)
+{
+    // the same client whether seen over IPv4 or as an IPv4 mapped address
+    EXPECT_TRUE(guard.request(IP));
+    EXPECT_TRUE(guard.request("::ffff:127.0.0.2"));
+    EXPECT_TRUE(guard.request(IP));
+    EXPECT_FALSE(guard.request("::ffff:127.0.0.2"));
+    EXPECT_TRUE(guard.isWhiteListed("::ffff:127.0.0.1"));
+
+    EXPECT_TRUE(guard.request("::1"));
+    EXPECT_TRUE(guard.request("not an address"));
+    EXPECT_FALSE(guard.isOk(IP));
+    EXPECT_FALSE(guard.isWhiteListed("127.0.0.256"));
+}
+
+TEST_F(DOSGuardTest, CostDisabledByDefault)
+{
+    EXPECT_TRUE(guard.charge(IP, 1000000));
+    EXPECT_TRUE(guard.isOk(IP));
+}
+
+TEST_F(DOSGuardTest, BatchRequestsPerCharge)
+{
+    EXPECT_EQ(guard.batchRequestsPerCharge(), 1);
+
+    FakeSweepHandler handler;
+    Config const discount{json::parse(R"JSON(
+        {"dos_guard": {"batch_requests_per_charge": 4}}
+    )JSON")};
+    EXPECT_EQ(
+        (BasicDOSGuard<FakeSweepHandler>{discount, handler})
+            .batchRequestsPerCharge(),
+        4);
+
+    Config const zero{json::parse(R"JSON(
+        {"dos_guard": {"batch_requests_per_charge": 0}}
+    )JSON")};
+    EXPECT_THROW(
+        (BasicDOSGuard<FakeSweepHandler>{zero, handler}), std::runtime_error);
+}
+
+class DOSGuardCostTest : public NoLoggerFixture
+{
+protected:
+    Config cfg{json::parse(JSONDataCost)};
+    FakeSweepHandler sweepHandler;
+    BasicDOSGuard<FakeSweepHandler> guard{cfg, sweepHandler};
+};
+
+TEST_F(DOSGuardCostTest, ChargeWithinBudget)
+{
+    EXPECT_TRUE(guard.charge(IP, 4));
+    EXPECT_TRUE(guard.charge(IP, 4));
+    EXPECT_TRUE(guard.isOk(IP));
+    EXPECT_FALSE(guard.charge(IP, 4));  // in debt
+    EXPECT_FALSE(guard.isOk(IP));
+    EXPECT_FALSE(guard.request(IP));
+
+    EXPECT_TRUE(guard.isOk("127.0.0.3"));  // other clients unaffected
+}
+
+TEST_F(DOSGuardCostTest, WhitelistedIsNotCharged)
+{
+    EXPECT_TRUE(guard.charge("127.0.0.1", 1000));
+    EXPECT_TRUE(guard.isOk("127.0.0.1"));
+}
+
+TEST_F(DOSGuardCostTest, ClearKeepsDebt)
+{
+    EXPECT_FALSE(guard.charge(IP, 20));
+    guard.clear();
+    EXPECT_FALSE(guard.isOk(IP));  // debt is only repaid over time
+}
+
+TEST_F(DOSGuardCostTest, CostNeedsRefill)
+{
+    FakeSweepHandler handler;
+    Config const noRefill{json::parse(R"JSON(
+        {"dos_guard": {"max_cost": 10, "cost_per_second": 0}}
+    )JSON")};
+    EXPECT_THROW(
+        (BasicDOSGuard<FakeSweepHandler>{noRefill, handler}),
+        std::runtime_error);
+
+    // without cost accounting there is nothing to refill
+    Config const noCost{json::parse(R"JSON(
+        {"dos_guard": {"max_cost": 0, "cost_per_second": 0}}
+    )JSON")};
+    EXPECT_NO_THROW((BasicDOSGuard<FakeSweepHandler>{noCost, handler}));
+}
+
 template <typename SweepHandler>
 struct BasicDOSGuardMock : public BaseDOSGuard
 {
@@ -175,3 +287,92 @@ TEST_F(DOSGuardIntervalSweepHandlerTest, SweepAfterInterval)
     EXPECT_CALL(guard, clear()).Times(AtLeast(2));
     ctx.run_for(std::chrono::milliseconds(300));
 }
+
+namespace {
+
+// request() as it was before sharding: string keys, and one global lock
+// taken to count the request and again to check the limits. Kept as the
+// baseline for the benchmark below
+class SingleLockGuard
+{
+    static constexpr std::uint32_t maxRequests = 4000000000u;
+
+    std::mutex mtx_;
+    std::unordered_map<std::string, std::uint32_t> requests_;
+    std::unordered_map<std::string, std::uint32_t> connections_;
+    std::unordered_set<std::string> const whitelist_{"127.0.0.1"};
+
+public:
+    bool
+    request(std::string const& ip)
+    {
+        if (whitelist_.contains(ip))
+            return true;
+
+        {
+            std::scoped_lock lck(mtx_);
+            requests_[ip]++;
+        }
+
+        std::scoped_lock lck(mtx_);
+        if (auto it = requests_.find(ip);
+            it != requests_.end() && it->second > maxRequests)
+            return false;
+        return !connections_.contains(ip);
+    }
+};
+
+template <typename Guard>
+double
+requestsPerSecond(Guard& guard, std::size_t numThreads)
+{
+    static constexpr auto requestsPerThread = 200000;
+
+    std::vector<std::string> ips;
+    for (std::size_t i = 0; i < numThreads; ++i)
+        ips.push_back("10.0." + std::to_string(i / 256) + "." +
+                      std::to_string(i % 256));
+
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back([&guard, &ip = ips[i]]() {
+            for (auto n = 0; n < requestsPerThread; ++n)
+                guard.request(ip);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    std::chrono::duration<double> const elapsed =
+        std::chrono::steady_clock::now() - start;
+    return numThreads * requestsPerThread / elapsed.count();
+}
+
+}  // namespace
+
+// Throughput of request() with one client per thread, against a single lock.
+// Run with --gtest_also_run_disabled_tests
+TEST_F(DOSGuardTest, DISABLED_ContentionBenchmark)
+{
+    auto const maxThreads =
+        std::max(1u, std::thread::hardware_concurrency());
+    for (auto numThreads = 1u; numThreads <= maxThreads; numThreads *= 2)
+    {
+        // high enough that no client is ever limited
+        Config const benchmarkCfg{json::parse(
+            R"({"dos_guard": {"max_requests": 4000000000}})")};
+        FakeSweepHandler handler;
+        BasicDOSGuard<FakeSweepHandler> sharded{benchmarkCfg, handler};
+        SingleLockGuard single;
+
+        std::cout << numThreads << " threads: sharded "
+                  << static_cast<std::uint64_t>(
+                         requestsPerSecond(sharded, numThreads))
+                  << " req/s, single lock "
+                  << static_cast<std::uint64_t>(
+                         requestsPerSecond(single, numThreads))
+                  << " req/s" << std::endl;
+    }
+}
@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+#include <util/TestObject.h>
+
+#include <ripple/protocol/Indexes.h>
+#include <ripple/protocol/Protocol.h>
+#include <backend/DirectoryPrefetcher.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace Backend;
+using namespace testing;
+
+constexpr static auto ROOT =
+    "1B8590C01B0006EDFA9ED60296DD052DC5E90F99659B25014D08E1BC983515BC";
+constexpr static auto INDEX1 =
+    "E6DBAFC99223B42257915A63DFC6B0C032D4070F9A574B255AD97466726FC321";
+constexpr static std::uint32_t SEQ = 30;
+
+using Reads = std::vector<std::vector<std::uint64_t>>;
+
+class DirectoryPrefetcherTest : public HandlerBaseTest
+{
+protected:
+    // page number -> blob, the pages in the database
+    std::map<std::uint64_t, Blob> pages;
+    // the page numbers of every read that went to the database
+    Reads reads;
+
+    void
+    SetUp() override
+    {
+        MockBackendTest::SetUp();
+        auto* rawBackendPtr = static_cast<MockBackend*>(mockBackendPtr.get());
+        ON_CALL(*rawBackendPtr, doFetchLedgerObject)
+            .WillByDefault(Invoke(
+                [this](
+                    ripple::uint256 const& key,
+                    std::uint32_t,
+                    boost::asio::yield_context&) -> std::optional<Blob> {
+                    auto const page = pageOf(key);
+                    reads.push_back({page});
+                    if (auto it = pages.find(page); it != pages.end())
+                        return it->second;
+                    return {};
+                }));
+        ON_CALL(*rawBackendPtr, doFetchLedgerObjects)
+            .WillByDefault(Invoke(
+                [this](
+                    std::vector<ripple::uint256> const& keys,
+                    std::uint32_t,
+                    boost::asio::yield_context&) {
+                    std::vector<Blob> blobs;
+                    reads.emplace_back();
+                    for (auto const& key : keys)
+                    {
+                        auto const page = pageOf(key);
+                        reads.back().push_back(page);
+                        auto it = pages.find(page);
+                        blobs.push_back(
+                            it != pages.end() ? it->second : Blob{});
+                    }
+                    return blobs;
+                }));
+    }
+
+    // Store the pages 0 to lastPage of a directory, except the missing ones
+    void
+    makeDirectory(
+        std::uint64_t lastPage,
+        std::set<std::uint64_t> const& missing = {})
+    {
+        for (std::uint64_t page = 0; page <= lastPage; ++page)
+        {
+            if (missing.contains(page))
+                continue;
+            auto dir =
+                CreateOwnerDirLedgerObject({ripple::uint256{INDEX1}}, ROOT);
+            if (page == 0)
+                dir.setFieldU64(ripple::sfIndexPrevious, lastPage);
+            if (page != lastPage)
+                dir.setFieldU64(ripple::sfIndexNext, page + 1);
+            pages[page] = dir.getSerializer().peekData();
+        }
+    }
+
+    static std::uint64_t
+    pageOf(ripple::uint256 const& key)
+    {
+        for (std::uint64_t page = 0; page < 64; ++page)
+        {
+            if (ripple::keylet::page(ripple::uint256{ROOT}, page).key == key)
+                return page;
+        }
+        ADD_FAILURE() << "Read a key outside of the directory";
+        return 0;
+    }
+
+    std::optional<ripple::SLE>
+    fetchPage(
+        DirectoryPrefetcher& prefetcher,
+        std::uint64_t page,
+        std::size_t entriesWanted)
+    {
+        std::optional<ripple::SLE> sle;
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            sle = prefetcher.fetchPage(page, entriesWanted, yield);
+        });
+        ctx.run();
+        ctx.restart();
+        return sle;
+    }
+};
+
+TEST_F(DirectoryPrefetcherTest, SinglePageDirectory)
+{
+    makeDirectory(0);
+    DirectoryPrefetcher prefetcher{*mockBackendPtr, ripple::uint256{ROOT}, SEQ};
+
+    auto const root = fetchPage(prefetcher, 0, 1000);
+    ASSERT_TRUE(root);
+    EXPECT_FALSE(root->isFieldPresent(ripple::sfIndexNext));
+    // the root page is read alone, most directories have a single page
+    EXPECT_EQ(reads, (Reads{{0}}));
+}
+
+TEST_F(DirectoryPrefetcherTest, WindowBoundedByLastPage)
+{
+    makeDirectory(3);
+    DirectoryPrefetcher prefetcher{*mockBackendPtr, ripple::uint256{ROOT}, SEQ};
+
+    for (std::uint64_t page = 0; page <= 3; ++page)
+        EXPECT_TRUE(fetchPage(prefetcher, page, 1000));
+
+    // nothing past sfIndexPrevious of the root page is read
+    EXPECT_EQ(reads, (Reads{{0}, {1, 2, 3}}));
+}
+
+TEST_F(DirectoryPrefetcherTest, WindowBoundedByEntriesWanted)
+{
+    makeDirectory(20);
+    DirectoryPrefetcher prefetcher{*mockBackendPtr, ripple::uint256{ROOT}, SEQ};
+
+    EXPECT_TRUE(fetchPage(prefetcher, 0, 1000));
+    // two pages hold the entries the walk still needs
+    EXPECT_TRUE(fetchPage(prefetcher, 1, ripple::dirNodeMaxEntries + 1));
+    EXPECT_TRUE(fetchPage(prefetcher, 2, 1));
+    // and never more than maxWindow pages are read at once
+    EXPECT_TRUE(fetchPage(prefetcher, 3, 1000));
+
+    EXPECT_EQ(reads, (Reads{{0}, {1, 2}, {3, 4, 5, 6, 7, 8, 9, 10}}));
+}
+
+TEST_F(DirectoryPrefetcherTest, MissPartwayThroughWindow)
+{
+    makeDirectory(5, {3});
+    DirectoryPrefetcher prefetcher{*mockBackendPtr, ripple::uint256{ROOT}, SEQ};
+
+    EXPECT_TRUE(fetchPage(prefetcher, 0, 1000));
+    EXPECT_TRUE(fetchPage(prefetcher, 1, 1000));
+    EXPECT_TRUE(fetchPage(prefetcher, 2, 1000));
+    // the missing page is read once more before it is reported missing
+    EXPECT_FALSE(fetchPage(prefetcher, 3, 1000));
+    // the pages after it are still served from the buffer
+    EXPECT_TRUE(fetchPage(prefetcher, 4, 1000));
+    EXPECT_TRUE(fetchPage(prefetcher, 5, 1000));
+
+    EXPECT_EQ(reads, (Reads{{0}, {1, 2, 3, 4, 5}, {3, 4, 5}}));
+}
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <etl/ETLMetrics.h>
+
+#include <gtest/gtest.h>
+
+using Stage = ETLMetrics::Stage;
+using us = ETLMetrics::Duration;
+
+TEST(ETLMetricsTest, Percentiles)
+{
+    ETLMetrics metrics;
+    for (std::uint32_t i = 1; i <= 100; ++i)
+        metrics.record(Stage::extract, i, us{i});
+
+    auto const report = metrics.report();
+    auto const& extract =
+        report.at("stages").as_object().at("extract").as_object();
+    EXPECT_EQ(extract.at("count").as_uint64(), 100);
+    EXPECT_EQ(extract.at("p50_us").as_int64(), 51);
+    EXPECT_EQ(extract.at("p99_us").as_int64(), 100);
+    EXPECT_EQ(extract.at("max_us").as_int64(), 100);
+}
+
+TEST(ETLMetricsTest, WindowKeepsRecentSamples)
+{
+    ETLMetrics metrics{10};
+    metrics.record(Stage::write, 1, us{1000});
+    for (std::uint32_t i = 2; i <= 11; ++i)
+        metrics.record(Stage::write, i, us{1});
+
+    auto const report = metrics.report();
+    auto const& write = report.at("stages").as_object().at("write").as_object();
+    EXPECT_EQ(write.at("window").as_uint64(), 10);
+    EXPECT_EQ(write.at("p99_us").as_int64(), 1);
+    // max is over every sample
+    EXPECT_EQ(write.at("max_us").as_int64(), 1000);
+}
+
+TEST(ETLMetricsTest, SlowestLedgers)
+{
+    ETLMetrics metrics{1024, 2};
+    for (std::uint32_t seq = 1; seq <= 5; ++seq)
+    {
+        metrics.record(Stage::extract, seq, us{seq * 10});
+        metrics.record(Stage::publish, seq, us{seq});
+        metrics.recordSize(seq, seq, 2 * seq);
+        metrics.finishLedger(seq);
+    }
+
+    auto const report = metrics.report();
+    auto const& slowest = report.at("slowest_ledgers").as_array();
+    ASSERT_EQ(slowest.size(), 2);
+    auto const& first = slowest.at(0).as_object();
+    EXPECT_EQ(first.at("ledger_index").as_uint64(), 5);
+    EXPECT_EQ(first.at("total_us").as_int64(), 55);
+    EXPECT_EQ(first.at("extract_us").as_int64(), 50);
+    EXPECT_EQ(first.at("objects").as_uint64(), 10);
+    EXPECT_EQ(slowest.at(1).as_object().at("ledger_index").as_uint64(), 4);
+}
+
+TEST(ETLMetricsTest, QueueDepths)
+{
+    ETLMetrics metrics;
+    metrics.setQueueDepth("extract_0", 3);
+    metrics.setQueueDepth("extract_0", 1);
+
+    auto const report = metrics.report();
+    EXPECT_EQ(
+        report.at("queue_depths").as_object().at("extract_0").as_uint64(), 1);
+}
@@ -0,0 +1,356 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+
+#include <etl/CacheTransfer.h>
+#include <webserver/Listener.h>
+
+#include <boost/asio/spawn.hpp>
+#include <boost/json/parse.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+namespace json = boost::json;
+
+class HttpBatchTest : public SyncAsioContextTest
+{
+protected:
+    clio::Logger log{"WebServer"};
+
+    // Run handle_batch to completion on the context
+    template <class Handle, class Admit>
+    json::value
+    runBatch(json::array const& batch, Handle&& handle, Admit&& admit)
+    {
+        json::value response;
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            response = handle_batch(yield, ctx, batch, admit, handle, log);
+        });
+        ctx.run();
+        return response;
+    }
+
+    template <class Handle>
+    json::value
+    runBatch(json::array const& batch, Handle&& handle)
+    {
+        return runBatch(batch, handle, [](std::size_t) { return true; });
+    }
+};
+
+TEST_F(HttpBatchTest, ResponsesInRequestOrder)
+{
+    constexpr std::size_t numRequests = 8;
+    json::array batch;
+    for (std::size_t i = 0; i < numRequests; ++i)
+        batch.push_back(json::object{{"id", i}});
+
+    // the first requests take the longest, so they complete last
+    std::vector<std::size_t> completed;
+    auto const response = runBatch(
+        batch,
+        [&](boost::asio::yield_context& yield, json::object const& request) {
+            auto const id = request.at("id").as_uint64();
+            boost::asio::steady_timer timer{
+                ctx, std::chrono::milliseconds(5 * (numRequests - id))};
+            timer.async_wait(yield);
+            completed.push_back(id);
+            return json::object{{"id", id}};
+        });
+
+    EXPECT_EQ(completed.front(), numRequests - 1);
+    ASSERT_TRUE(response.is_array());
+    ASSERT_EQ(response.as_array().size(), numRequests);
+    for (std::size_t i = 0; i < numRequests; ++i)
+        EXPECT_EQ(response.as_array()[i], (json::object{{"id", i}}));
+}
+
+TEST_F(HttpBatchTest, ErrorsStayInTheirSlot)
+{
+    auto const batch = json::parse(R"([
+        {"id": 0},
+        42,
+        {"id": 2, "throw": true},
+        {"id": 3}
+    ])");
+
+    auto const response = runBatch(
+        batch.as_array(),
+        [](boost::asio::yield_context&, json::object const& request) {
+            if (request.contains("throw"))
+                throw std::runtime_error("failed");
+            return json::object{{"id", request.at("id")}};
+        });
+
+    ASSERT_TRUE(response.is_array());
+    auto const& responses = response.as_array();
+    ASSERT_EQ(responses.size(), 4);
+    EXPECT_EQ(responses[0], (json::object{{"id", 0}}));
+    EXPECT_EQ(
+        responses[1], RPC::makeError(RPC::RippledError::rpcBAD_SYNTAX));
+    EXPECT_EQ(responses[2], RPC::makeError(RPC::RippledError::rpcINTERNAL));
+    EXPECT_EQ(responses[3], (json::object{{"id", 3}}));
+}
+
+TEST_F(HttpBatchTest, SizeLimits)
+{
+    std::size_t numHandled = 0;
+    auto const handle = [&](boost::asio::yield_context&,
+                            json::object const&) {
+        ++numHandled;
+        return json::object{};
+    };
+
+    auto response = runBatch(json::array{}, handle);
+    ASSERT_TRUE(response.is_object());
+    EXPECT_EQ(response.at("error").as_string(), "badSyntax");
+
+    json::array batch(maxBatchSize, json::object{});
+    ctx.restart();
+    response = runBatch(batch, handle);
+    ASSERT_TRUE(response.is_array());
+    EXPECT_EQ(response.as_array().size(), maxBatchSize);
+    EXPECT_EQ(numHandled, maxBatchSize);
+
+    batch.push_back(json::object{});
+    ctx.restart();
+    response = runBatch(batch, handle);
+    ASSERT_TRUE(response.is_object());
+    EXPECT_EQ(response.at("error").as_string(), "badSyntax");
+    EXPECT_EQ(numHandled, maxBatchSize);
+}
+
+TEST_F(HttpBatchTest, SlowDownOnceRefused)
+{
+    json::array batch(5, json::object{});
+    std::size_t numHandled = 0;
+    auto const handle = [&](boost::asio::yield_context&,
+                            json::object const&) {
+        ++numHandled;
+        return json::object{};
+    };
+
+    // refused requests don't run, and admission stops at the first refusal
+    std::vector<std::size_t> asked;
+    auto response = runBatch(batch, handle, [&](std::size_t i) {
+        asked.push_back(i);
+        return i != 2 && i != 4;
+    });
+    EXPECT_EQ(asked, (std::vector<std::size_t>{0, 1, 2}));
+    EXPECT_EQ(numHandled, 2);
+    ASSERT_TRUE(response.is_array());
+    auto const slowDown = RPC::makeError(RPC::RippledError::rpcSLOW_DOWN);
+    for (std::size_t i = 0; i < batch.size(); ++i)
+        EXPECT_EQ(response.as_array()[i] == slowDown, i >= 2);
+
+    // nothing runs when the first request is refused
+    ctx.restart();
+    response = runBatch(batch, handle, [](std::size_t) { return false; });
+    EXPECT_EQ(numHandled, 2);
+    ASSERT_TRUE(response.is_array());
+    for (auto const& entry : response.as_array())
+        EXPECT_EQ(entry, slowDown);
+}
+
+TEST_F(HttpBatchTest, ChargeEveryRequest)
+{
+    constexpr auto ip = "127.0.0.2";
+    boost::asio::io_context sweepCtx;
+    auto const slowDown = RPC::makeError(RPC::RippledError::rpcSLOW_DOWN);
+    auto const handle = [](boost::asio::yield_context&, json::object const&) {
+        return json::object{};
+    };
+
+    for (auto const [perCharge, numAdmitted] :
+         {std::pair{1u, 3u}, std::pair{2u, 6u}})
+    {
+        clio::Config const cfg{json::object{
+            {"dos_guard",
+             json::object{
+                 {"max_requests", 3},
+                 {"batch_requests_per_charge", perCharge}}}}};
+        clio::IntervalSweepHandler sweepHandler{cfg, sweepCtx};
+        clio::DOSGuard dosGuard{cfg, sweepHandler};
+
+        // the first request was charged when the batch was read
+        ASSERT_TRUE(dosGuard.request(ip));
+        json::array batch(8, json::object{});
+        ctx.restart();
+        auto const response =
+            runBatch(batch, handle, chargeBatchRequests(dosGuard, ip));
+
+        ASSERT_TRUE(response.is_array());
+        for (std::size_t i = 0; i < batch.size(); ++i)
+            EXPECT_EQ(response.as_array()[i] == slowDown, i >= numAdmitted);
+    }
+}
+
+class HttpPipelineTest : public HandlerBaseTest
+{
+protected:
+    clio::Config cfg{json::parse(R"({
+        "dos_guard": {"whitelist": ["127.0.0.1"]}
+    })")};
+    // never run, so that ctx runs out of work once the session is closed
+    boost::asio::io_context sweepCtx;
+    clio::IntervalSweepHandler sweepHandler{cfg, sweepCtx};
+    clio::DOSGuard dosGuard{cfg, sweepHandler};
+    util::TagDecoratorFactory tagFactory{cfg};
+    WorkQueue queue{4};
+    RPC::Counters counters{queue};
+
+    // Accept one connection on the loopback and serve it with an HttpSession
+    tcp::endpoint
+    listen(std::chrono::steady_clock::duration timeout = 30s)
+    {
+        acceptor_.open(tcp::v4());
+        acceptor_.bind({boost::asio::ip::make_address("127.0.0.1"), 0});
+        acceptor_.listen();
+        acceptor_.async_accept(
+            [this, timeout](boost::beast::error_code ec, tcp::socket socket) {
+                if (ec)
+                    return;
+                auto session = std::make_shared<HttpSession>(
+                    ctx,
+                    std::move(socket),
+                    mockBackendPtr,
+                    nullptr,
+                    nullptr,
+                    nullptr,
+                    tagFactory,
+                    dosGuard,
+                    counters,
+                    queue,
+                    boost::beast::flat_buffer{});
+                session->setTimeout(timeout);
+                session->run();
+            });
+        return acceptor_.local_endpoint();
+    }
+
+private:
+    tcp::acceptor acceptor_{ctx};
+};
+
+TEST_F(HttpPipelineTest, ResponsesInRequestOrder)
+{
+    Backend::LedgerObject object;
+    object.key.data()[0] = 1;
+    object.blob = Backend::Blob(10, 1);
+    mockBackendPtr->updateRange(30);
+    mockBackendPtr->cache().update({object}, 30, false);
+    mockBackendPtr->cache().setFull();
+
+    // the first request is still being handled when the others complete
+    auto const rawBackendPtr = static_cast<MockBackend*>(mockBackendPtr.get());
+    EXPECT_CALL(*rawBackendPtr, fetchLedgerDiff)
+        .WillOnce([](std::uint32_t, boost::asio::yield_context&) {
+            std::this_thread::sleep_for(200ms);
+            return std::vector<Backend::LedgerObject>{};
+        });
+
+    CacheTransfer::Request transfer;
+    transfer.ledgerIndex = 30;
+    transfer.diff = 30;
+
+    constexpr std::size_t numRequests = 5;
+    tcp::socket socket{ctx};
+    socket.connect(listen());
+    std::thread runner{[this] { ctx.run(); }};
+    for (std::size_t i = 0; i < numRequests; ++i)
+    {
+        http::request<http::string_body> req{
+            http::verb::get,
+            i == 0 ? CacheTransfer::makeTarget(transfer) : "/",
+            11};
+        req.set(http::field::host, "127.0.0.1");
+        req.keep_alive(i + 1 < numRequests);
+        http::write(socket, req);
+    }
+
+    boost::beast::flat_buffer buffer;
+    for (std::size_t i = 0; i < numRequests; ++i)
+    {
+        http::response<http::string_body> res;
+        http::read(socket, buffer, res);
+        EXPECT_EQ(res.result(), http::status::ok);
+        if (i == 0)
+            EXPECT_EQ(
+                res[http::field::content_type], "application/octet-stream");
+        else
+            EXPECT_EQ(res.body(), defaultResponse);
+    }
+
+    socket.close();
+    runner.join();
+}
+
+TEST_F(HttpPipelineTest, SlowHandlerOutlivesReadTimeout)
+{
+    Backend::LedgerObject object;
+    object.key.data()[0] = 1;
+    object.blob = Backend::Blob(10, 1);
+    mockBackendPtr->updateRange(30);
+    mockBackendPtr->cache().update({object}, 30, false);
+    mockBackendPtr->cache().setFull();
+
+    // the handler takes longer than the read timeout
+    auto const rawBackendPtr = static_cast<MockBackend*>(mockBackendPtr.get());
+    EXPECT_CALL(*rawBackendPtr, fetchLedgerDiff)
+        .WillOnce([](std::uint32_t, boost::asio::yield_context&) {
+            std::this_thread::sleep_for(500ms);
+            return std::vector<Backend::LedgerObject>{};
+        });
+
+    CacheTransfer::Request transfer;
+    transfer.ledgerIndex = 30;
+    transfer.diff = 30;
+
+    tcp::socket socket{ctx};
+    socket.connect(listen(100ms));
+    std::thread runner{[this] { ctx.run(); }};
+    http::request<http::string_body> req{
+        http::verb::get, CacheTransfer::makeTarget(transfer), 11};
+    req.set(http::field::host, "127.0.0.1");
+    http::write(socket, req);
+
+    boost::beast::flat_buffer buffer;
+    http::response<http::string_body> res;
+    http::read(socket, buffer, res);
+    EXPECT_EQ(res.result(), http::status::ok);
+    EXPECT_EQ(res[http::field::content_type], "application/octet-stream");
+
+    // once nothing is owed, an idle connection times out
+    auto const idleStart = std::chrono::steady_clock::now();
+    boost::beast::error_code ec;
+    http::response<http::string_body> none;
+    http::read(socket, buffer, none, ec);
+    EXPECT_TRUE(ec);
+    EXPECT_LT(std::chrono::steady_clock::now() - idleStart, 5s);
+
+    socket.close();
+    runner.join();
+}
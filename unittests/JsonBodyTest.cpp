@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <webserver/JsonBody.h>
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+
+namespace http = boost::beast::http;
+
+namespace {
+
+// Serialize the message the way http::async_write does, into a string
+template <class Body>
+std::string
+writeMessage(http::response<Body>& res)
+{
+    std::string out;
+    http::serializer<false, Body> sr{res};
+    boost::beast::error_code ec;
+    while (!ec && !sr.is_done())
+    {
+        sr.next(ec, [&](boost::beast::error_code& ec, auto const& buffers) {
+            ec = {};
+            out += boost::beast::buffers_to_string(buffers);
+            sr.consume(boost::beast::buffer_bytes(buffers));
+        });
+    }
+    EXPECT_FALSE(ec);
+    return out;
+}
+
+http::response<http::string_body>
+readMessage(std::string const& data)
+{
+    http::response_parser<http::string_body> parser;
+    parser.body_limit(boost::none);
+    boost::beast::error_code ec;
+    std::size_t offset = 0;
+    while (!ec && !parser.is_done() && offset < data.size())
+        offset += parser.put(
+            boost::asio::buffer(data.data() + offset, data.size() - offset),
+            ec);
+    EXPECT_FALSE(ec);
+    EXPECT_TRUE(parser.is_done());
+    return parser.release();
+}
+
+}  // namespace
+
+TEST(JsonBodyTest, SmallValue)
+{
+    boost::json::value const json = {{"status", "success"}, {"ledger", 42}};
+
+    std::optional<std::size_t> serialized;
+    http::response<JsonBody> res{http::status::ok, 11};
+    res.body().json = json;
+    res.body().onSerialized = [&](std::size_t size) { serialized = size; };
+    res.prepare_payload();
+    EXPECT_TRUE(res.chunked());
+
+    auto const written = readMessage(writeMessage(res));
+    EXPECT_EQ(written.body(), boost::json::serialize(json));
+    ASSERT_TRUE(serialized);
+    EXPECT_EQ(*serialized, written.body().size());
+}
+
+TEST(JsonBodyTest, ValueLargerThanChunk)
+{
+    boost::json::array objects;
+    while (boost::json::serialize(objects).size() < 4 * JsonBody::chunkSize)
+        objects.push_back(
+            {{"index", objects.size()}, {"data", std::string(100, 'A')}});
+    boost::json::value const json = {{"state", std::move(objects)}};
+
+    std::optional<std::size_t> serialized;
+    http::response<JsonBody> res{http::status::ok, 11};
+    res.body().json = json;
+    res.body().onSerialized = [&](std::size_t size) { serialized = size; };
+    res.prepare_payload();
+
+    auto const data = writeMessage(res);
+    auto const written = readMessage(data);
+    EXPECT_EQ(written.body(), boost::json::serialize(json));
+    EXPECT_EQ(boost::json::parse(written.body()), json);
+    ASSERT_TRUE(serialized);
+    EXPECT_EQ(*serialized, written.body().size());
+
+    // sent in chunks, their framing is on the wire too
+    auto const headerSize = data.find("\r\n\r\n") + 4;
+    EXPECT_GT(data.size() - headerSize, written.body().size());
+}
+
+TEST(JsonBodyTest, WriteCutShort)
+{
+    boost::json::array objects;
+    while (boost::json::serialize(objects).size() < 4 * JsonBody::chunkSize)
+        objects.push_back(
+            {{"index", objects.size()}, {"data", std::string(100, 'A')}});
+    boost::json::value const json = {{"state", std::move(objects)}};
+
+    std::optional<std::size_t> serialized;
+    http::response<JsonBody> res{http::status::ok, 11};
+    res.body().json = json;
+    res.body().onSerialized = [&](std::size_t size) { serialized = size; };
+    res.prepare_payload();
+
+    {
+        // the client goes away after the first chunk
+        http::serializer<false, JsonBody> sr{res};
+        boost::beast::error_code ec;
+        std::size_t written = 0;
+        while (!ec && written < JsonBody::chunkSize)
+        {
+            sr.next(ec, [&](boost::beast::error_code& ec, auto const& buffers) {
+                ec = {};
+                written += boost::beast::buffer_bytes(buffers);
+                sr.consume(boost::beast::buffer_bytes(buffers));
+            });
+        }
+        EXPECT_FALSE(ec);
+        EXPECT_FALSE(serialized);
+    }
+
+    // the bytes serialized so far are reported anyway
+    ASSERT_TRUE(serialized);
+    EXPECT_GE(*serialized, JsonBody::chunkSize);
+    EXPECT_LT(*serialized, boost::json::serialize(json).size());
+}
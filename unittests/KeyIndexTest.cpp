@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <backend/KeyIndex.h>
+
+#include <gtest/gtest.h>
+
+using namespace Backend;
+
+namespace {
+
+LedgerObject
+object(std::uint32_t key, bool deleted = false)
+{
+    return {ripple::uint256{key}, deleted ? Blob{} : Blob{'a', 'b', 'c'}};
+}
+
+}  // namespace
+
+TEST(KeyIndexTest, SuccessorsOnlyWhenFull)
+{
+    KeyIndex index;
+    index.update({object(1), object(3)}, 1);
+    EXPECT_FALSE(index.successor(ripple::uint256{1}, 1));
+
+    index.setFull();
+    EXPECT_EQ(index.successor(ripple::uint256{1}, 1), ripple::uint256{3});
+    EXPECT_EQ(index.predecessor(ripple::uint256{3}, 1), ripple::uint256{1});
+    EXPECT_FALSE(index.successor(ripple::uint256{3}, 1));
+    EXPECT_FALSE(index.predecessor(ripple::uint256{1}, 1));
+    // only the most recent ledger is indexed
+    EXPECT_FALSE(index.successor(ripple::uint256{1}, 2));
+}
+
+TEST(KeyIndexTest, Update)
+{
+    KeyIndex index;
+    index.update({object(1), object(3)}, 1);
+    index.setFull();
+    index.update({object(2), object(3, true)}, 2);
+
+    EXPECT_EQ(index.latestLedgerSequence(), 2);
+    EXPECT_EQ(index.size(), 2);
+    EXPECT_EQ(index.successor(ripple::uint256{1}, 2), ripple::uint256{2});
+    EXPECT_FALSE(index.successor(ripple::uint256{2}, 2));
+    EXPECT_EQ(index.isBookDir(ripple::uint256{2}), false);
+    EXPECT_FALSE(index.isBookDir(ripple::uint256{3}));
+}
+
+TEST(KeyIndexTest, BackgroundLoadSkipsDeletedKeys)
+{
+    KeyIndex index;
+    // ledger 2 deletes key 3 while ledger 1 is still being loaded
+    index.update({object(3, true)}, 2);
+    index.update({object(1), object(3)}, 1, true);
+    index.setFull();
+
+    EXPECT_EQ(index.size(), 1);
+    EXPECT_FALSE(index.successor(ripple::uint256{1}, 2));
+}
+
+TEST(KeyIndexTest, Disabled)
+{
+    KeyIndex index;
+    index.setDisabled();
+    index.update({object(1), object(2)}, 1);
+    index.setFull();
+
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_FALSE(index.isFull());
+    EXPECT_FALSE(index.successor(ripple::uint256{1}, 1));
+}
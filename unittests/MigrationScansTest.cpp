@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+
+#include <ripple/protocol/digest.h>
+#include <migration/Scans.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace Migrations;
+using namespace testing;
+
+constexpr static std::uint32_t SEQ = 30;
+
+class MigrationScansTest : public HandlerBaseTest
+{
+protected:
+    // key -> blob, the state map at SEQ
+    std::map<ripple::uint256, Blob> ledger;
+    // sequence -> objects, the diffs of the following ledgers
+    std::map<std::uint32_t, std::vector<LedgerObject>> diffs;
+
+    void
+    SetUp() override
+    {
+        MockBackendTest::SetUp();
+        for (std::uint32_t i = 0; i < 500; ++i)
+            ledger[ripple::sha512Half(i)] = Blob(8, i % 256);
+
+        auto* rawBackendPtr = static_cast<MockBackend*>(mockBackendPtr.get());
+        // the successor table only answers for keys it holds
+        ON_CALL(*rawBackendPtr, doFetchSuccessorKey)
+            .WillByDefault(Invoke(
+                [this](
+                    ripple::uint256 key,
+                    std::uint32_t,
+                    boost::asio::yield_context&)
+                    -> std::optional<ripple::uint256> {
+                    if (key != firstKey && !ledger.contains(key))
+                        return {};
+                    auto const next = ledger.upper_bound(key);
+                    if (next == ledger.end())
+                        return {};
+                    return next->first;
+                }));
+        ON_CALL(*rawBackendPtr, doFetchLedgerObjects)
+            .WillByDefault(Invoke(
+                [this](
+                    std::vector<ripple::uint256> const& keys,
+                    std::uint32_t,
+                    boost::asio::yield_context&) {
+                    std::vector<Blob> blobs;
+                    for (auto const& key : keys)
+                    {
+                        auto const it = ledger.find(key);
+                        blobs.push_back(
+                            it != ledger.end() ? it->second : Blob{});
+                    }
+                    return blobs;
+                }));
+        ON_CALL(*rawBackendPtr, fetchLedgerDiff)
+            .WillByDefault(Invoke(
+                [this](std::uint32_t seq, boost::asio::yield_context&) {
+                    return diffs[seq];
+                }));
+    }
+
+    // Walk every range the way scanLedger does and count how often each key
+    // is handed over
+    std::map<ripple::uint256, int>
+    scan(std::vector<ripple::uint256> const& boundaries)
+    {
+        std::map<ripple::uint256, int> seen;
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            for (std::size_t i = 0; i <= boundaries.size(); ++i)
+            {
+                std::optional<ripple::uint256> cursor;
+                if (i != 0)
+                    cursor = boundaries[i - 1];
+                std::optional<ripple::uint256> end;
+                if (i != boundaries.size())
+                    end = boundaries[i];
+
+                do
+                {
+                    auto page = fetchLedgerRangePage(
+                        *mockBackendPtr, cursor, end, SEQ, 7, yield);
+                    for (auto const& object : page.objects)
+                        ++seen[object.key];
+                    cursor = page.cursor;
+                } while (cursor);
+            }
+        });
+        ctx.run();
+        ctx.restart();
+        return seen;
+    }
+
+    std::vector<ripple::uint256>
+    boundaries(std::size_t numRanges)
+    {
+        std::vector<ripple::uint256> result;
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            result =
+                ledgerScanBoundaries(*mockBackendPtr, SEQ, numRanges, yield);
+        });
+        ctx.run();
+        ctx.restart();
+        return result;
+    }
+};
+
+TEST_F(MigrationScansTest, EveryObjectOnce)
+{
+    std::uint32_t n = 0;
+    for (auto const& [key, blob] : ledger)
+    {
+        if (n++ % 5 == 0)
+            diffs[SEQ + n % 3].push_back({key, Blob(8, 1)});
+    }
+    // created after SEQ, not in the successor table there
+    diffs[SEQ + 1].push_back({ripple::sha512Half(1000u), Blob(8, 1)});
+
+    auto const keys = boundaries(8);
+    ASSERT_EQ(keys.size(), 7);
+    for (auto const& key : keys)
+        EXPECT_TRUE(ledger.contains(key));
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+    auto const seen = scan(keys);
+    EXPECT_EQ(seen.size(), ledger.size());
+    for (auto const& [key, count] : seen)
+    {
+        EXPECT_TRUE(ledger.contains(key));
+        EXPECT_EQ(count, 1);
+    }
+}
+
+TEST_F(MigrationScansTest, FewerKeysThanRanges)
+{
+    auto const first = ledger.begin()->first;
+    auto const last = ledger.rbegin()->first;
+    diffs[SEQ].push_back({first, Blob(8, 1)});
+    diffs[SEQ + 2].push_back({last, Blob(8, 1)});
+
+    auto const keys = boundaries(16);
+    EXPECT_EQ(keys, (std::vector<ripple::uint256>{first, last}));
+
+    auto const seen = scan(keys);
+    EXPECT_EQ(seen.size(), ledger.size());
+    for (auto const& [key, count] : seen)
+        EXPECT_EQ(count, 1);
+}
+
+TEST_F(MigrationScansTest, NoDiffsIsOneRange)
+{
+    EXPECT_TRUE(boundaries(16).empty());
+
+    auto const seen = scan({});
+    EXPECT_EQ(seen.size(), ledger.size());
+    for (auto const& [key, count] : seen)
+        EXPECT_EQ(count, 1);
+}
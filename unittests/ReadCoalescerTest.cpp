@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+
+#include <backend/ReadCoalescer.h>
+
+#include <boost/asio/steady_timer.hpp>
+#include <gtest/gtest.h>
+
+using namespace Backend;
+
+class ReadCoalescerTest : public SyncAsioContextTest
+{
+protected:
+    ReadCoalescer coalescer;
+    int numSingle = 0;
+    int numBulk = 0;
+    std::vector<ripple::uint256> bulkKeys;
+
+    ReadCoalescer::SingleFetcher single =
+        [this](auto const&, auto, auto& yield) -> std::optional<Blob> {
+        ++numSingle;
+        boost::asio::steady_timer timer{ctx, std::chrono::milliseconds(1)};
+        timer.async_wait(yield);
+        return Blob{'b'};
+    };
+
+    ReadCoalescer::BulkFetcher bulk =
+        [this](auto const& keys, auto, auto& yield) {
+        ++numBulk;
+        bulkKeys.insert(bulkKeys.end(), keys.begin(), keys.end());
+        boost::asio::steady_timer timer{ctx, std::chrono::milliseconds(1)};
+        timer.async_wait(yield);
+        return std::vector<Blob>(keys.size(), Blob{'b'});
+    };
+
+    std::optional<Blob>
+    fetch(
+        ripple::uint256 const& key,
+        std::uint32_t sequence,
+        boost::asio::yield_context& yield)
+    {
+        return coalescer.fetch(key, sequence, yield, single, bulk);
+    }
+};
+
+TEST_F(ReadCoalescerTest, SequentialReadsAreNotMerged)
+{
+    boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+        EXPECT_TRUE(fetch(ripple::uint256{1}, 1, yield));
+        EXPECT_TRUE(fetch(ripple::uint256{1}, 1, yield));
+    });
+    ctx.run();
+    EXPECT_EQ(numSingle, 2);
+    EXPECT_EQ(numBulk, 0);
+    EXPECT_EQ(coalescer.numCoalesced(), 0);
+}
+
+TEST_F(ReadCoalescerTest, ConcurrentIdenticalReadsAreMerged)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            auto blob = fetch(ripple::uint256{1}, 1, yield);
+            ASSERT_TRUE(blob);
+            EXPECT_EQ(*blob, Blob{'b'});
+        });
+    }
+    ctx.run();
+    EXPECT_EQ(numSingle, 1);
+    EXPECT_EQ(numBulk, 0);
+    EXPECT_EQ(coalescer.numCoalesced(), 9);
+}
+
+TEST_F(ReadCoalescerTest, ConcurrentReadsAreBatched)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        boost::asio::spawn(ctx, [&, i](boost::asio::yield_context yield) {
+            EXPECT_TRUE(fetch(ripple::uint256(i), 1, yield));
+        });
+    }
+    // a different sequence is a different batch
+    boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+        EXPECT_TRUE(fetch(ripple::uint256{0}, 2, yield));
+    });
+    ctx.run();
+    EXPECT_EQ(numSingle, 1);
+    EXPECT_EQ(numBulk, 1);
+    EXPECT_EQ(bulkKeys.size(), 3);
+    EXPECT_EQ(coalescer.numBatched(), 3);
+}
+
+TEST_F(ReadCoalescerTest, BulkReadJoinsReadsInFlight)
+{
+    boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+        EXPECT_TRUE(fetch(ripple::uint256{1}, 1, yield));
+    });
+    boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+        auto blobs = coalescer.fetch(
+            {ripple::uint256{1}, ripple::uint256{2}}, 1, yield, bulk);
+        EXPECT_EQ(blobs.size(), 2);
+    });
+    ctx.run();
+    EXPECT_EQ(numSingle, 1);
+    EXPECT_EQ(numBulk, 1);
+    ASSERT_EQ(bulkKeys.size(), 1);
+    EXPECT_EQ(bulkKeys[0], ripple::uint256{2});
+}
+
+TEST_F(ReadCoalescerTest, ErrorsArePropagatedToWaiters)
+{
+    single = [](auto const&, auto, auto&) -> std::optional<Blob> {
+        throw DatabaseTimeout{};
+    };
+    int numThrown = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            try
+            {
+                fetch(ripple::uint256{1}, 1, yield);
+            }
+            catch (DatabaseTimeout const&)
+            {
+                ++numThrown;
+            }
+        });
+    }
+    ctx.run();
+    EXPECT_EQ(numThrown, 2);
+}
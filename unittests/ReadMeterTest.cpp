@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+
+#include <backend/ReadMeter.h>
+
+#include <boost/asio/spawn.hpp>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace Backend;
+
+class ReadMeterTest : public SyncAsioContextTest
+{
+};
+
+TEST_F(ReadMeterTest, FoundOnlyWhileInScope)
+{
+    ReadMeter meter;
+    boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+        EXPECT_EQ(ScopedReadMeter::find(yield), nullptr);
+        {
+            ScopedReadMeter scoped{yield, meter};
+            EXPECT_EQ(ScopedReadMeter::find(yield), &meter);
+            // still attributed once the coroutine is resumed
+            boost::asio::post(yield);
+            EXPECT_EQ(ScopedReadMeter::find(yield), &meter);
+        }
+        EXPECT_EQ(ScopedReadMeter::find(yield), nullptr);
+    });
+    ctx.run();
+}
+
+TEST_F(ReadMeterTest, CoroutinesHaveTheirOwnMeter)
+{
+    std::vector<ReadMeter> meters(32);
+    for (auto& meter : meters)
+    {
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            ScopedReadMeter scoped{yield, meter};
+            // let the other coroutines register in between
+            boost::asio::post(yield);
+            EXPECT_EQ(ScopedReadMeter::find(yield), &meter);
+        });
+    }
+    ctx.run();
+}
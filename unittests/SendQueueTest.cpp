@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+
+#include <webserver/SendQueue.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+std::shared_ptr<Message>
+message(std::size_t size)
+{
+    return std::make_shared<Message>(std::string(size, 'x'));
+}
+
+}  // namespace
+
+class SendQueueTest : public LoggerFixture
+{
+protected:
+    util::TagDecoratorFactory tagFactory{clio::Config{}};
+    std::unique_ptr<util::BaseTagDecorator> tag = tagFactory.make();
+
+    SendQueue
+    makeQueue(
+        std::size_t maxMessages,
+        std::size_t maxBytes,
+        SendQueueLimits::Policy policy)
+    {
+        return SendQueue{
+            {maxMessages, maxBytes, policy}, clio::Logger{"General"}, *tag};
+    }
+};
+
+TEST_F(SendQueueTest, DropPolicyDropsPublishedMessages)
+{
+    auto queue = makeQueue(2, 0, SendQueueLimits::Policy::drop);
+    EXPECT_EQ(queue.push(message(3), true), SendQueue::Result::queued);
+    EXPECT_EQ(queue.push(message(4), true), SendQueue::Result::queued);
+    EXPECT_TRUE(queue.full(1));
+
+    EXPECT_EQ(queue.push(message(5), true), SendQueue::Result::dropped);
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.bytes(), 7);
+}
+
+TEST_F(SendQueueTest, DisconnectPolicy)
+{
+    auto queue = makeQueue(1, 0, SendQueueLimits::Policy::disconnect);
+    EXPECT_EQ(queue.push(message(3), true), SendQueue::Result::queued);
+
+    EXPECT_EQ(queue.push(message(4), true), SendQueue::Result::disconnect);
+    EXPECT_EQ(queue.size(), 1);
+    EXPECT_EQ(queue.bytes(), 3);
+    checkEmpty();
+}
+
+TEST_F(SendQueueTest, ResponsesAreAlwaysQueued)
+{
+    for (auto const policy :
+         {SendQueueLimits::Policy::drop, SendQueueLimits::Policy::disconnect})
+    {
+        auto queue = makeQueue(1, 4, policy);
+        EXPECT_EQ(queue.push(message(4), true), SendQueue::Result::queued);
+        EXPECT_TRUE(queue.full(1));
+
+        EXPECT_EQ(queue.push(message(8), false), SendQueue::Result::queued);
+        EXPECT_EQ(queue.push(message(8), false), SendQueue::Result::queued);
+        EXPECT_EQ(queue.size(), 3);
+        EXPECT_EQ(queue.bytes(), 20);
+    }
+}
+
+TEST_F(SendQueueTest, ByteLimit)
+{
+    auto queue = makeQueue(0, 10, SendQueueLimits::Policy::drop);
+    EXPECT_EQ(queue.push(message(6), true), SendQueue::Result::queued);
+    EXPECT_FALSE(queue.full(4));
+    EXPECT_TRUE(queue.full(5));
+
+    EXPECT_EQ(queue.push(message(5), true), SendQueue::Result::dropped);
+    EXPECT_EQ(queue.push(message(4), true), SendQueue::Result::queued);
+    EXPECT_EQ(queue.bytes(), 10);
+}
+
+TEST_F(SendQueueTest, PopReleasesBytes)
+{
+    auto queue = makeQueue(0, 10, SendQueueLimits::Policy::drop);
+    EXPECT_EQ(queue.push(message(6), true), SendQueue::Result::queued);
+    EXPECT_EQ(queue.push(message(4), true), SendQueue::Result::queued);
+    EXPECT_TRUE(queue.full(1));
+
+    queue.pop();
+    EXPECT_EQ(queue.size(), 1);
+    EXPECT_EQ(queue.bytes(), 4);
+    EXPECT_EQ(queue.front().size(), 4);
+    EXPECT_FALSE(queue.full(6));
+
+    queue.pop();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.bytes(), 0);
+}
+
+TEST_F(SendQueueTest, LogsEachDropEpisodeOnce)
+{
+    auto queue = makeQueue(2, 0, SendQueueLimits::Policy::drop);
+    queue.push(message(3), true);
+    queue.push(message(4), true);
+    checkEmpty();
+
+    EXPECT_EQ(queue.push(message(5), true), SendQueue::Result::dropped);
+    checkEqual(
+        "General:WRN Send queue full with 2 messages, 7 bytes. Dropping "
+        "published messages");
+    EXPECT_EQ(queue.push(message(5), true), SendQueue::Result::dropped);
+    EXPECT_EQ(queue.push(message(5), true), SendQueue::Result::dropped);
+    checkEmpty();
+
+    // responses do not end the episode
+    queue.pop();
+    queue.pop();
+    EXPECT_EQ(queue.push(message(1), false), SendQueue::Result::queued);
+    checkEmpty();
+
+    EXPECT_EQ(queue.push(message(1), true), SendQueue::Result::queued);
+    checkEqual(
+        "General:WRN Send queue has room again after 3 published messages "
+        "were dropped");
+    EXPECT_EQ(queue.push(message(1), true), SendQueue::Result::dropped);
+    checkEqual(
+        "General:WRN Send queue full with 2 messages, 2 bytes. Dropping "
+        "published messages");
+}
@@ -69,6 +69,28 @@ TEST(SubscriptionManagerTest, InitAndReport)
     EXPECT_EQ(subManager->report(), json::parse(ReportReturn));
 }
 
+TEST(SubscriptionManagerTest, SendQueueLimits)
+{
+    auto limits = SendQueueLimits::make(clio::Config{});
+    EXPECT_EQ(limits.policy, SendQueueLimits::Policy::disconnect);
+
+    limits = SendQueueLimits::make(clio::Config{json::parse(R"({
+        "subscription_send_queue": {
+            "max_messages": 0,
+            "max_bytes": 1024,
+            "policy": "drop"
+        }
+    })")});
+    EXPECT_EQ(limits.maxMessages, 0);
+    EXPECT_EQ(limits.maxBytes, 1024);
+    EXPECT_EQ(limits.policy, SendQueueLimits::Policy::drop);
+
+    EXPECT_THROW(
+        SendQueueLimits::make(clio::Config{json::parse(
+            R"({"subscription_send_queue": {"policy": "block"}})")}),
+        std::runtime_error);
+}
+
 void
 CheckSubscriberMessage(
     std::string out,
@@ -443,6 +465,38 @@ TEST_F(SubscriptionManagerSimpleBackendTest, SubscriptionManagerTransaction)
     CheckSubscriberMessage(TransactionPublish, session);
 }
 
+constexpr static auto TransactionForOwnerFund = R"({
+    "transaction":{
+        "Account":"rf1BiGeXwwQoi8Z2ueFYTEXSwuJYfV2Jpn",
+        "Fee":"1",
+        "Sequence":32,
+        "SigningPubKey":"74657374",
+        "TakerGets":{
+            "currency":"0158415500000000C1F76FF6ECB0BAC600000000",
+            "issuer":"rK9DrarGKnVEo2nYp5MfVRXRYf5yRX3mwD",
+            "value":"1"
+        },
+        "TakerPays":"3",
+        "TransactionType":"OfferCreate",
+        "hash":"EE8775B43A67F4803DECEC5E918E0EA9C56D8ED93E512EBE9F2891846509AAAB",
+        "date":0,
+        "owner_funds":"100"
+    },
+    "meta":{
+        "AffectedNodes":[],
+        "TransactionIndex":22,
+        "TransactionResult":"tesSUCCESS"
+    },
+    "type":"transaction",
+    "validated":true,
+    "status":"closed",
+    "ledger_index":33,
+    "ledger_hash":"1B8590C01B0006EDFA9ED60296DD052DC5E90F99659B25014D08E1BC983515BC",
+    "engine_result_code":0,
+    "engine_result":"tesSUCCESS",
+    "engine_result_message":"The transaction was applied. Only final in a validated ledger."
+})";
+
 /*
  * test transaction for offer creation
  * check owner_funds
@@ -482,40 +536,138 @@ TEST_F(
     ON_CALL(*rawBackendPtr, doFetchLedgerObject)
         .WillByDefault(Return(line.getSerializer().peekData()));
     subManagerPtr->pubTransaction(trans1, ledgerinfo);
-    constexpr static auto TransactionForOwnerFund = R"({
-        "transaction":{
-            "Account":"rf1BiGeXwwQoi8Z2ueFYTEXSwuJYfV2Jpn",
-            "Fee":"1",
-            "Sequence":32,
-            "SigningPubKey":"74657374",
-            "TakerGets":{
-                "currency":"0158415500000000C1F76FF6ECB0BAC600000000",
-                "issuer":"rK9DrarGKnVEo2nYp5MfVRXRYf5yRX3mwD",
-                "value":"1"
-            },
-            "TakerPays":"3",
-            "TransactionType":"OfferCreate",
-            "hash":"EE8775B43A67F4803DECEC5E918E0EA9C56D8ED93E512EBE9F2891846509AAAB",
-            "date":0,
-            "owner_funds":"100"
-        },
-        "meta":{
-            "AffectedNodes":[],
-            "TransactionIndex":22,
-            "TransactionResult":"tesSUCCESS"
-        },
-        "type":"transaction",
-        "validated":true,
-        "status":"closed",
-        "ledger_index":33,
-        "ledger_hash":"1B8590C01B0006EDFA9ED60296DD052DC5E90F99659B25014D08E1BC983515BC",
-        "engine_result_code":0,
-        "engine_result":"tesSUCCESS",
-        "engine_result_message":"The transaction was applied. Only final in a validated ledger."
-    })";
     CheckSubscriberMessage(TransactionForOwnerFund, session);
 }
 
+/*
+ * owner_funds of a ledger's offers are read once per owner and asset before
+ * publishing, and not again while publishing
+ */
+TEST_F(
+    SubscriptionManagerSimpleBackendTest,
+    SubscriptionManagerTransactionOwnerFundsPrefetch)
+{
+    subManagerPtr->subTransactions(session);
+
+    auto ledgerinfo = CreateLedgerInfo(LEDGERHASH2, 33);
+    auto trans1 = TransactionAndMetadata();
+    ripple::STObject obj = CreateCreateOfferTransactionObject(
+        ACCOUNT1, 1, 32, CURRENCY, ISSUER, 1, 3);
+    trans1.transaction = obj.getSerializer().peekData();
+    trans1.ledgerSequence = 32;
+    ripple::STArray metaArray{0};
+    ripple::STObject metaObj(ripple::sfTransactionMetaData);
+    metaObj.setFieldArray(ripple::sfAffectedNodes, metaArray);
+    metaObj.setFieldU8(ripple::sfTransactionResult, ripple::tesSUCCESS);
+    metaObj.setFieldU32(ripple::sfTransactionIndex, 22);
+    trans1.metadata = metaObj.getSerializer().peekData();
+
+    ripple::STObject line(ripple::sfIndexes);
+    line.setFieldU16(ripple::sfLedgerEntryType, ripple::ltRIPPLE_STATE);
+    line.setFieldAmount(ripple::sfLowLimit, ripple::STAmount(10, false));
+    line.setFieldAmount(ripple::sfHighLimit, ripple::STAmount(100, false));
+    line.setFieldH256(ripple::sfPreviousTxnID, ripple::uint256{TXNID});
+    line.setFieldU32(ripple::sfPreviousTxnLgrSeq, 3);
+    line.setFieldU32(ripple::sfFlags, 0);
+    auto issue2 = GetIssue(CURRENCY, ISSUER);
+    line.setFieldAmount(ripple::sfBalance, ripple::STAmount(issue2, 100));
+    MockBackend* rawBackendPtr =
+        static_cast<MockBackend*>(mockBackendPtr.get());
+    EXPECT_CALL(*rawBackendPtr, doFetchLedgerObject).Times(3);
+    ON_CALL(*rawBackendPtr, doFetchLedgerObject)
+        .WillByDefault(Return(line.getSerializer().peekData()));
+
+    std::vector<TransactionAndMetadata> transactions{trans1, trans1};
+    auto const ownerFunds =
+        subManagerPtr->fetchOwnerFunds(transactions, ledgerinfo.seq);
+    ASSERT_EQ(ownerFunds.size(), 1);
+    EXPECT_EQ(ownerFunds.begin()->second.getText(), "100");
+
+    subManagerPtr->pubTransaction(trans1, ledgerinfo, ownerFunds);
+    CheckSubscriberMessage(TransactionForOwnerFund, session);
+}
+
+/*
+ * nothing is built or read for a ledger's transactions when no one is
+ * subscribed to them
+ */
+TEST_F(
+    SubscriptionManagerSimpleBackendTest,
+    SubscriptionManagerLedgerTransactionsWithoutSubscribers)
+{
+    auto ledgerinfo = CreateLedgerInfo(LEDGERHASH2, 33);
+    auto trans1 = TransactionAndMetadata();
+    ripple::STObject obj = CreateCreateOfferTransactionObject(
+        ACCOUNT1, 1, 32, CURRENCY, ISSUER, 1, 3);
+    trans1.transaction = obj.getSerializer().peekData();
+    trans1.ledgerSequence = 32;
+    ripple::STArray metaArray{0};
+    ripple::STObject metaObj(ripple::sfTransactionMetaData);
+    metaObj.setFieldArray(ripple::sfAffectedNodes, metaArray);
+    metaObj.setFieldU8(ripple::sfTransactionResult, ripple::tesSUCCESS);
+    metaObj.setFieldU32(ripple::sfTransactionIndex, 22);
+    trans1.metadata = metaObj.getSerializer().peekData();
+
+    MockBackend* rawBackendPtr =
+        static_cast<MockBackend*>(mockBackendPtr.get());
+    EXPECT_CALL(*rawBackendPtr, doFetchLedgerObject).Times(0);
+    subManagerPtr->pubLedgerTransactions(ledgerinfo, {trans1, trans1});
+}
+
+/*
+ * transactions of a ledger are formatted concurrently but published in
+ * TransactionIndex order
+ */
+TEST_F(
+    SubscriptionManagerSimpleBackendTest,
+    SubscriptionManagerLedgerTransactionsInIndexOrder)
+{
+    clio::Config workersCfg{json::parse(R"({"subscription_workers": 4})")};
+    auto subManager = SubscriptionManager::make_SubscriptionManager(
+        workersCfg, mockBackendPtr);
+    subManager->subTransactions(session);
+
+    auto ledgerinfo = CreateLedgerInfo(LEDGERHASH2, 33);
+    std::vector<std::uint32_t> const indexes = {5, 2, 7, 0, 3, 6, 1, 4};
+    std::vector<TransactionAndMetadata> transactions;
+    for (auto const index : indexes)
+    {
+        auto trans = TransactionAndMetadata();
+        ripple::STObject obj =
+            CreatePaymentTransactionObject(ACCOUNT1, ACCOUNT2, 1, 1, index);
+        trans.transaction = obj.getSerializer().peekData();
+        trans.ledgerSequence = 33;
+        ripple::STArray metaArray{0};
+        ripple::STObject metaObj(ripple::sfTransactionMetaData);
+        metaObj.setFieldArray(ripple::sfAffectedNodes, metaArray);
+        metaObj.setFieldU8(ripple::sfTransactionResult, ripple::tesSUCCESS);
+        metaObj.setFieldU32(ripple::sfTransactionIndex, index);
+        trans.metadata = metaObj.getSerializer().peekData();
+        transactions.push_back(std::move(trans));
+    }
+    subManager->pubLedgerTransactions(ledgerinfo, transactions);
+
+    // the session receives every message concatenated
+    auto const sessionPtr = static_cast<MockSession*>(session.get());
+    constexpr static std::string_view field = R"("TransactionIndex":)";
+    std::vector<std::uint32_t> received;
+    for (int retry = 0; retry < 50 && received.size() < indexes.size();
+         ++retry)
+    {
+        std::this_thread::sleep_for(20ms);
+        received.clear();
+        auto const message = sessionPtr->message;
+        for (auto pos = message.find(field); pos != std::string::npos;
+             pos = message.find(field, pos + 1))
+        {
+            received.push_back(
+                std::stoul(message.substr(pos + field.size())));
+        }
+    }
+    EXPECT_EQ(
+        received, (std::vector<std::uint32_t>{0, 1, 2, 3, 4, 5, 6, 7}));
+}
+
 constexpr static auto TransactionForOwnerFundFrozen = R"({
     "transaction":{
         "Account":"rf1BiGeXwwQoi8Z2ueFYTEXSwuJYfV2Jpn",
@@ -216,3 +216,28 @@ TEST_F(SubscriptionMapTest, SubscriptionMapDeadRemoveSubscriber)
     ctx.run();
     EXPECT_EQ(subMap.count(), 1);
 }
+
+TEST_F(SubscriptionMapTest, SubscriptionMapInterest)
+{
+    std::shared_ptr<WsBase> session1 =
+        std::make_shared<MockSession>(tagDecoratorFactory);
+    SubscriptionMap<std::string> subMap(ctx);
+    const std::string topic1 = "topic1";
+    const std::string topic2 = "topic2";
+    subMap.subscribe(session1, topic1);
+    // interest is visible before the subscription runs on the strand
+    EXPECT_TRUE(subMap.interested(topic1));
+    EXPECT_FALSE(subMap.interested(topic2));
+    ctx.run();
+
+    subMap.publish(std::make_shared<Message>("message"), topic1);
+    subMap.publish(std::make_shared<Message>("message"), topic2);
+    EXPECT_EQ(
+        subMap.publishReport(),
+        json::parse(R"({"matched":1,"unmatched":1})"));
+
+    subMap.unsubscribe(session1, topic1);
+    ctx.restart();
+    ctx.run();
+    EXPECT_FALSE(subMap.interested(topic1));
+}
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <backend/WriteBatch.h>
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+using namespace Backend;
+
+namespace {
+
+using Row = std::pair<int, int>;
+
+auto const partition = [](Row const& row) { return row.first; };
+auto const size = [](Row const&) { return 10; };
+
+}  // namespace
+
+TEST(WriteBatchTest, GroupsRowsByPartition)
+{
+    auto batches = makeBatches(
+        std::vector<Row>{{2, 0}, {1, 0}, {2, 1}, {1, 1}, {3, 0}},
+        partition,
+        size,
+        BatchLimits{});
+
+    ASSERT_EQ(batches.size(), 3);
+    EXPECT_EQ(batches[0], (std::vector<Row>{{1, 0}, {1, 1}}));
+    EXPECT_EQ(batches[1], (std::vector<Row>{{2, 0}, {2, 1}}));
+    EXPECT_EQ(batches[2], (std::vector<Row>{{3, 0}}));
+}
+
+TEST(WriteBatchTest, SplitsOnStatementAndByteCaps)
+{
+    std::vector<Row> rows;
+    for (int i = 0; i < 5; ++i)
+        rows.emplace_back(1, i);
+
+    auto copy = rows;
+    auto batches =
+        makeBatches(std::move(copy), partition, size, BatchLimits{2, 1000});
+    ASSERT_EQ(batches.size(), 3);
+    EXPECT_EQ(batches[2], (std::vector<Row>{{1, 4}}));
+
+    batches =
+        makeBatches(std::move(rows), partition, size, BatchLimits{64, 35});
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(batches[0].size(), 3);
+    EXPECT_EQ(batches[1].size(), 2);
+}
+
+TEST(WriteBatchTest, Distribution)
+{
+    WriteBatchStats stats;
+    stats.record(1);
+    stats.record(3);
+    stats.record(64);
+    stats.record(500);
+
+    EXPECT_EQ(stats.numBatches(), 4);
+    EXPECT_EQ(stats.numRows(), 568);
+
+    auto const json = stats.toJson();
+    auto const& distribution = json.at("distribution").as_object();
+    EXPECT_EQ(distribution.at("1").as_uint64(), 1);
+    EXPECT_EQ(distribution.at("2-3").as_uint64(), 1);
+    EXPECT_EQ(distribution.at("4-7").as_uint64(), 0);
+    EXPECT_EQ(distribution.at("64-127").as_uint64(), 1);
+    EXPECT_EQ(distribution.at("128+").as_uint64(), 1);
+}
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <util/Fixtures.h>
+
+#include <rpc/RPC.h>
+#include <rpc/WorkQueue.h>
+
+#include <boost/json/parse.hpp>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <future>
+
+namespace json = boost::json;
+
+class WorkQueueTest : public NoLoggerFixture
+{
+};
+
+TEST_F(WorkQueueTest, LookupsDoNotWaitBehindScans)
+{
+    WorkQueue queue{4};
+
+    // keep every scan thread busy
+    std::promise<void> release;
+    auto const released = release.get_future().share();
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.postCoro(
+            [released](boost::asio::yield_context) { released.wait(); },
+            false,
+            WorkQueue::Lane::scan));
+    }
+
+    std::promise<void> lookup;
+    ASSERT_TRUE(queue.postCoro(
+        [&](boost::asio::yield_context) { lookup.set_value(); }, false));
+    std::promise<void> whitelisted;
+    ASSERT_TRUE(queue.postCoro(
+        [&](boost::asio::yield_context) { whitelisted.set_value(); },
+        true,
+        WorkQueue::Lane::scan));
+
+    EXPECT_EQ(
+        lookup.get_future().wait_for(std::chrono::seconds(5)),
+        std::future_status::ready);
+    EXPECT_EQ(
+        whitelisted.get_future().wait_for(std::chrono::seconds(5)),
+        std::future_status::ready);
+    release.set_value();
+
+    auto const report = queue.report();
+    auto const& lanes = report.at("lanes").as_object();
+    EXPECT_EQ(lanes.at("lookup").at("queued").as_uint64(), 1u);
+    EXPECT_EQ(lanes.at("priority").at("queued").as_uint64(), 1u);
+}
+
+TEST_F(WorkQueueTest, IdleLookupThreadsRunScans)
+{
+    // one scan thread and two lookup threads
+    WorkQueue queue{4};
+
+    std::promise<void> release;
+    auto const released = release.get_future().share();
+    std::array<std::promise<void>, 2> started;
+    for (auto& promise : started)
+    {
+        ASSERT_TRUE(queue.postCoro(
+            [&promise, released](boost::asio::yield_context) {
+                promise.set_value();
+                released.wait();
+            },
+            false,
+            WorkQueue::Lane::scan));
+    }
+
+    for (auto& promise : started)
+    {
+        EXPECT_EQ(
+            promise.get_future().wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+    }
+    release.set_value();
+}
+
+TEST_F(WorkQueueTest, RejectsWhenFull)
+{
+    WorkQueue queue{4, 1};
+
+    std::promise<void> release;
+    auto const released = release.get_future().share();
+    ASSERT_TRUE(queue.postCoro(
+        [released](boost::asio::yield_context) { released.wait(); }, false));
+    EXPECT_FALSE(queue.postCoro([](boost::asio::yield_context) {}, false));
+    // whitelisted clients are never rejected
+    EXPECT_TRUE(queue.postCoro([](boost::asio::yield_context) {}, true));
+    // neither are admitted jobs moving to another lane
+    std::promise<void> reposted;
+    queue.repostCoro(
+        [&](boost::asio::yield_context) { reposted.set_value(); },
+        WorkQueue::Lane::scan);
+    EXPECT_EQ(
+        reposted.get_future().wait_for(std::chrono::seconds(5)),
+        std::future_status::ready);
+    release.set_value();
+}
+
+TEST_F(WorkQueueTest, LaneOfRequest)
+{
+    auto const laneOf = [](char const* request) {
+        return RPC::laneFor(json::parse(request).as_object());
+    };
+
+    EXPECT_EQ(
+        laneOf(R"({"method": "tx", "params": [{}]})"),
+        WorkQueue::Lane::lookup);
+    EXPECT_EQ(
+        laneOf(R"({"method": "ledger_data", "params": [{}]})"),
+        WorkQueue::Lane::scan);
+    EXPECT_EQ(laneOf(R"({"command": "book_offers"})"), WorkQueue::Lane::scan);
+    EXPECT_EQ(laneOf(R"({"command": "ledger"})"), WorkQueue::Lane::lookup);
+    EXPECT_EQ(
+        laneOf(R"({"command": "ledger", "transactions": true})"),
+        WorkQueue::Lane::scan);
+    EXPECT_EQ(
+        laneOf(R"({"method": "ledger", "params": [{"full": true}]})"),
+        WorkQueue::Lane::scan);
+    EXPECT_EQ(laneOf(R"({"params": [{}]})"), WorkQueue::Lane::lookup);
+}
@@ -833,7 +833,8 @@ TEST_F(RPCAccountHandlerTest, MarkerInput)
     ON_CALL(
         *rawBackendPtr, doFetchLedgerObject(accountKk, testing::_, testing::_))
         .WillByDefault(Return(fake));
-    EXPECT_CALL(*rawBackendPtr, doFetchLedgerObject).Times(3);
+    // account, then the hint page which is not read again when walking
+    EXPECT_CALL(*rawBackendPtr, doFetchLedgerObject).Times(2);
 
     std::vector<Blob> bbs;
     ripple::STObject channel1 = CreatePaymentChannelLedgerObject(
@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of clio: https://github.com/XRPLF/clio
+    Copyright (c) 2022, the clio developers.
+
+    Permission to use, copy, modify, and distribute this software for any
+    purpose with or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL,  DIRECT,  INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <rpc/Handlers.h>
+#include <rpc/RPC.h>
+#include <util/Fixtures.h>
+
+namespace json = boost::json;
+using namespace testing;
+
+constexpr static auto ACCOUNT = "rf1BiGeXwwQoi8Z2ueFYTEXSwuJYfV2Jpn";
+constexpr static auto MINSEQ = 10;
+constexpr static auto MAXSEQ = 30;
+
+class RPCAccountTxTest : public HandlerBaseTest
+{
+protected:
+    clio::Config cfg;
+    util::TagDecoratorFactory tagFactory{cfg};
+    WorkQueue queue{1};
+    RPC::Counters counters{queue};
+    Backend::LedgerRange range{MINSEQ, MAXSEQ};
+    std::shared_ptr<SubscriptionManager> subscriptions;
+    std::shared_ptr<ETLLoadBalancer> balancer;
+    std::shared_ptr<ReportingETL const> etl;
+
+    RPC::Result
+    accountTx(json::object const& params)
+    {
+        RPC::Result result;
+        boost::asio::spawn(ctx, [&](boost::asio::yield_context yield) {
+            std::shared_ptr<BackendInterface const> const backend =
+                mockBackendPtr;
+            RPC::Context context{
+                yield,
+                "account_tx",
+                1,
+                params,
+                backend,
+                subscriptions,
+                balancer,
+                etl,
+                nullptr,
+                tagFactory,
+                range,
+                counters,
+                "127.0.0.1"};
+            result = RPC::doAccountTx(context);
+        });
+        ctx.run();
+        return result;
+    }
+};
+
+TEST_F(RPCAccountTxTest, MinBelowRangeWithoutHistory)
+{
+    auto const rawBackendPtr = static_cast<MockBackend*>(mockBackendPtr.get());
+    ON_CALL(*rawBackendPtr, fetchTransactionHistoryStart)
+        .WillByDefault(Return(std::optional<std::uint32_t>{}));
+    EXPECT_CALL(*rawBackendPtr, fetchAccountTransactions).Times(0);
+
+    auto const result =
+        accountTx({{"account", ACCOUNT}, {"ledger_index_min", MINSEQ - 5}});
+    auto const status = std::get_if<RPC::Status>(&result);
+    ASSERT_NE(status, nullptr);
+    EXPECT_EQ(status->message, "ledgerSeqMinOutOfRange");
+}
+
+TEST_F(RPCAccountTxTest, ServesBackfilledHistory)
+{
+    auto const rawBackendPtr = static_cast<MockBackend*>(mockBackendPtr.get());
+    ON_CALL(*rawBackendPtr, fetchTransactionHistoryStart)
+        .WillByDefault(Return(std::optional<std::uint32_t>{MINSEQ - 5}));
+    // newest first, the oldest ledger is below the history start
+    Backend::TransactionsAndCursor page;
+    for (auto const seq : {MINSEQ + 1, MINSEQ - 2, MINSEQ - 6})
+        page.txns.push_back({{0x01}, {0x02}, static_cast<uint32_t>(seq), 0});
+    ON_CALL(*rawBackendPtr, fetchAccountTransactions)
+        .WillByDefault(Return(page));
+    EXPECT_CALL(*rawBackendPtr, fetchAccountTransactions).Times(1);
+
+    auto const result = accountTx(
+        {{"account", ACCOUNT},
+         {"binary", true},
+         {"ledger_index_min", MINSEQ - 5}});
+    auto const response = std::get_if<json::object>(&result);
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(response->at("ledger_index_min").as_uint64(), MINSEQ - 5);
+    auto const& txns = response->at("transactions").as_array();
+    ASSERT_EQ(txns.size(), 2);
+    EXPECT_EQ(txns[1].at("ledger_index").as_uint64(), MINSEQ - 2);
+}
+
+TEST_F(RPCAccountTxTest, DefaultMinIsHistoryStart)
+{
+    auto const rawBackendPtr = static_cast<MockBackend*>(mockBackendPtr.get());
+    ON_CALL(*rawBackendPtr, fetchTransactionHistoryStart)
+        .WillByDefault(Return(std::optional<std::uint32_t>{MINSEQ - 5}));
+    ON_CALL(*rawBackendPtr, fetchAccountTransactions)
+        .WillByDefault(Return(Backend::TransactionsAndCursor{}));
+    EXPECT_CALL(*rawBackendPtr, fetchAccountTransactions).Times(1);
+
+    auto const result = accountTx({{"account", ACCOUNT}});
+    auto const response = std::get_if<json::object>(&result);
+    ASSERT_NE(response, nullptr);
+    EXPECT_EQ(response->at("ledger_index_min").as_uint64(), MINSEQ - 5);
+    EXPECT_EQ(response->at("ledger_index_max").as_uint64(), MAXSEQ);
+}
@@ -137,6 +137,18 @@ public:
         (boost::asio::yield_context & yield),
         (const, override));
 
+    MOCK_METHOD(
+        std::optional<std::uint32_t>,
+        fetchTransactionHistoryStart,
+        (boost::asio::yield_context & yield),
+        (const, override));
+
+    MOCK_METHOD(
+        void,
+        writeTransactionHistoryStart,
+        (std::uint32_t const sequence),
+        (override));
+
     MOCK_METHOD(
         void,
         writeLedger,
@@ -181,6 +193,10 @@ public:
 
     MOCK_METHOD(void, startWrites, (), (const, override));
 
+    MOCK_METHOD(void, sync, (), (const, override));
+
+    MOCK_METHOD(void, syncThreadWrites, (), (const, override));
+
     MOCK_METHOD(
         bool,
         doOnlineDelete,